@@ -44,8 +44,30 @@
 #include "Hbgs_param.h"
 #include "Lowmc64.h"
 #include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_binary.h"
+#include "Hb_epid_rl_text.h"
 
 template<> const std::string Epid_rl_entry<Sigrl>::list_name{ "sigRL" };
 
 template<> const std::string Epid_list_entry<Rla>::list_name{ "RL_a" };
 template<> const std::string Epid_list_entry<Rlk>::list_name{ "keyRL" };
+
+bool write_rl_file(std::string const &filename, Rl_file_format format,
+  std::string const &list_name, size_t n_states, uint8_t const *records,
+  size_t n_entries) noexcept
+{
+    size_t record_bytes = n_states * lowmc_state_words64_bytes;
+    if (format == Rl_file_format::text) {
+        return write_rl_text(
+          filename, list_name, n_states, record_bytes, records, n_entries);
+    }
+
+    Rl_binary_type type = Rl_binary_type::sigrl;
+    if (list_name == Epid_arl_entry::list_name) {
+        type = Rl_binary_type::rl_a;
+    } else if (list_name == Epid_keyRL_entry::list_name) {
+        type = Rl_binary_type::keyrl;
+    }
+    return write_rl_binary(
+      filename, type, n_states, record_bytes, records, n_entries);
+}
@@ -0,0 +1,286 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_binary.cpp
+ * Description: A binary, memory mappable, file format for the revocation
+ *              lists
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+}
+#include "Io_utils.h"
+#include "Hb_epid_rl_binary.h"
+
+namespace {
+constexpr uint8_t rl_magic[8] = { 'H', 'B', 'G', 'S', '-', 'R', 'L', 0 };
+}// namespace
+
+void encode_rl_binary_header(
+  uint8_t *out, Rl_binary_header const &header) noexcept
+{
+    std::memset(out, 0, rl_binary_header_bytes);
+    std::memcpy(out, rl_magic, sizeof(rl_magic));
+    rl_put_le(out + 8, header.version_, 2);
+    out[10] = static_cast<uint8_t>(header.type_);
+    out[11] = header.n_states_;
+    rl_put_le(out + 12, header.state_bits_, 2);
+    rl_put_le(out + 14, header.record_bytes_, 2);
+    rl_put_le(out + 16, header.n_entries_, 8);
+    rl_put_le(out + 24, header.records_offset_, 8);
+    std::memcpy(out + 32, header.digest_, rl_digest_bytes);
+}
+
+bool decode_rl_binary_header(
+  Rl_binary_header &header, uint8_t const *in, size_t len) noexcept
+{
+    if (len < rl_binary_header_bytes
+        || std::memcmp(in, rl_magic, sizeof(rl_magic)) != 0) {
+        return false;
+    }
+    header.version_ = static_cast<uint16_t>(rl_get_le(in + 8, 2));
+    if (header.version_ != rl_binary_version) {
+        std::cerr << "Unsupported binary list version " << header.version_
+                  << '\n';
+        return false;
+    }
+    header.type_ = static_cast<Rl_binary_type>(in[10]);
+    header.n_states_ = in[11];
+    header.state_bits_ = static_cast<uint16_t>(rl_get_le(in + 12, 2));
+    header.record_bytes_ = static_cast<uint16_t>(rl_get_le(in + 14, 2));
+    header.n_entries_ = rl_get_le(in + 16, 8);
+    header.records_offset_ = rl_get_le(in + 24, 8);
+    std::memcpy(header.digest_, in + 32, rl_digest_bytes);
+    return true;
+}
+
+bool check_rl_binary(Rl_binary_header const &header, Rl_binary_type type,
+  size_t n_states, size_t record_bytes, uint8_t const *file,
+  size_t file_bytes, bool check_digest) noexcept
+{
+    if (header.type_ != type || header.n_states_ != n_states
+        || header.record_bytes_ != record_bytes) {
+        std::cerr << "The binary list holds a different kind of list\n";
+        return false;
+    }
+    if (header.state_bits_ != Mpc_parameters::lowmc_state_bits_) {
+        std::cerr << "The binary list is for n = " << header.state_bits_
+                  << ", not n = " << Mpc_parameters::lowmc_state_bits_ << '\n';
+        return false;
+    }
+    // The records are read in place, so they must be aligned for the states
+    if (header.records_offset_ < rl_binary_header_bytes
+        || header.records_offset_ % alignof(Word) != 0
+        || header.records_offset_ > file_bytes
+        || header.n_entries_
+             > (file_bytes - header.records_offset_) / record_bytes) {
+        std::cerr << "The binary list is truncated or has a bad offset\n";
+        return false;
+    }
+    if (check_digest) {
+        uint8_t digest[rl_digest_bytes];
+        rl_content_digest(digest, file + header.records_offset_,
+          static_cast<size_t>(header.n_entries_) * record_bytes);
+        if (std::memcmp(digest, header.digest_, rl_digest_bytes) != 0) {
+            std::cerr << "The binary list does not match its digest\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool write_rl_binary(std::string const &filename, Rl_binary_type type,
+  size_t n_states, size_t record_bytes, uint8_t const *records,
+  size_t n_entries) noexcept
+{
+    Rl_binary_header header;
+    header.type_ = type;
+    header.n_states_ = static_cast<uint8_t>(n_states);
+    header.record_bytes_ = static_cast<uint16_t>(record_bytes);
+    header.n_entries_ = n_entries;
+    rl_content_digest(header.digest_, records, n_entries * record_bytes);
+    uint8_t encoded[rl_binary_header_bytes];
+    encode_rl_binary_header(encoded, header);
+
+    Rl_file_writer writer;
+    if (!writer.open(filename)) { return false; }
+    // The records are written from where they are, without a copy
+    return writer.write(encoded, sizeof(encoded))
+           && writer.write(records, n_entries * record_bytes) && writer.commit();
+}
+
+bool Rl_file_writer::open(std::string const &filename) noexcept
+{
+    abort();
+    filename_ = filename;
+    // Created as any new file would be, so that the umask applies, rather
+    // than with mkstemp's owner only mode. The process id and a count make
+    // the name unique, one left behind by a process that crashed is skipped.
+    static std::atomic<unsigned> n_temp_files{ 0 };
+    for (int attempt = 0; attempt < 100 && fd_ < 0; ++attempt) {
+        temp_filename_ = filename + '.' + std::to_string(getpid()) + '.'
+                         + std::to_string(n_temp_files++);
+        fd_ = ::open(temp_filename_.c_str(),
+          O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd_ < 0 && errno != EEXIST) { break; }
+    }
+    if (fd_ < 0) {
+        std::cerr << "Unable to create a temporary file for " << filename
+                  << '\n';
+        return false;
+    }
+    // A file that is replaced keeps its mode
+    struct stat st;
+    if (stat(filename.c_str(), &st) == 0) {
+        if (fchmod(fd_, st.st_mode & 07777) != 0) {
+            std::cerr << "Unable to set the mode of " << temp_filename_
+                      << '\n';
+            abort();
+            return false;
+        }
+    } else if (errno != ENOENT) {
+        std::cerr << "Unable to read the mode of " << filename << '\n';
+        abort();
+        return false;
+    }
+    return true;
+}
+
+bool Rl_file_writer::write(void const *data, size_t len) noexcept
+{
+    if (fd_ < 0) { return false; }
+    auto const *p = static_cast<uint8_t const *>(data);
+    while (len > 0) {
+        ssize_t n = ::write(fd_, p, len);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) {
+            std::cerr << "Failed to write the file " << filename_ << '\n';
+            abort();
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool Rl_file_writer::commit() noexcept
+{
+    if (fd_ < 0) { return false; }
+    bool ok = fsync(fd_) == 0;
+    ok = (::close(fd_) == 0) && ok;
+    fd_ = -1;
+    if (!ok || rename(temp_filename_.c_str(), filename_.c_str()) != 0) {
+        std::cerr << "Failed to write the file " << filename_ << '\n';
+        unlink(temp_filename_.c_str());
+        return false;
+    }
+    // Make the rename itself durable
+    std::string::size_type sep = filename_.rfind(dirSep);
+    std::string dir =
+      (sep == std::string::npos) ? std::string(".") : filename_.substr(0, sep + 1);
+    int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+void Rl_file_writer::abort() noexcept
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+        unlink(temp_filename_.c_str());
+        fd_ = -1;
+    }
+}
+
+bool Rl_file_mapping::map(std::string const &filename) noexcept
+{
+    unmap();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Unable to open the file " << filename << '\n';
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        std::cerr << "Unable to read the file " << filename << '\n';
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);// The mapping keeps the file open
+    if (map == MAP_FAILED) {
+        std::cerr << "Unable to map the file " << filename << '\n';
+        return false;
+    }
+    // The records are read in order
+    madvise(map, size, MADV_SEQUENTIAL);
+    data_ = static_cast<uint8_t const *>(map);
+    size_ = size;
+    return true;
+}
+
+void Rl_file_mapping::advise_reuse() const noexcept
+{
+    if (data_ != nullptr) {
+        madvise(const_cast<uint8_t *>(data_), size_, MADV_NORMAL);
+    }
+}
+
+void Rl_file_mapping::unmap() noexcept
+{
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
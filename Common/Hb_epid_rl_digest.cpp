@@ -0,0 +1,200 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_digest.cpp
+ * Description: The content digest of a revocation list, a tree hash over blocks
+ *              of its entries
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <algorithm>
+#include <iomanip>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+#include "kdf_shake.h"
+}
+#include "Mpc_thread_pool.h"
+#include "Hb_epid_rl_binary.h"
+#include "Hb_epid_rl_digest.h"
+
+namespace {
+constexpr uint8_t rl_block_prefix = 0;
+constexpr uint8_t rl_root_prefix = 1;
+constexpr size_t shake256_digest_size = 64;
+
+void hash_block(uint8_t *digest, size_t index, uint8_t const *block,
+  size_t len) noexcept
+{
+    uint8_t index_le[8];
+    rl_put_le(index_le, index, 8);
+    hash_context ctx;
+    hash_init_prefix(&ctx, shake256_digest_size, rl_block_prefix);
+    hash_update(&ctx, index_le, sizeof(index_le));
+    hash_update(&ctx, block, len);
+    hash_final(&ctx);
+    hash_squeeze(&ctx, digest, rl_digest_bytes);
+}
+
+// Four full blocks, one after the other from blocks, the first of them being
+// block index
+void hash_blocks_x4(
+  Rl_digest *digests, size_t index, uint8_t const *blocks) noexcept
+{
+    uint8_t index_le[4][8];
+    uint8_t const *index_ptr[4];
+    uint8_t const *block_ptr[4];
+    uint8_t *digest_ptr[4];
+    for (size_t i = 0; i < 4; ++i) {
+        rl_put_le(index_le[i], index + i, 8);
+        index_ptr[i] = index_le[i];
+        block_ptr[i] = blocks + i * rl_digest_block_bytes;
+        digest_ptr[i] = digests[i].data();
+    }
+    hash_context_x4 ctx;
+    hash_init_prefix_x4(&ctx, shake256_digest_size, rl_block_prefix);
+    hash_update_x4(&ctx, index_ptr, 8);
+    hash_update_x4(&ctx, block_ptr, rl_digest_block_bytes);
+    hash_final_x4(&ctx);
+    hash_squeeze_x4(&ctx, digest_ptr, rl_digest_bytes);
+}
+}// namespace
+
+void print_rl_digest(std::ostream &os, uint8_t const *digest)
+{
+    std::ios_base::fmtflags flags(os.flags());
+    os << std::hex << std::setfill('0');
+    for (size_t i = 0; i < rl_digest_bytes; ++i) {
+        os << std::setw(2) << static_cast<unsigned>(digest[i]);
+    }
+    os.flags(flags);
+}
+
+void Rl_digest_tree::update(
+  uint8_t const *records, size_t len, Mpc_thread_pool *pool) noexcept
+{
+    size_t n_blocks = len / rl_digest_block_bytes;
+    size_t first = std::min(blocks_.size(), n_blocks);
+    blocks_.resize(n_blocks);
+    // The new blocks are hashed in groups of four, the few left over one at
+    // a time
+    size_t n_groups = (n_blocks - first) / 4;
+    auto hash_groups = [&](size_t begin, size_t end, size_t) {
+        for (size_t g = begin; g < end; ++g) {
+            size_t b = first + 4 * g;
+            hash_blocks_x4(
+              &blocks_[b], b, records + b * rl_digest_block_bytes);
+        }
+    };
+    if (pool != nullptr && n_groups > 1) {
+        pool->parallel_for(n_groups, hash_groups);
+    } else {
+        hash_groups(0, n_groups, 0);
+    }
+    for (size_t b = first + 4 * n_groups; b < n_blocks; ++b) {
+        hash_block(blocks_[b].data(), b,
+          records + b * rl_digest_block_bytes, rl_digest_block_bytes);
+    }
+    size_t tail = len - n_blocks * rl_digest_block_bytes;
+    if (tail != 0) {
+        hash_block(last_.data(), n_blocks,
+          records + n_blocks * rl_digest_block_bytes, tail);
+    }
+    len_ = len;
+}
+
+void Rl_digest_tree::append(uint8_t const *records, size_t len) noexcept
+{
+    len_ += len;
+    if (!tail_.empty()) {
+        size_t n = std::min(len, rl_digest_block_bytes - tail_.size());
+        tail_.insert(tail_.end(), records, records + n);
+        records += n;
+        len -= n;
+        if (tail_.size() < rl_digest_block_bytes) {
+            hash_block(last_.data(), blocks_.size(), tail_.data(), tail_.size());
+            return;
+        }
+        blocks_.emplace_back();
+        hash_block(blocks_.back().data(), blocks_.size() - 1, tail_.data(),
+          rl_digest_block_bytes);
+        tail_.clear();
+    }
+    // The full blocks are hashed from where they are
+    size_t first = blocks_.size();
+    size_t n_blocks = len / rl_digest_block_bytes;
+    blocks_.resize(first + n_blocks);
+    size_t b = 0;
+    for (; b + 4 <= n_blocks; b += 4) {
+        hash_blocks_x4(&blocks_[first + b], first + b,
+          records + b * rl_digest_block_bytes);
+    }
+    for (; b < n_blocks; ++b) {
+        hash_block(blocks_[first + b].data(), first + b,
+          records + b * rl_digest_block_bytes, rl_digest_block_bytes);
+    }
+    records += n_blocks * rl_digest_block_bytes;
+    len -= n_blocks * rl_digest_block_bytes;
+    if (len != 0) {
+        tail_.assign(records, records + len);
+        hash_block(last_.data(), blocks_.size(), tail_.data(), tail_.size());
+    }
+}
+
+void Rl_digest_tree::digest(uint8_t *digest) const noexcept
+{
+    uint8_t len_le[8];
+    rl_put_le(len_le, len_, 8);
+    hash_context ctx;
+    hash_init_prefix(&ctx, shake256_digest_size, rl_root_prefix);
+    hash_update(&ctx, len_le, sizeof(len_le));
+    for (auto const &block : blocks_) {
+        hash_update(&ctx, block.data(), rl_digest_bytes);
+    }
+    if (len_ % rl_digest_block_bytes != 0) {
+        hash_update(&ctx, last_.data(), rl_digest_bytes);
+    }
+    hash_final(&ctx);
+    hash_squeeze(&ctx, digest, rl_digest_bytes);
+}
+
+void rl_content_digest(
+  uint8_t *digest, uint8_t const *records, size_t len) noexcept
+{
+    Rl_digest_tree tree;
+    tree.update(records, len);
+    tree.digest(digest);
+}
@@ -0,0 +1,347 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_index.cpp
+ * Description: A hash index over the states of a list, used to check a list for
+ *              duplicate entries and padding as it is loaded
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_impl.h"
+}
+#include "Clock_utils.h"
+#include "Hb_epid_rl_index.h"
+
+namespace {
+constexpr size_t rl_index_min_slots = 16;
+constexpr size_t rl_index_batch = 16;
+// An entry number (plus one) has to fit in the bottom half of a slot
+constexpr size_t rl_index_max_entries = UINT32_MAX - 1;
+
+// The splitmix64 finaliser
+inline uint64_t mix64(uint64_t x) noexcept
+{
+    x ^= x >> 30;
+    x *= UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94d049bb133111eb);
+    return x ^ (x >> 31);
+}
+
+inline size_t slot_entry(uint64_t slot) noexcept
+{
+    return static_cast<size_t>(slot & UINT32_MAX) - 1;
+}
+
+inline uint32_t slot_tag(uint64_t slot) noexcept
+{
+    return static_cast<uint32_t>(slot >> 32);
+}
+}// namespace
+
+Rl_state_index::Rl_state_index() noexcept
+{
+    if (picnic_random_bytes(reinterpret_cast<uint8_t *>(&seed_), sizeof(seed_))
+        != 0) {
+        seed_ = static_cast<uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+}
+
+uint64_t Rl_state_index::hash(uint8_t const *state) const noexcept
+{
+    uint64_t h = seed_;
+    for (size_t w = 0; w < lowmc_state_words64; ++w) {
+        Word word;
+        std::memcpy(&word, state + w * sizeof(Word), sizeof(Word));
+        h = mix64(h ^ word);
+    }
+    return h;
+}
+
+void Rl_state_index::reserve(size_t n_entries) noexcept
+{
+    if (2 * n_entries <= slots_.size()) { return; }
+    size_t n_slots = rl_index_min_slots;
+    unsigned bits = 4;
+    while (n_slots < 2 * n_entries) {
+        n_slots *= 2;
+        ++bits;
+    }
+    std::vector<uint64_t> old(n_slots, 0);
+    old.swap(slots_);
+    shift_ = 64 - bits;
+    total_probes_ = 0;
+    max_probes_ = 0;
+    size_t const mask = n_slots - 1;
+    // Each state goes to the first free slot from its home slot, as the
+    // states already placed are all different
+    for (uint64_t slot : old) {
+        if (slot == 0) { continue; }
+        size_t pos = hash(state(slot_entry(slot))) >> shift_;
+        size_t probes = 1;
+        for (; slots_[pos] != 0; pos = (pos + 1) & mask) { ++probes; }
+        slots_[pos] = slot;
+        count_probes(probes);
+    }
+}
+
+size_t Rl_state_index::insert(size_t entry, uint64_t h) noexcept
+{
+    uint8_t const *s = state(entry);
+    auto tag = static_cast<uint32_t>(h);
+    size_t const mask = slots_.size() - 1;
+    size_t probes = 1;
+    for (size_t pos = h >> shift_;; pos = (pos + 1) & mask, ++probes) {
+        uint64_t slot = slots_[pos];
+        if (slot == 0) {
+            slots_[pos] = (static_cast<uint64_t>(tag) << 32) | (entry + 1);
+            ++n_indexed_;
+            count_probes(probes);
+            return npos;
+        }
+        if (slot_tag(slot) == tag
+            && std::memcmp(state(slot_entry(slot)), s,
+                 lowmc_state_words64_bytes)
+                 == 0) {
+            return slot_entry(slot);
+        }
+    }
+}
+
+bool Rl_state_index::build(uint8_t const *records, size_t stride,
+  size_t state_offset, size_t n_entries, Rl_duplicates *duplicates) noexcept
+{
+    clear();
+    stride_ = stride;
+    state_offset_ = state_offset;
+    return extend(records, n_entries, duplicates);
+}
+
+bool Rl_state_index::extend(uint8_t const *records, size_t n_entries,
+  Rl_duplicates *duplicates) noexcept
+{
+    if (n_entries < n_entries_) {
+        std::cerr << "The list has " << n_entries
+                  << " entries, fewer than the " << n_entries_
+                  << " already indexed\n";
+        return false;
+    }
+    if (n_entries > rl_index_max_entries) {
+        std::cerr << "A list of " << n_entries
+                  << " entries is too large to index\n";
+        return false;
+    }
+    records_ = records;
+    reserve(n_entries);
+    // The states are random, so almost every home slot is a cache miss. The
+    // hashes are worked out a batch at a time and their home slots fetched
+    // before any of them is needed.
+    std::array<uint64_t, rl_index_batch> hashes;
+    for (size_t e = n_entries_; e < n_entries; e += rl_index_batch) {
+        size_t n = std::min(rl_index_batch, n_entries - e);
+        for (size_t b = 0; b < n; ++b) {
+            hashes[b] = hash(state(e + b));
+#if defined(__SSE2__)
+            _mm_prefetch(reinterpret_cast<char const *>(
+                           slots_.data() + (hashes[b] >> shift_)),
+              _MM_HINT_T0);
+#endif
+        }
+        for (size_t b = 0; b < n; ++b) {
+            size_t first = insert(e + b, hashes[b]);
+            if (first != npos && duplicates != nullptr) {
+                duplicates->push_back({ e + b, first });
+            }
+        }
+    }
+    n_entries_ = n_entries;
+    return true;
+}
+
+size_t Rl_state_index::find(uint8_t const *state) const noexcept
+{
+    if (n_indexed_ == 0) { return npos; }
+    uint64_t h = hash(state);
+    auto tag = static_cast<uint32_t>(h);
+    size_t const mask = slots_.size() - 1;
+    for (size_t pos = h >> shift_;; pos = (pos + 1) & mask) {
+        uint64_t slot = slots_[pos];
+        if (slot == 0) { return npos; }
+        if (slot_tag(slot) == tag
+            && std::memcmp(this->state(slot_entry(slot)), state,
+                 lowmc_state_words64_bytes)
+                 == 0) {
+            return slot_entry(slot);
+        }
+    }
+}
+
+Rl_index_stats Rl_state_index::stats() const noexcept
+{
+    Rl_index_stats stats;
+    stats.n_indexed_ = n_indexed_;
+    stats.n_slots_ = slots_.size();
+    if (n_indexed_ != 0) {
+        stats.load_ = double(n_indexed_) / double(slots_.size());
+        stats.mean_probes_ = double(total_probes_) / double(n_indexed_);
+        stats.max_probes_ = max_probes_;
+    }
+    return stats;
+}
+
+void Rl_state_index::clear() noexcept
+{
+    slots_.clear();
+    shift_ = 64;
+    records_ = nullptr;
+    n_entries_ = 0;
+    n_indexed_ = 0;
+    total_probes_ = 0;
+    max_probes_ = 0;
+}
+
+void print_rl_check_report(std::ostream &os, Rl_check_report const &report)
+{
+    auto const &index = report.index_;
+    std::streamsize const precision = os.precision();
+    os << "# List check: " << report.n_entries_ << " entries, "
+       << report.bad_padding_ << " with padding set, "
+       << report.n_repeated() << " repeated (" << report.repeated_entries_
+       << " whole entries, " << report.repeated_firsts_ << " first and "
+       << report.repeated_seconds_ << " second states) in " << std::fixed
+       << std::setprecision(2) << report.time_ms_ << " ms\n"
+       << "# Index: " << index.n_indexed_ << " states in " << index.n_slots_
+       << " slots (load " << index.load_ << "), " << index.mean_probes_
+       << " probes on average and at most " << index.max_probes_ << '\n'
+       << std::defaultfloat;
+    os.precision(precision);
+}
+
+bool check_rl_records(uint8_t const *records, size_t n_states,
+  size_t record_bytes, size_t n_entries, Rl_check_report &report,
+  Rl_state_index *index) noexcept
+{
+    F_timer_ms timer;
+    report = Rl_check_report{};
+    report.n_entries_ = n_entries;
+    size_t n_problems = 0;
+    auto reported = [&n_problems]() {
+        return n_problems++ < rl_check_max_reported;
+    };
+    auto entry = [records, record_bytes](size_t e) {
+        return records + e * record_bytes;
+    };
+
+    for (size_t e = 0; e < n_entries; ++e) {
+        for (size_t i = 0; i < n_states; ++i) {
+            if (lowmc_state_padding_clear(
+                  entry(e) + i * lowmc_state_words64_bytes)) {
+                continue;
+            }
+            ++report.bad_padding_;
+            if (reported()) {
+                std::cerr << "Entry " << e << " has bits set beyond the "
+                          << Mpc_parameters::lowmc_state_bits_
+                          << " bits of state " << i << '\n';
+            }
+            break;
+        }
+    }
+
+    Rl_state_index firsts_index;
+    Rl_state_index &firsts = (index != nullptr) ? *index : firsts_index;
+    Rl_duplicates repeats;
+    if (!firsts.build(records, record_bytes, 0, n_entries, &repeats)) {
+        return false;
+    }
+    size_t const entry_bytes = n_states * lowmc_state_words64_bytes;
+    // The repeats are found in order
+    std::vector<size_t> repeated;
+    repeated.reserve(repeats.size());
+    for (auto const &repeat : repeats) {
+        repeated.push_back(repeat.entry_);
+        bool whole =
+          std::memcmp(entry(repeat.entry_), entry(repeat.first_), entry_bytes)
+          == 0;
+        ++(whole ? report.repeated_entries_ : report.repeated_firsts_);
+        if (reported()) {
+            std::cerr << "Entry " << repeat.entry_
+                      << (whole ? " is the same as entry "
+                                : " has the same first state as entry ")
+                      << repeat.first_ << '\n';
+        }
+    }
+
+    if (n_states > 1) {
+        Rl_state_index seconds;
+        repeats.clear();
+        if (!seconds.build(records, record_bytes, lowmc_state_words64_bytes,
+              n_entries, &repeats)) {
+            return false;
+        }
+        for (auto const &repeat : repeats) {
+            // Entries that repeat a first state have been counted already
+            if (std::binary_search(
+                  repeated.begin(), repeated.end(), repeat.entry_)) {
+                continue;
+            }
+            ++report.repeated_seconds_;
+            if (reported()) {
+                std::cerr << "Entry " << repeat.entry_
+                          << " has the same second state as entry "
+                          << repeat.first_ << '\n';
+            }
+        }
+    }
+    if (n_problems > rl_check_max_reported) {
+        std::cerr << n_problems - rl_check_max_reported
+                  << " more problems with the list\n";
+    }
+
+    report.index_ = firsts.stats();
+    report.time_ms_ = timer.get_duration();
+    return report.bad_padding_ == 0;
+}
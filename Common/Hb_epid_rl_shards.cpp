@@ -0,0 +1,275 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_shards.cpp
+ * Description: A revocation list split into shard files listed in a manifest
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "Io_utils.h"
+#include "Mpc_thread_pool.h"
+#include "Hb_epid_rl_shards.h"
+
+namespace {
+const std::string rl_manifest_magic{ "HBGS-RLM" };
+
+// The directory a manifest is in, for its shard file names
+std::string manifest_directory(std::string const &manifest_filename)
+{
+    auto pos = manifest_filename.find_last_of("/\\");
+    return (pos == std::string::npos) ? std::string(".")
+                                      : manifest_filename.substr(0, pos);
+}
+
+std::string base_name(std::string const &filename)
+{
+    auto pos = filename.find_last_of("/\\");
+    return (pos == std::string::npos) ? filename : filename.substr(pos + 1);
+}
+
+// Read the next line as "<key> <value>"
+bool read_manifest_value(
+  std::istream &is, std::string const &key, std::string &value)
+{
+    std::string line;
+    if (!std::getline(is, line)) { return false; }
+    std::istringstream fields{ line };
+    std::string k;
+    return (fields >> k >> value) && k == key;
+}
+}// namespace
+
+bool write_rl_manifest(
+  std::string const &filename, Rl_manifest const &manifest) noexcept
+{
+    char digest_hex[2 * rl_digest_bytes];
+    encode_hex(digest_hex, manifest.digest_.data(), rl_digest_bytes);
+
+    std::ostringstream os;
+    os << rl_manifest_magic << ' ' << rl_manifest_version << '\n'
+       << "list " << manifest.list_name_ << '\n'
+       << "n " << manifest.state_bits_ << '\n'
+       << "entries " << manifest.n_entries_ << '\n'
+       << "digest " << std::string(digest_hex, sizeof(digest_hex)) << '\n'
+       << "shards " << manifest.shards_.size() << '\n';
+    for (auto const &shard : manifest.shards_) {
+        os << shard.first_entry_ << ' ' << shard.n_entries_ << ' '
+           << shard.filename_ << '\n';
+    }
+    std::string text = os.str();
+
+    Rl_file_writer writer;
+    return writer.open(filename) && writer.write(text.data(), text.size())
+           && writer.commit();
+}
+
+bool read_rl_manifest(
+  Rl_manifest &manifest, std::string const &filename) noexcept
+{
+    manifest = Rl_manifest{};
+    std::ifstream is{ filename };
+    if (!is) {
+        std::cerr << "Unable to open the file " << filename << '\n';
+        return false;
+    }
+
+    std::string version;
+    std::string state_bits;
+    std::string n_entries;
+    std::string digest_hex;
+    std::string n_shards;
+    if (!read_manifest_value(is, rl_manifest_magic, version)
+        || std::strtoul(version.c_str(), nullptr, 10) != rl_manifest_version) {
+        std::cerr << filename << " is not a list manifest this code can read\n";
+        return false;
+    }
+    if (!read_manifest_value(is, "list", manifest.list_name_)
+        || !read_manifest_value(is, "n", state_bits)
+        || !read_manifest_value(is, "entries", n_entries)
+        || !read_manifest_value(is, "digest", digest_hex)
+        || !read_manifest_value(is, "shards", n_shards)) {
+        std::cerr << filename << ": the manifest header is malformed\n";
+        return false;
+    }
+    manifest.state_bits_ =
+      static_cast<uint16_t>(std::strtoul(state_bits.c_str(), nullptr, 10));
+    manifest.n_entries_ = std::strtoull(n_entries.c_str(), nullptr, 10);
+    if (manifest.state_bits_ != Mpc_parameters::lowmc_state_bits_) {
+        std::cerr << filename << ": the list is for n = "
+                  << manifest.state_bits_ << ", not n = "
+                  << Mpc_parameters::lowmc_state_bits_ << '\n';
+        return false;
+    }
+    if (digest_hex.size() != 2 * rl_digest_bytes
+        || decode_hex(manifest.digest_.data(), digest_hex.data(),
+             rl_digest_bytes)
+             != digest_hex.size()) {
+        std::cerr << filename << ": the digest is malformed\n";
+        return false;
+    }
+
+    // The shards must follow on from each other and cover the whole list
+    size_t n = std::strtoul(n_shards.c_str(), nullptr, 10);
+    uint64_t next_entry = 0;
+    for (size_t s = 0; s < n; ++s) {
+        std::string line;
+        Rl_shard_info shard;
+        if (!std::getline(is, line)
+            || !(std::istringstream{ line } >> shard.first_entry_
+                 >> shard.n_entries_ >> shard.filename_)) {
+            std::cerr << filename << ": shard " << s << " is malformed\n";
+            return false;
+        }
+        if (shard.first_entry_ != next_entry) {
+            std::cerr << filename << ": shard " << s << " starts at entry "
+                      << shard.first_entry_ << ", not " << next_entry << '\n';
+            return false;
+        }
+        if (shard.n_entries_ > UINT64_MAX - next_entry) {
+            std::cerr << filename << ": shard " << s << " is too large\n";
+            return false;
+        }
+        next_entry += shard.n_entries_;
+        manifest.shards_.push_back(std::move(shard));
+    }
+    if (next_entry != manifest.n_entries_) {
+        std::cerr << filename << ": the shards hold " << next_entry
+                  << " entries, not " << manifest.n_entries_ << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+void Rl_shard_writer::open(std::string const &filename,
+  std::string const &list_name, Rl_binary_type type, size_t n_states,
+  size_t record_bytes, std::string const &shard_ext,
+  std::string const &manifest_ext) noexcept
+{
+    filename_ = filename;
+    shard_ext_ = shard_ext;
+    manifest_ext_ = manifest_ext;
+    type_ = type;
+    n_states_ = n_states;
+    record_bytes_ = record_bytes;
+    manifest_ = Rl_manifest{};
+    manifest_.list_name_ = list_name;
+    digest_tree_.clear();
+}
+
+bool Rl_shard_writer::add_shard(
+  uint8_t const *records, size_t n_entries) noexcept
+{
+    std::string shard_filename = filename_ + '.'
+                                 + std::to_string(manifest_.shards_.size())
+                                 + '.' + shard_ext_;
+    if (!write_rl_binary(
+          shard_filename, type_, n_states_, record_bytes_, records, n_entries)) {
+        return false;
+    }
+    digest_tree_.append(records, n_entries * record_bytes_);
+    manifest_.shards_.push_back(
+      { manifest_.n_entries_, n_entries, base_name(shard_filename) });
+    manifest_.n_entries_ += n_entries;
+    return true;
+}
+
+bool Rl_shard_writer::commit() noexcept
+{
+    digest_tree_.digest(manifest_.digest_.data());
+    return write_rl_manifest(filename_ + '.' + manifest_ext_, manifest_);
+}
+
+bool read_rl_shards(Rl_manifest const &manifest,
+  std::string const &manifest_filename, Rl_binary_type type, size_t n_states,
+  size_t record_bytes, std::function<uint8_t *()> const &records_for,
+  bool check_digest) noexcept
+{
+    std::string directory = manifest_directory(manifest_filename);
+    size_t n_shards = manifest.shards_.size();
+
+    // Every shard is mapped and checked before the list is sized, so the
+    // count in the manifest is only used once the shard files are known to
+    // hold that many entries. Mapping only reads the headers.
+    std::vector<Rl_file_mapping> mappings(n_shards);
+    std::vector<uint64_t> records_offset(n_shards, 0);
+    bool ok = true;
+    for (size_t s = 0; s < n_shards; ++s) {
+        Rl_shard_info const &shard = manifest.shards_[s];
+        Rl_binary_header header;
+        if (!mappings[s].map(make_filename(directory, shard.filename_))
+            || !decode_rl_binary_header(
+              header, mappings[s].data(), mappings[s].size())
+            || !check_rl_binary(header, type, n_states, record_bytes,
+              mappings[s].data(), mappings[s].size(), false)
+            || header.n_entries_ != shard.n_entries_) {
+            std::cerr << manifest_filename << ": shard " << s << " ("
+                      << shard.filename_
+                      << ") is missing or does not match the manifest\n";
+            ok = false;
+            continue;
+        }
+        records_offset[s] = header.records_offset_;
+    }
+    if (!ok) { return false; }
+
+    // Each shard's records are checked against the whole list's digest
+    // below, so not one by one here
+    uint8_t *records = records_for();
+    Mpc_thread_pool &pool = Mpc_thread_pool::instance();
+    pool.parallel_for(n_shards, [&](size_t begin, size_t end, size_t) {
+        for (size_t s = begin; s < end; ++s) {
+            Rl_shard_info const &shard = manifest.shards_[s];
+            std::memcpy(
+              records + static_cast<size_t>(shard.first_entry_) * record_bytes,
+              mappings[s].data() + records_offset[s],
+              static_cast<size_t>(shard.n_entries_) * record_bytes);
+        }
+    });
+    if (!check_digest) { return true; }
+
+    Rl_digest_tree tree;
+    tree.update(records,
+      static_cast<size_t>(manifest.n_entries_) * record_bytes, &pool);
+    if (tree.digest() != manifest.digest_) {
+        std::cerr << manifest_filename
+                  << ": the shards do not match the manifest's digest\n";
+        return false;
+    }
+    return true;
+}
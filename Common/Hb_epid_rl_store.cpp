@@ -0,0 +1,356 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_store.cpp
+ * Description: A versioned store for a revocation list, a snapshot and an
+ *              append-only log of the deltas made to it since
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Hb_epid_rl_binary.h"
+#include "Hb_epid_rl_store.h"
+
+namespace {
+constexpr uint8_t log_magic[8] = { 'H', 'B', 'G', 'S', '-', 'R', 'L', 'L' };
+constexpr uint8_t segment_magic[8] = { 'H', 'B', 'G', 'S', '-', 'R', 'L',
+    'D' };
+
+void encode_log_header(uint8_t *out, Rl_log_header const &header) noexcept
+{
+    std::memset(out, 0, rl_log_header_bytes);
+    std::memcpy(out, log_magic, sizeof(log_magic));
+    rl_put_le(out + 8, rl_log_version, 2);
+    out[10] = static_cast<uint8_t>(header.type_);
+    out[11] = header.n_states_;
+    rl_put_le(out + 12, header.state_bits_, 2);
+    rl_put_le(out + 14, header.record_bytes_, 2);
+    rl_put_le(out + 16, header.base_version_, 8);
+    rl_put_le(out + 24, header.base_entries_, 8);
+    std::memcpy(out + 32, header.base_digest_, rl_digest_bytes);
+}
+
+bool decode_log_header(Rl_log_header &header, uint8_t const *in) noexcept
+{
+    if (std::memcmp(in, log_magic, sizeof(log_magic)) != 0) { return false; }
+    if (rl_get_le(in + 8, 2) != rl_log_version) {
+        std::cerr << "Unsupported list log version " << rl_get_le(in + 8, 2)
+                  << '\n';
+        return false;
+    }
+    header.type_ = static_cast<Rl_binary_type>(in[10]);
+    header.n_states_ = in[11];
+    header.state_bits_ = static_cast<uint16_t>(rl_get_le(in + 12, 2));
+    header.record_bytes_ = static_cast<uint16_t>(rl_get_le(in + 14, 2));
+    header.base_version_ = rl_get_le(in + 16, 8);
+    header.base_entries_ = rl_get_le(in + 24, 8);
+    std::memcpy(header.base_digest_, in + 32, rl_digest_bytes);
+    return true;
+}
+
+void encode_segment_header(
+  uint8_t *out, Rl_segment_header const &segment) noexcept
+{
+    std::memset(out, 0, rl_segment_header_bytes);
+    std::memcpy(out, segment_magic, sizeof(segment_magic));
+    rl_put_le(out + 8, segment.version_, 8);
+    rl_put_le(out + 16, segment.first_entry_, 8);
+    rl_put_le(out + 24, segment.n_entries_, 8);
+    std::memcpy(out + 32, segment.digest_, rl_digest_bytes);
+}
+
+bool decode_segment_header(
+  Rl_segment_header &segment, uint8_t const *in) noexcept
+{
+    if (std::memcmp(in, segment_magic, sizeof(segment_magic)) != 0) {
+        return false;
+    }
+    segment.version_ = rl_get_le(in + 8, 8);
+    segment.first_entry_ = rl_get_le(in + 16, 8);
+    segment.n_entries_ = rl_get_le(in + 24, 8);
+    std::memcpy(segment.digest_, in + 32, rl_digest_bytes);
+    return true;
+}
+
+bool read_fully(int fd, uint8_t *buf, size_t len, uint64_t offset) noexcept
+{
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return false; }
+        buf += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool write_fully(
+  int fd, uint8_t const *buf, size_t len, uint64_t offset) noexcept
+{
+    while (len > 0) {
+        ssize_t n = pwrite(fd, buf, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return false; }
+        buf += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+}// namespace
+
+bool Rl_log_header::operator==(Rl_log_header const &other) const noexcept
+{
+    return type_ == other.type_ && n_states_ == other.n_states_
+           && state_bits_ == other.state_bits_
+           && record_bytes_ == other.record_bytes_
+           && base_version_ == other.base_version_
+           && base_entries_ == other.base_entries_
+           && std::memcmp(base_digest_, other.base_digest_, rl_digest_bytes)
+                == 0;
+}
+
+bool write_rl_log(
+  std::string const &filename, Rl_log_header const &header) noexcept
+{
+    uint8_t encoded[rl_log_header_bytes];
+    encode_log_header(encoded, header);
+    Rl_file_writer writer;
+    return writer.open(filename) && writer.write(encoded, sizeof(encoded))
+           && writer.commit();
+}
+
+bool Rl_log_reader::open(std::string const &filename) noexcept
+{
+    close();
+    filename_ = filename;
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "Unable to open the file " << filename << '\n';
+        return false;
+    }
+    uint8_t encoded[rl_log_header_bytes];
+    if (!read_fully(fd_, encoded, sizeof(encoded), 0)
+        || !decode_log_header(header_, encoded)) {
+        std::cerr << "The file " << filename << " is not a list log\n";
+        close();
+        return false;
+    }
+    if (header_.record_bytes_ == 0) {
+        std::cerr << "The file " << filename << " is not a list log\n";
+        close();
+        return false;
+    }
+    if (header_.state_bits_ != Mpc_parameters::lowmc_state_bits_) {
+        std::cerr << "The list log is for n = " << header_.state_bits_
+                  << ", not n = " << Mpc_parameters::lowmc_state_bits_ << '\n';
+        close();
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        std::cerr << "Unable to find the length of " << filename << '\n';
+        close();
+        return false;
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void Rl_log_reader::close() noexcept
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+Rl_segment_read Rl_log_reader::read_segment_header(uint64_t offset,
+  Rl_segment_header &segment, size_t &records_len) const noexcept
+{
+    if (fd_ < 0 || offset > size_) { return Rl_segment_read::damaged; }
+    if (offset == size_) { return Rl_segment_read::end; }
+    uint64_t const room = size_ - offset;
+    if (room < rl_segment_header_bytes) { return Rl_segment_read::torn; }
+    uint8_t encoded[rl_segment_header_bytes];
+    if (!read_fully(fd_, encoded, sizeof(encoded), offset)) {
+        return Rl_segment_read::torn;
+    }
+    if (!decode_segment_header(segment, encoded)) {
+        std::cerr << "The list log " << filename_
+                  << " has a bad segment at offset " << offset << '\n';
+        return Rl_segment_read::damaged;
+    }
+    // The header is not trusted until its records are known to fit in the
+    // log, which also keeps the length from overflowing
+    uint64_t const records_room = room - rl_segment_header_bytes;
+    if (segment.n_entries_ <= records_room / header_.record_bytes_) {
+        records_len =
+          static_cast<size_t>(segment.n_entries_) * header_.record_bytes_;
+        return Rl_segment_read::ok;
+    }
+    // A segment that runs past the end is torn, unless another segment
+    // starts after it, in which case its length is what is damaged
+    std::vector<uint8_t> rest(static_cast<size_t>(records_room));
+    if (!read_fully(
+          fd_, rest.data(), rest.size(), offset + rl_segment_header_bytes)) {
+        return Rl_segment_read::torn;
+    }
+    for (size_t at = 0; at + sizeof(segment_magic) <= rest.size();
+         at += header_.record_bytes_) {
+        if (std::memcmp(rest.data() + at, segment_magic, sizeof(segment_magic))
+            == 0) {
+            std::cerr << "The list log " << filename_
+                      << " has a damaged segment at offset " << offset << '\n';
+            return Rl_segment_read::damaged;
+        }
+    }
+    return Rl_segment_read::torn;
+}
+
+Rl_segment_read Rl_log_reader::read_segment(uint64_t &offset,
+  Rl_segment_header &segment, std::vector<uint8_t> &records) const noexcept
+{
+    size_t records_len = 0;
+    Rl_segment_read read = read_segment_header(offset, segment, records_len);
+    if (read != Rl_segment_read::ok) { return read; }
+    records.resize(records_len);
+    if (!read_fully(fd_, records.data(), records_len,
+          offset + rl_segment_header_bytes)) {
+        return Rl_segment_read::torn;
+    }
+    uint8_t digest[rl_digest_bytes];
+    rl_content_digest(digest, records.data(), records_len);
+    if (std::memcmp(digest, segment.digest_, rl_digest_bytes) != 0) {
+        uint64_t end = offset + rl_segment_header_bytes + records_len;
+        if (end == size_) { return Rl_segment_read::torn; }
+        std::cerr << "The list log " << filename_
+                  << " has a damaged segment at offset " << offset << '\n';
+        return Rl_segment_read::damaged;
+    }
+    offset += rl_segment_header_bytes + records_len;
+    return Rl_segment_read::ok;
+}
+
+Rl_segment_read Rl_log_reader::skip_segment(
+  uint64_t &offset, Rl_segment_header &segment) const noexcept
+{
+    size_t records_len = 0;
+    Rl_segment_read read = read_segment_header(offset, segment, records_len);
+    if (read == Rl_segment_read::ok) {
+        offset += rl_segment_header_bytes + records_len;
+    }
+    return read;
+}
+
+bool append_rl_log(std::string const &filename, Rl_binary_type type,
+  size_t n_states, size_t record_bytes, uint8_t const *records,
+  size_t n_entries, uint64_t &version) noexcept
+{
+    Rl_log_reader log;
+    if (!log.open(filename)) { return false; }
+    Rl_log_header const &header = log.header();
+    if (header.type_ != type || header.n_states_ != n_states
+        || header.record_bytes_ != record_bytes) {
+        std::cerr << "The list log " << filename
+                  << " holds a different kind of list\n";
+        return false;
+    }
+
+    // Find the end of the last complete segment. Only the segment headers
+    // are read, so this costs the number of segments rather than the size
+    // of the log. The segments before the last were complete when they were
+    // appended, only the last can be torn, so only its digest is checked. A
+    // torn segment is left from an append that did not finish and is
+    // written over, but a damaged one has complete segments after it, which
+    // must not be lost.
+    Rl_segment_header segment;
+    segment.version_ = header.base_version_ + 1;
+    segment.first_entry_ = header.base_entries_;
+    Rl_segment_header before = segment;// Taken back if the last is torn
+    uint64_t end = Rl_log_reader::first_segment_;
+    uint64_t last_start = end;
+    Rl_segment_header last;
+    Rl_segment_read read;
+    for (;;) {
+        uint64_t start = end;
+        read = log.skip_segment(end, last);
+        if (read != Rl_segment_read::ok) { break; }
+        last_start = start;
+        before = segment;
+        segment.version_ = last.version_ + 1;
+        segment.first_entry_ = last.first_entry_ + last.n_entries_;
+    }
+    if (read == Rl_segment_read::end && end != Rl_log_reader::first_segment_) {
+        uint64_t offset = last_start;
+        std::vector<uint8_t> last_records;
+        if (log.read_segment(offset, last, last_records)
+            != Rl_segment_read::ok) {
+            end = last_start;
+            segment = before;
+        }
+    }
+    log.close();
+    if (read == Rl_segment_read::damaged) {
+        std::cerr << "Not appending to the list log " << filename
+                  << ", it is damaged before its end\n";
+        return false;
+    }
+
+    std::vector<uint8_t> buffer;
+    segment.n_entries_ = n_entries;
+    rl_content_digest(segment.digest_, records, n_entries * record_bytes);
+    buffer.resize(rl_segment_header_bytes + n_entries * record_bytes);
+    encode_segment_header(buffer.data(), segment);
+    std::memcpy(
+      buffer.data() + rl_segment_header_bytes, records, n_entries * record_bytes);
+
+    int fd = ::open(filename.c_str(), O_WRONLY);
+    bool ok = fd >= 0 && ftruncate(fd, static_cast<off_t>(end)) == 0
+              && write_fully(fd, buffer.data(), buffer.size(), end)
+              && fsync(fd) == 0;
+    if (fd >= 0) { ok = (::close(fd) == 0) && ok; }
+    if (!ok) {
+        std::cerr << "Failed to append to the list log " << filename << '\n';
+        return false;
+    }
+    version = segment.version_;
+    return true;
+}
@@ -0,0 +1,244 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_text.cpp
+ * Description: Fast reading and writing of the text form of the revocation
+ *              lists
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include "Io_utils.h"
+#include "Mpc_thread_pool.h"
+#include "Hb_epid_rl_text.h"
+
+namespace {
+constexpr size_t state_hex_chars = 2 * Mpc_parameters::lowmc_state_bytes_;
+
+inline bool is_blank(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+char const *skip_blanks(char const *p, char const *end) noexcept
+{
+    while (p < end && is_blank(*p)) { ++p; }
+    return p;
+}
+
+char const *next_line(char const *p, char const *end) noexcept
+{
+    auto const *nl = static_cast<char const *>(
+      std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    return (nl == nullptr) ? end : nl + 1;
+}
+}// namespace
+
+bool Rl_text_file::open(std::string const &filename,
+  std::string const &list_name, size_t n_states) noexcept
+{
+    filename_ = filename;
+    n_states_ = n_states;
+    lines_.clear();
+    if (!mapping_.map(filename)) { return false; }
+
+    auto const *begin = reinterpret_cast<char const *>(mapping_.data());
+    char const *end = begin + mapping_.size();
+    char const *p = next_line(begin, end);
+    std::istringstream header{ std::string(begin, p) };
+    std::string rl_name;
+    size_t n_entries = 0;
+    std::string entries;
+    header >> rl_name >> n_entries >> entries;
+    if (!header || rl_name != list_name || entries != "entries") {
+        report({ 0, "the header should be: <list name> <n> entries" });
+        if (rl_name != list_name) {
+            std::cerr << "The list name should be " << list_name << '\n';
+        }
+        return false;
+    }
+
+    // A header giving more entries than the file could hold is not trusted
+    lines_.reserve(std::min(n_entries,
+      mapping_.size() / (n_states * (state_hex_chars + 1))));
+    while (p < end) {
+        char const *line = p;
+        p = next_line(p, end);
+        // Blank lines (there is usually one at the end) are skipped
+        char const *first = skip_blanks(line, p);
+        if (first == p || *first == '\n') { continue; }
+        lines_.push_back(static_cast<size_t>(line - begin));
+    }
+
+    if (lines_.size() != n_entries) {
+        report({ (lines_.size() > n_entries) ? lines_[n_entries] : 0,
+          "the number of entries does not match the header" });
+        std::cerr << "The header gives " << n_entries << " entries, "
+                  << lines_.size() << " were found\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool Rl_text_file::parse_line(
+  uint8_t *record, size_t offset, Error &error) const noexcept
+{
+    auto const *begin = reinterpret_cast<char const *>(mapping_.data());
+    char const *end = begin + mapping_.size();
+    char const *p = begin + offset;
+    for (size_t s = 0; s < n_states_; ++s) {
+        uint8_t *state = record + s * lowmc_state_words64_bytes;
+        p = skip_blanks(p, end);
+        if (end - p < static_cast<std::ptrdiff_t>(state_hex_chars)) {
+            error = { static_cast<size_t>(p - begin), "the line is too short" };
+            return false;
+        }
+        size_t good =
+          decode_hex(state, p, Mpc_parameters::lowmc_state_bytes_);
+        if (good != state_hex_chars) {
+            bool short_state = is_blank(p[good]) || p[good] == '\n';
+            error = { static_cast<size_t>(p - begin) + good,
+                short_state ? "the state is too short" : "bad hex digit" };
+            return false;
+        }
+        std::memset(state + Mpc_parameters::lowmc_state_bytes_, 0,
+          lowmc_state_words64_bytes - Mpc_parameters::lowmc_state_bytes_);
+        p += state_hex_chars;
+        if (p < end && !is_blank(*p) && *p != '\n') {
+            error = { static_cast<size_t>(p - begin), "the state is too long" };
+            return false;
+        }
+    }
+    p = skip_blanks(p, end);
+    if (p < end && *p != '\n') {
+        error = { static_cast<size_t>(p - begin),
+            "unexpected characters after the entry" };
+        return false;
+    }
+
+    return true;
+}
+
+bool Rl_text_file::decode(uint8_t *records, size_t record_bytes) noexcept
+{
+    Mpc_thread_pool &pool = Mpc_thread_pool::instance();
+    // The first few errors found by each worker, and how many there were
+    std::vector<std::vector<Error>> errors(pool.size());
+    std::vector<size_t> n_errors(pool.size(), 0);
+
+    pool.parallel_for(
+      lines_.size(), [&](size_t begin, size_t end, size_t worker) {
+          Error error{ 0, nullptr };
+          for (size_t e = begin; e < end; ++e) {
+              if (parse_line(records + e * record_bytes, lines_[e], error)) {
+                  continue;
+              }
+              if (errors[worker].size() < rl_text_max_reported) {
+                  errors[worker].push_back(error);
+              }
+              ++n_errors[worker];
+          }
+      });
+
+    std::vector<Error> all;
+    size_t total = 0;
+    for (size_t w = 0; w < pool.size(); ++w) {
+        all.insert(all.end(), errors[w].begin(), errors[w].end());
+        total += n_errors[w];
+    }
+    if (total == 0) { return true; }
+
+    std::sort(all.begin(), all.end(),
+      [](Error const &a, Error const &b) { return a.offset_ < b.offset_; });
+    all.resize(std::min(all.size(), rl_text_max_reported));
+    for (auto const &error : all) { report(error); }
+    if (total > all.size()) {
+        std::cerr << filename_ << ": " << total - all.size()
+                  << " more malformed lines\n";
+    }
+
+    return false;
+}
+
+void Rl_text_file::report(Error const &error) const noexcept
+{
+    // Only done for errors, so the line is found by counting
+    auto const *begin = reinterpret_cast<char const *>(mapping_.data());
+    char const *at = begin + std::min(error.offset_, mapping_.size());
+    size_t line = 1 + static_cast<size_t>(std::count(begin, at, '\n'));
+    char const *line_start = at;
+    while (line_start > begin && line_start[-1] != '\n') { --line_start; }
+    std::cerr << filename_ << ':' << line << ':' << (at - line_start) + 1
+              << ": " << error.what_ << '\n';
+}
+
+bool write_rl_text(std::string const &filename, std::string const &list_name,
+  size_t n_states, size_t record_bytes, uint8_t const *records,
+  size_t n_entries) noexcept
+{
+    constexpr size_t buffer_bytes = size_t(1) << 20;
+    size_t line_bytes = n_states * (state_hex_chars + 1);
+
+    Rl_file_writer writer;
+    if (!writer.open(filename)) { return false; }
+    std::string header =
+      list_name + ' ' + std::to_string(n_entries) + " entries\n";
+    if (!writer.write(header.data(), header.size())) { return false; }
+
+    std::vector<char> buffer(std::max(buffer_bytes, line_bytes));
+    size_t lines_per_buffer = buffer.size() / line_bytes;
+    for (size_t e = 0; e < n_entries; e += lines_per_buffer) {
+        size_t n_lines = std::min(lines_per_buffer, n_entries - e);
+        char *out = buffer.data();
+        for (size_t l = 0; l < n_lines; ++l) {
+            uint8_t const *record = records + (e + l) * record_bytes;
+            for (size_t s = 0; s < n_states; ++s) {
+                encode_hex(out, record + s * lowmc_state_words64_bytes,
+                  Mpc_parameters::lowmc_state_bytes_);
+                out += state_hex_chars;
+                *out++ = (s + 1 < n_states) ? '\t' : '\n';
+            }
+        }
+        if (!writer.write(buffer.data(), n_lines * line_bytes)) {
+            return false;
+        }
+    }
+
+    return writer.commit();
+}
@@ -0,0 +1,347 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_transport.cpp
+ * Description: A compact transport encoding for revocation lists and their deltas,
+ *              with a streaming decoder
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "Hb_epid_rl_transport.h"
+
+namespace {
+constexpr uint8_t rl_transport_magic[8] = { 'H', 'B', 'G', 'S', '-', 'R', 'L',
+    'T' };
+}// namespace
+
+void encode_rl_transport_header(
+  uint8_t *out, Rl_transport_header const &header) noexcept
+{
+    std::memset(out, 0, rl_transport_header_bytes);
+    std::memcpy(out, rl_transport_magic, sizeof(rl_transport_magic));
+    rl_put_le(out + 8, rl_transport_version, 2);
+    out[10] = static_cast<uint8_t>(header.type_);
+    out[11] = header.n_states_;
+    rl_put_le(out + 12, header.state_bits_, 2);
+    rl_put_le(out + 14, header.entry_bytes_, 2);
+    out[16] = static_cast<uint8_t>(header.kind_);
+    rl_put_le(out + 24, header.list_version_, 8);
+    rl_put_le(out + 32, header.first_entry_, 8);
+    rl_put_le(out + 40, header.n_entries_, 8);
+    std::memcpy(out + 48, header.digest_.data(), rl_digest_bytes);
+}
+
+bool decode_rl_transport_header(
+  Rl_transport_header &header, uint8_t const *in) noexcept
+{
+    if (std::memcmp(in, rl_transport_magic, sizeof(rl_transport_magic)) != 0) {
+        std::cerr << "Not a list in the transport form\n";
+        return false;
+    }
+    if (rl_get_le(in + 8, 2) != rl_transport_version) {
+        std::cerr << "Unsupported list transport version "
+                  << rl_get_le(in + 8, 2) << '\n';
+        return false;
+    }
+    header.type_ = static_cast<Rl_binary_type>(in[10]);
+    header.n_states_ = in[11];
+    header.state_bits_ = static_cast<uint16_t>(rl_get_le(in + 12, 2));
+    header.entry_bytes_ = static_cast<uint16_t>(rl_get_le(in + 14, 2));
+    header.kind_ = static_cast<Rl_transport_kind>(in[16]);
+    header.list_version_ = rl_get_le(in + 24, 8);
+    header.first_entry_ = rl_get_le(in + 32, 8);
+    header.n_entries_ = rl_get_le(in + 40, 8);
+    std::memcpy(header.digest_.data(), in + 48, rl_digest_bytes);
+    if (header.kind_ != Rl_transport_kind::list
+        && header.kind_ != Rl_transport_kind::delta) {
+        std::cerr << "Unknown list transport kind "
+                  << static_cast<unsigned>(in[16]) << '\n';
+        return false;
+    }
+    return true;
+}
+
+size_t pack_rl_transport_entries(uint8_t *out, uint8_t const *records,
+  size_t n_states, size_t record_bytes, size_t n_entries) noexcept
+{
+    constexpr size_t whole = rl_state_whole_bytes;
+    constexpr size_t extra = rl_state_extra_bits;
+    for (size_t e = 0; e < n_entries; ++e, records += record_bytes) {
+        // Anything beyond the n bits of a state would be lost
+        for (size_t i = 0; i < n_states; ++i) {
+            if (!lowmc_state_padding_clear(
+                  records + i * lowmc_state_words64_bytes)) {
+                return e;
+            }
+        }
+        for (size_t i = 0; i < n_states; ++i) {
+            std::memcpy(out, records + i * lowmc_state_words64_bytes, whole);
+            out += whole;
+        }
+        if constexpr (extra != 0) {
+            // The leftover bits sit at the top of the last byte of each state
+            uint64_t bits = 0;
+            for (size_t i = 0; i < n_states; ++i) {
+                bits = (bits << extra)
+                       | (records[i * lowmc_state_words64_bytes + whole]
+                          >> (8 - extra));
+            }
+            size_t n_bits = n_states * extra;
+            size_t n_bytes = (n_bits + 7) / 8;
+            bits <<= n_bytes * 8 - n_bits;
+            for (size_t b = n_bytes; b > 0; --b) {
+                *out++ = static_cast<uint8_t>(bits >> (8 * (b - 1)));
+            }
+        }
+    }
+    return n_entries;
+}
+
+void unpack_rl_transport_entries(uint8_t *records, uint8_t const *in,
+  size_t n_states, size_t record_bytes, size_t n_entries) noexcept
+{
+    constexpr size_t whole = rl_state_whole_bytes;
+    constexpr size_t extra = rl_state_extra_bits;
+    for (size_t e = 0; e < n_entries; ++e, records += record_bytes) {
+        // The padding of each state is left clear
+        std::memset(records, 0, record_bytes);
+        for (size_t i = 0; i < n_states; ++i) {
+            std::memcpy(records + i * lowmc_state_words64_bytes, in, whole);
+            in += whole;
+        }
+        if constexpr (extra != 0) {
+            size_t n_bits = n_states * extra;
+            size_t n_bytes = (n_bits + 7) / 8;
+            uint64_t bits = 0;
+            for (size_t b = 0; b < n_bytes; ++b) { bits = (bits << 8) | *in++; }
+            bits >>= n_bytes * 8 - n_bits;
+            for (size_t i = n_states; i > 0; --i) {
+                records[(i - 1) * lowmc_state_words64_bytes + whole] =
+                  static_cast<uint8_t>((bits & ((1U << extra) - 1))
+                                       << (8 - extra));
+                bits >>= extra;
+            }
+        }
+    }
+}
+
+bool write_rl_transport(std::ostream &os, Rl_transport_kind kind,
+  Rl_binary_type type, size_t n_states, size_t record_bytes,
+  uint64_t list_version, uint64_t first_entry, uint8_t const *records,
+  size_t n_entries) noexcept
+{
+    Rl_transport_header header;
+    header.kind_ = kind;
+    header.type_ = type;
+    header.n_states_ = static_cast<uint8_t>(n_states);
+    header.entry_bytes_ =
+      static_cast<uint16_t>(rl_transport_entry_bytes(n_states));
+    header.list_version_ = list_version;
+    header.first_entry_ = first_entry;
+    header.n_entries_ = n_entries;
+    rl_content_digest(header.digest_.data(), records, n_entries * record_bytes);
+    uint8_t encoded[rl_transport_header_bytes];
+    encode_rl_transport_header(encoded, header);
+    os.write(reinterpret_cast<char const *>(encoded), sizeof(encoded));
+
+    // Packed a batch at a time into a buffer of a fixed size
+    size_t const batch = Rl_transport_decoder::batch_entries_;
+    std::vector<uint8_t> buffer(batch * header.entry_bytes_);
+    for (size_t e = 0; e < n_entries && os; e += batch) {
+        size_t n = std::min(batch, n_entries - e);
+        size_t n_packed = pack_rl_transport_entries(
+          buffer.data(), records + e * record_bytes, n_states, record_bytes, n);
+        if (n_packed != n) {
+            std::cerr << "Entry " << e + n_packed
+                      << " has bits set beyond the state size, n = "
+                      << Mpc_parameters::lowmc_state_bits_ << '\n';
+            return false;
+        }
+        os.write(reinterpret_cast<char const *>(buffer.data()),
+          static_cast<std::streamsize>(n * header.entry_bytes_));
+    }
+    if (!os) {
+        std::cerr << "Failed to write the list in the transport form\n";
+        return false;
+    }
+    return true;
+}
+
+Rl_transport_decoder::Rl_transport_decoder(Rl_binary_type type,
+  size_t n_states, size_t record_bytes, Rl_transport_sink sink) noexcept
+  : type_(type), n_states_(n_states), record_bytes_(record_bytes),
+    entry_bytes_(rl_transport_entry_bytes(n_states)), sink_(std::move(sink))
+{}
+
+bool Rl_transport_decoder::decode_entries(
+  uint8_t const *in, size_t n_entries) noexcept
+{
+    records_.resize(std::min(n_entries, batch_entries_) * record_bytes_);
+    while (n_entries != 0) {
+        size_t n = std::min(n_entries, batch_entries_);
+        unpack_rl_transport_entries(
+          records_.data(), in, n_states_, record_bytes_, n);
+        digest_tree_.append(records_.data(), n * record_bytes_);
+        if (sink_.records_ && !sink_.records_(records_.data(), n)) {
+            return false;
+        }
+        in += n * entry_bytes_;
+        n_entries -= n;
+        n_decoded_ += n;
+    }
+    return true;
+}
+
+bool Rl_transport_decoder::feed(uint8_t const *data, size_t len) noexcept
+{
+    while (len != 0 && !failed_) {
+        if (!have_header_) {
+            size_t n = std::min(len, rl_transport_header_bytes - pending_.size());
+            pending_.insert(pending_.end(), data, data + n);
+            data += n;
+            len -= n;
+            if (pending_.size() < rl_transport_header_bytes) { break; }
+            failed_ = !decode_rl_transport_header(header_, pending_.data());
+            pending_.clear();
+            if (failed_) { break; }
+            if (header_.type_ != type_ || header_.n_states_ != n_states_
+                || header_.state_bits_ != Mpc_parameters::lowmc_state_bits_
+                || header_.entry_bytes_ != entry_bytes_) {
+                std::cerr << "The transport stream holds a different kind of "
+                             "list\n";
+                failed_ = true;
+                break;
+            }
+            have_header_ = true;
+            digest_tree_.clear();
+            failed_ = sink_.header_ && !sink_.header_(header_);
+            continue;
+        }
+
+        uint64_t remaining = header_.n_entries_ - n_decoded_;
+        if (!pending_.empty()) {// An entry split between two pieces
+            size_t n = std::min(len, entry_bytes_ - pending_.size());
+            pending_.insert(pending_.end(), data, data + n);
+            data += n;
+            len -= n;
+            if (pending_.size() == entry_bytes_) {
+                failed_ = !decode_entries(pending_.data(), 1);
+                pending_.clear();
+            }
+            continue;
+        }
+        if (remaining == 0) {
+            std::cerr << "The transport stream has data after its entries\n";
+            failed_ = true;
+            break;
+        }
+        size_t n_whole = static_cast<size_t>(
+          std::min<uint64_t>(len / entry_bytes_, remaining));
+        if (n_whole == 0) {
+            pending_.assign(data, data + len);
+            break;
+        }
+        failed_ = !decode_entries(data, n_whole);
+        data += n_whole * entry_bytes_;
+        len -= n_whole * entry_bytes_;
+    }
+    return !failed_;
+}
+
+bool Rl_transport_decoder::finish() noexcept
+{
+    if (failed_) { return false; }
+    if (!have_header_ || n_decoded_ != header_.n_entries_ || !pending_.empty()) {
+        std::cerr << "The transport stream is truncated\n";
+        return false;
+    }
+    if (digest_tree_.digest() != header_.digest_) {
+        std::cerr << "The transport stream does not match its digest\n";
+        return false;
+    }
+    return true;
+}
+
+bool decode_rl_transport_stream(std::istream &is,
+  Rl_transport_decoder &decoder, size_t read_bytes) noexcept
+{
+    std::vector<char> buffer(read_bytes);
+    while (is) {
+        is.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        auto n = static_cast<size_t>(is.gcount());
+        if (n != 0
+            && !decoder.feed(reinterpret_cast<uint8_t const *>(buffer.data()), n)) {
+            return false;
+        }
+    }
+    if (is.bad()) {
+        std::cerr << "Failed to read the transport stream\n";
+        return false;
+    }
+    return decoder.finish();
+}
+
+bool receive_rl_transport(std::istream &is, std::string const &filename,
+  Rl_binary_type type, size_t n_states, size_t record_bytes,
+  size_t read_bytes) noexcept
+{
+    Rl_file_writer writer;
+    Rl_transport_sink sink;
+    sink.header_ = [&](Rl_transport_header const &header) {
+        if (header.kind_ != Rl_transport_kind::list) {
+            std::cerr << "The transport stream holds a delta, not a list\n";
+            return false;
+        }
+        // The binary header can be written first, the digest is checked
+        // before the file is put in place
+        Rl_binary_header binary;
+        binary.type_ = type;
+        binary.n_states_ = static_cast<uint8_t>(n_states);
+        binary.record_bytes_ = static_cast<uint16_t>(record_bytes);
+        binary.n_entries_ = header.n_entries_;
+        std::memcpy(binary.digest_, header.digest_.data(), rl_digest_bytes);
+        uint8_t encoded[rl_binary_header_bytes];
+        encode_rl_binary_header(encoded, binary);
+        return writer.open(filename) && writer.write(encoded, sizeof(encoded));
+    };
+    sink.records_ = [&](uint8_t const *records, size_t n_entries) {
+        return writer.write(records, n_entries * record_bytes);
+    };
+    Rl_transport_decoder decoder(type, n_states, record_bytes, std::move(sink));
+    if (!decode_rl_transport_stream(is, decoder, read_bytes)) { return false; }
+    return writer.commit();
+}
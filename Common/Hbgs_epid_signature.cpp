@@ -36,18 +36,333 @@
 *                                                                              *
 *******************************************************************************/
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
 #include "Io_utils.h"
+#include "Hb_epid_rl_binary.h"
 #include "Hbgs_epid_signature.h"
 
+namespace {
+constexpr uint8_t rs_magic[8] = { 'H', 'B', 'G', 'S', '-', 'S', 'I', 'G' };
+constexpr size_t rs_state_bytes = lowmc_state_words64_bytes;
+static_assert(sizeof(Epid_arl_entry) == rs_state_bytes,
+  "The A_j entries must be held as a single state");
+
+constexpr size_t pad8(size_t len) noexcept { return (len + 7) & ~size_t(7); }
+
+// Where each part of a signature starts, and the lengths it comes from
+struct Rs_layout
+{
+    size_t srl_reference_len_;
+    size_t n_a_j_;
+    size_t proof_len_;
+    size_t str_;
+    size_t states_;// sid, r and then sst
+    size_t a_j_;
+    size_t proof_;
+    size_t total_;
+};
+
+Rs_layout rs_layout(
+  size_t srl_reference_len, size_t n_a_j, size_t proof_len) noexcept
+{
+    Rs_layout layout{};
+    layout.srl_reference_len_ = srl_reference_len;
+    layout.n_a_j_ = n_a_j;
+    layout.proof_len_ = proof_len;
+    layout.str_ = rs_header_bytes + pad8(srl_reference_len);
+    layout.states_ = layout.str_ + pad8(Mpc_parameters::nonce_size_bytes_);
+    layout.a_j_ = layout.states_ + 3 * rs_state_bytes;
+    layout.proof_ = layout.a_j_ + n_a_j * rs_state_bytes;
+    layout.total_ = layout.proof_ + proof_len;
+    return layout;
+}
+
+enum class Rs_lengths { ok, too_long, inconsistent };
+
+// The layout given by the lengths in a header. They come from outside, so
+// each is checked against max_len (the most the signature can take) before
+// it is used, so that nothing overflows, and they must add up to total.
+Rs_lengths rs_header_layout(uint8_t const *header, size_t total,
+  size_t max_len, Rs_layout &layout) noexcept
+{
+    uint64_t srl_reference_len = rl_get_le(header + 24, 4);
+    uint64_t n_a_j = rl_get_le(header + 32, 8);
+    uint64_t proof_len = rl_get_le(header + 40, 8);
+    if (total > max_len || srl_reference_len > max_len
+        || n_a_j > max_len / rs_state_bytes || proof_len > max_len) {
+        return Rs_lengths::too_long;
+    }
+    layout = rs_layout(static_cast<size_t>(srl_reference_len),
+      static_cast<size_t>(n_a_j), static_cast<size_t>(proof_len));
+    return (layout.total_ == total) ? Rs_lengths::ok
+                                    : Rs_lengths::inconsistent;
+}
+
+// The bytes left in is, or max_len if that can't be found
+size_t rs_stream_bytes(std::istream &is, size_t max_len) noexcept
+{
+    std::streampos here = is.tellg();
+    if (here == std::streampos(-1)) { return max_len; }
+    std::streampos end = is.seekg(0, std::ios::end).tellg();
+    is.clear();
+    is.seekg(here);
+    if (end == std::streampos(-1) || end < here) { return max_len; }
+    return std::min(max_len, static_cast<size_t>(end - here));
+}
+
+bool write_padded(std::ostream &os, void const *data, size_t len)
+{
+    static constexpr char zeros[8]{};
+    os.write(static_cast<char const *>(data), static_cast<std::streamsize>(len));
+    os.write(zeros, static_cast<std::streamsize>(pad8(len) - len));
+    return static_cast<bool>(os);
+}
+}// namespace
+
 Revocation_signature::Revocation_signature(std::string const &srl_file,
-  uint8_t const *str, Lowmc_state_words64_const_ptr sid,
-  Lowmc_state_words64_const_ptr sst,
+  Rl_digest const &srl_digest, uint8_t const *str,
+  Lowmc_state_words64_const_ptr sid, Lowmc_state_words64_const_ptr sst,
   Lowmc_state_words64_const_ptr r_value) noexcept
-  : srl_reference_(srl_file)
+  : srl_reference_(srl_file), srl_digest_(srl_digest)
 {
     std::memcpy(str_, str, Mpc_parameters::nonce_size_bytes_);
     std::memcpy(sid_, sid, Mpc_parameters::lowmc_state_bytes_);
     std::memcpy(cd_.sst_, sst, Mpc_parameters::lowmc_state_bytes_);
     std::memcpy(r_value_, r_value, Mpc_parameters::lowmc_state_bytes_);
 }
+
+size_t rs_wire_bytes(
+  size_t srl_reference_len, size_t n_a_j, size_t proof_len) noexcept
+{
+    return rs_layout(srl_reference_len, n_a_j, proof_len).total_;
+}
+
+size_t rs_wire_bytes(uint8_t const *header, size_t len) noexcept
+{
+    if (len < rs_header_bytes
+        || std::memcmp(header, rs_magic, sizeof(rs_magic)) != 0) {
+        return 0;
+    }
+    if (rl_get_le(header + 8, 2) != rs_version) {
+        std::cerr << "Unsupported signature version " << rl_get_le(header + 8, 2)
+                  << '\n';
+        return 0;
+    }
+    if (rl_get_le(header + 10, 2) != Mpc_parameters::lowmc_state_bits_
+        || rl_get_le(header + 12, 2) != rs_state_bytes
+        || rl_get_le(header + 14, 2) != Mpc_parameters::nonce_size_bytes_) {
+        std::cerr << "The signature is for different parameters\n";
+        return 0;
+    }
+    return static_cast<size_t>(rl_get_le(header + 16, 8));
+}
+
+Revocation_signature_view::Revocation_signature_view(
+  Revocation_signature const &rsig) noexcept
+  : srl_reference_(rsig.srl_reference()),
+    srl_digest_(rsig.srl_digest().data()), str_(rsig.str()), sid_(rsig.sid()),
+    r_value_(rsig.rv()), cd_(rsig.rev_ceck().view()), sig_(rsig.sig()),
+    siglen_(rsig.siglen())
+{}
+
+bool Revocation_signature_view::parse(uint8_t const *buf, size_t len) noexcept
+{
+    *this = Revocation_signature_view{};
+    size_t total = rs_wire_bytes(buf, len);
+    if (total == 0) { return false; }
+    if (reinterpret_cast<uintptr_t>(buf) % alignof(Word) != 0) {
+        std::cerr << "The signature buffer is not aligned\n";
+        return false;
+    }
+    Rs_layout layout{};
+    switch (rs_header_layout(buf, total, len, layout)) {
+    case Rs_lengths::too_long:
+        std::cerr << "The signature is truncated\n";
+        return false;
+    case Rs_lengths::inconsistent:
+        std::cerr << "The signature lengths are inconsistent\n";
+        return false;
+    case Rs_lengths::ok:
+        break;
+    }
+
+    srl_reference_ = std::string_view(
+      reinterpret_cast<char const *>(buf + rs_header_bytes),
+      layout.srl_reference_len_);
+    srl_digest_ = buf + 48;
+    str_ = buf + layout.str_;
+    auto const *states =
+      reinterpret_cast<Lowmc_state_words64_const_ptr>(buf + layout.states_);
+    sid_ = states;
+    r_value_ = states + lowmc_state_words64;
+    cd_.sst_ = states + 2 * lowmc_state_words64;
+    cd_.a_j_ = reinterpret_cast<Epid_arl_entry const *>(buf + layout.a_j_);
+    cd_.n_a_j_ = layout.n_a_j_;
+    sig_ = buf + layout.proof_;
+    siglen_ = layout.proof_len_;
+    return true;
+}
+
+bool Revocation_signature::print_rs(std::ostream &os) const noexcept
+{
+    uint8_t header[rs_header_bytes]{};
+    std::memcpy(header, rs_magic, sizeof(rs_magic));
+    rl_put_le(header + 8, rs_version, 2);
+    rl_put_le(header + 10, Mpc_parameters::lowmc_state_bits_, 2);
+    rl_put_le(header + 12, rs_state_bytes, 2);
+    rl_put_le(header + 14, Mpc_parameters::nonce_size_bytes_, 2);
+    rl_put_le(header + 16,
+      rs_wire_bytes(srl_reference_.size(), cd_.a_j_.size(), signature_.size()),
+      8);
+    rl_put_le(header + 24, srl_reference_.size(), 4);
+    rl_put_le(header + 32, cd_.a_j_.size(), 8);
+    rl_put_le(header + 40, signature_.size(), 8);
+    std::memcpy(header + 48, srl_digest_.data(), rl_digest_bytes);
+
+    os.write(reinterpret_cast<char const *>(header), rs_header_bytes);
+    write_padded(os, srl_reference_.data(), srl_reference_.size());
+    write_padded(os, str_, Mpc_parameters::nonce_size_bytes_);
+    write_padded(os, sid_, rs_state_bytes);
+    write_padded(os, r_value_, rs_state_bytes);
+    write_padded(os, cd_.sst_, rs_state_bytes);
+    write_padded(os, cd_.a_j_.data(), cd_.a_j_.size() * rs_state_bytes);
+    os.write(reinterpret_cast<char const *>(signature_.data()),
+      static_cast<std::streamsize>(signature_.size()));
+
+    return static_cast<bool>(os);
+}
+
+bool Revocation_signature::read_rs(std::istream &is) noexcept
+{
+    // Read as words, so that the buffer is aligned for the states
+    std::vector<Word> words(rs_header_bytes / sizeof(Word));
+    auto *buf = reinterpret_cast<uint8_t *>(words.data());
+    if (!is.read(reinterpret_cast<char *>(buf), rs_header_bytes)) {
+        return false;
+    }
+    size_t total = rs_wire_bytes(buf, rs_header_bytes);
+    if (total < rs_header_bytes) {
+        std::cerr << "read_rs: not a signature\n";
+        return false;
+    }
+    // The lengths come from the stream, so they are checked against each
+    // other and against what the stream holds (when that can be found)
+    // before the buffer is sized from them
+    size_t available = rs_header_bytes
+                       + rs_stream_bytes(is, rs_max_wire_bytes - rs_header_bytes);
+    bool const sized = (available < rs_max_wire_bytes);
+    Rs_layout layout{};
+    switch (rs_header_layout(buf, total, available, layout)) {
+    case Rs_lengths::too_long:
+        std::cerr << (sized ? "read_rs: the signature is truncated\n"
+                            : "read_rs: the signature is too long\n");
+        return false;
+    case Rs_lengths::inconsistent:
+        std::cerr << "read_rs: the signature lengths are inconsistent\n";
+        return false;
+    case Rs_lengths::ok:
+        break;
+    }
+    // If the stream's length is not known the buffer only grows as the
+    // signature arrives, so a header can't make it take more memory than
+    // there is data
+    size_t have = rs_header_bytes;
+    while (have < total) {
+        size_t want = sized ? total
+                            : std::min(total,
+                              std::max(2 * have, rs_read_chunk_bytes));
+        words.resize((want + sizeof(Word) - 1) / sizeof(Word));
+        buf = reinterpret_cast<uint8_t *>(words.data());
+        if (!is.read(reinterpret_cast<char *>(buf + have),
+              static_cast<std::streamsize>(want - have))) {
+            std::cerr << "read_rs: the signature is truncated\n";
+            return false;
+        }
+        have = want;
+    }
+    Revocation_signature_view view;
+    if (!view.parse(buf, total)) { return false; }
+    assign(view);
+
+    return true;
+}
+
+void Revocation_signature::assign(Revocation_signature_view const &view)
+{
+    srl_reference_.assign(view.srl_reference());
+    std::memcpy(srl_digest_.data(), view.srl_digest(), rl_digest_bytes);
+    std::memcpy(str_, view.str(), Mpc_parameters::nonce_size_bytes_);
+    std::memcpy(sid_, view.sid(), rs_state_bytes);
+    std::memcpy(r_value_, view.rv(), rs_state_bytes);
+    std::memcpy(cd_.sst_, view.sst(), rs_state_bytes);
+    cd_.a_j_.assign_from_buffer(
+      reinterpret_cast<uint8_t const *>(view.rev_check().a_j_),
+      view.rev_check().n_a_j_);
+    signature_.assign(view.sig(), view.sig() + view.siglen());
+}
+
+bool check_srl_digest(
+  Revocation_signature_view const &rsig, uint8_t const *srl_digest)
+{
+    if (std::memcmp(rsig.srl_digest(), srl_digest, rl_digest_bytes) == 0) {
+        return true;
+    }
+    std::cerr << "The signature was made against a different SRL\n"
+              << "  signature: ";
+    print_rl_digest(std::cerr, rsig.srl_digest());
+    std::cerr << "\n  SRL:       ";
+    print_rl_digest(std::cerr, srl_digest);
+    std::cerr << '\n';
+    return false;
+}
+
+bool print_revocation_signature(Revocation_signature const &sig,
+  std::string const &base_dir, std::string const &sig_name)
+{
+    std::string filename = make_filename(base_dir, sig_name) + '.' + rsig_file_ext;
+    std::ofstream os{ filename, std::ios::binary };
+    if (!os) {
+        std::cerr << "Unable to create the file " << filename << '\n';
+        return false;
+    }
+    if (!sig.print_rs(os) || !os.flush()) {
+        std::cerr << "Failed to write the file " << filename << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool read_revocation_signature(Revocation_signature &sig,
+  std::string const &base_dir, std::string const &sig_name)
+{
+    std::string filename = make_filename(base_dir, sig_name) + '.' + rsig_file_ext;
+    std::ifstream is{ filename, std::ios::binary };
+    if (!is) {
+        std::cerr << "Unable to open the file " << filename << '\n';
+        return false;
+    }
+    return sig.read_rs(is);
+}
+
+bool read_revocation_signature_buffer(std::vector<uint8_t> &buffer,
+  std::string const &base_dir, std::string const &sig_name)
+{
+    std::string filename = make_filename(base_dir, sig_name) + '.' + rsig_file_ext;
+    std::ifstream is{ filename, std::ios::binary | std::ios::ate };
+    if (!is) {
+        std::cerr << "Unable to open the file " << filename << '\n';
+        return false;
+    }
+    auto size = static_cast<size_t>(is.tellg());
+    is.seekg(0);
+    // The buffer comes from operator new, so it is aligned for the states
+    buffer.resize(size);
+    if (!is.read(reinterpret_cast<char *>(buffer.data()),
+          static_cast<std::streamsize>(size))) {
+        std::cerr << "Failed to read the file " << filename << '\n';
+        return false;
+    }
+    return true;
+}
@@ -43,7 +43,11 @@
 #include <string>
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "Io_utils.h"
 
 std::string make_filename(std::string const &baseDir, std::string const &name)
@@ -168,6 +172,95 @@ bool read_hex_bytes(std::istream &is, uint8_t *buf, size_t number_to_read)
     return true;
 }
 
+namespace {
+// The value of a hex digit, or 0xff
+constexpr uint8_t hex_digit_value(char c) noexcept
+{
+    if (c >= '0' && c <= '9') { return static_cast<uint8_t>(c - '0'); }
+    if (c >= 'a' && c <= 'f') { return static_cast<uint8_t>(c - 'a' + 10); }
+    if (c >= 'A' && c <= 'F') { return static_cast<uint8_t>(c - 'A' + 10); }
+    return 0xff;
+}
+
+// The two hex characters for each byte value
+struct Hex_pairs
+{
+    char pairs_[512];
+    constexpr Hex_pairs() noexcept : pairs_()
+    {
+        constexpr char digits[] = "0123456789abcdef";
+        for (int b = 0; b < 256; ++b) {
+            pairs_[2 * b] = digits[b >> 4];
+            pairs_[2 * b + 1] = digits[b & 0x0f];
+        }
+    }
+};
+constexpr Hex_pairs hex_pairs;
+
+#if defined(__SSE2__)
+// The nibble values of 16 characters, with the bits of valid set for each one
+// that is a hex digit. Characters of 0x80 and above are negative as signed
+// bytes, or too large once the offset is taken off, so they are never valid.
+inline __m128i hex_nibbles16(__m128i chars, int &valid) noexcept
+{
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)),
+      _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+    __m128i alpha = _mm_sub_epi8(
+      _mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(alpha, _mm_set1_epi8(-1)),
+      _mm_cmplt_epi8(alpha, _mm_set1_epi8(6)));
+    valid = _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit),
+      _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+// Join the pairs of nibbles (high nibble first) into bytes, in the low byte
+// of each 16-bit lane
+inline __m128i hex_join_nibbles(__m128i nibbles) noexcept
+{
+    return _mm_and_si128(
+      _mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8)),
+      _mm_set1_epi16(0x00ff));
+}
+#endif
+}// namespace
+
+void encode_hex(char *out, uint8_t const *in, size_t n_bytes) noexcept
+{
+    for (size_t i = 0; i < n_bytes; ++i) {
+        std::memcpy(out + 2 * i, hex_pairs.pairs_ + 2 * in[i], 2);
+    }
+}
+
+size_t decode_hex(uint8_t *out, char const *hex, size_t n_bytes) noexcept
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= n_bytes; i += 16) {
+        int valid_lo;
+        int valid_hi;
+        __m128i lo = hex_nibbles16(
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(hex + 2 * i)),
+          valid_lo);
+        __m128i hi = hex_nibbles16(
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(hex + 2 * i + 16)),
+          valid_hi);
+        if ((valid_lo & valid_hi) != 0xffff) { break; }// Find it below
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+          _mm_packus_epi16(hex_join_nibbles(lo), hex_join_nibbles(hi)));
+    }
+#endif
+    for (; i < n_bytes; ++i) {
+        uint8_t high = hex_digit_value(hex[2 * i]);
+        if (high == 0xff) { return 2 * i; }
+        uint8_t low = hex_digit_value(hex[2 * i + 1]);
+        if (low == 0xff) { return 2 * i + 1; }
+        out[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+
+    return 2 * n_bytes;
+}
 
 /*
 std::istream &operator>>(std::istream &is, Byte_buffer &bb)
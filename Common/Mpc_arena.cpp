@@ -0,0 +1,319 @@
+/*******************************************************************************
+ * File:        Mpc_arena.cpp
+ * Description: A session arena, the per-signature data is bump allocated from
+ *              it and released in bulk
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+#include "picnic_impl.h"
+#include "tree.h"
+}
+#include "Mpc_memory.h"
+#include "Mpc_arena.h"
+#include "Mpc_seed_trees.h"
+
+Mpc_arena::Mpc_arena(size_t block_size) noexcept
+  : first_block_size_(block_size), block_size_(block_size)
+{}
+
+Mpc_arena::~Mpc_arena() { release(); }
+
+bool Mpc_arena::add_block(size_t min_size) noexcept
+{
+    Block block;
+    block.size_ = std::max(min_size, block_size_);
+    block.base_ = static_cast<uint8_t *>(allocate_slab(block.size_));
+    if (block.base_ == nullptr) { return false; }
+    blocks_.push_back(block);
+    current_ = blocks_.size() - 1;
+    // Fewer, larger blocks as the session grows
+    block_size_ *= 2;
+    return true;
+}
+
+void *Mpc_arena::allocate(size_t size, size_t alignment) noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (;;) {
+        if (current_ < blocks_.size()) {
+            Block &block = blocks_[current_];
+            size_t offset = (block.used_ + alignment - 1) & ~(alignment - 1);
+            if (offset + size <= block.size_) {
+                uint8_t *mem = block.base_ + offset;
+                // Memory beyond dirty_ has not been used since it was mapped
+                if (offset < block.dirty_) {
+                    memset(mem, 0, std::min(block.dirty_, offset + size) - offset);
+                }
+                block.used_ = offset + size;
+                block.dirty_ = std::max(block.dirty_, block.used_);
+                return mem;
+            }
+            if (current_ + 1 < blocks_.size()) {
+                ++current_;
+                continue;
+            }
+        }
+        if (!add_block(size + alignment)) { return nullptr; }
+    }
+}
+
+bool Mpc_arena::reserve(size_t size) noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_ < blocks_.size()) {
+        Block &block = blocks_[current_];
+        if (block.size_ - block.used_ >= size) { return true; }
+        if (block.used_ == 0 && current_ + 1 == blocks_.size()) {
+            free_slab(block.base_);
+            blocks_.pop_back();
+        }
+    }
+    return add_block(size);
+}
+
+void Mpc_arena::reset() noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blocks_.size() > 1) {
+        size_t total = 0;
+        for (auto &block : blocks_) {
+            total += block.size_;
+            free_slab(block.base_);
+        }
+        blocks_.clear();
+        block_size_ = total;
+        add_block(total);
+    }
+    for (auto &block : blocks_) { block.used_ = 0; }
+    current_ = 0;
+}
+
+void Mpc_arena::release() noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &block : blocks_) { free_slab(block.base_); }
+    blocks_.clear();
+    current_ = 0;
+    block_size_ = first_block_size_;
+}
+
+size_t Mpc_arena::bytes_used() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t used = 0;
+    for (auto const &block : blocks_) { used += block.used_; }
+    return used;
+}
+
+size_t Mpc_arena::capacity() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t size = 0;
+    for (auto const &block : blocks_) { size += block.size_; }
+    return size;
+}
+
+size_t Mpc_arena::n_blocks() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.size();
+}
+
+void *arena_allocate(Mpc_arena *arena, size_t size) noexcept
+{
+    if (arena == nullptr) { return calloc(1, size); }
+    return arena->allocate(size);
+}
+
+void arena_free(Mpc_arena *arena, void *mem) noexcept
+{
+    if (arena == nullptr) { free(mem); }
+}
+
+static size_t tree_nodes(size_t numLeaves) noexcept
+{
+    size_t depth = ceil_log2(static_cast<uint32_t>(numLeaves)) + 1;
+    return ((1U << depth) - 1) - ((1U << (depth - 1)) - numLeaves);
+}
+
+size_t arena_tree_bytes(size_t numLeaves, size_t dataSize) noexcept
+{
+    // The same shape as createTree: the tree, the node pointers, the node
+    // data and then the haveNode and exists flags
+    size_t numNodes = tree_nodes(numLeaves);
+    return sizeof(tree_t) + numNodes * sizeof(uint8_t *) + numNodes * dataSize
+           + 2 * numNodes;
+}
+
+tree_t *place_tree(uint8_t *mem, size_t numLeaves, size_t dataSize) noexcept
+{
+    size_t depth = ceil_log2(static_cast<uint32_t>(numLeaves)) + 1;
+    size_t numNodes = tree_nodes(numLeaves);
+
+    auto *tree = reinterpret_cast<tree_t *>(mem);
+    mem += sizeof(tree_t);
+    tree->depth = depth;
+    tree->numNodes = numNodes;
+    tree->numLeaves = numLeaves;
+    tree->dataSize = dataSize;
+    tree->nodes = reinterpret_cast<uint8_t **>(mem);
+    mem += numNodes * sizeof(uint8_t *);
+    for (size_t i = 0; i < numNodes; i++) {
+        tree->nodes[i] = mem;
+        mem += dataSize;
+    }
+    tree->haveNode = mem;
+    mem += numNodes;
+    tree->exists = mem;
+
+    // Depending on the number of leaves, the tree may not be complete
+    memset(tree->exists + numNodes - numLeaves, 1, numLeaves);
+    for (size_t i = numNodes - numLeaves; i > 0; i--) {
+        if ((2 * i + 1 < numNodes && tree->exists[2 * i + 1] != 0)
+            || (2 * i + 2 < numNodes && tree->exists[2 * i + 2] != 0)) {
+            tree->exists[i] = 1;
+        }
+    }
+    tree->exists[0] = 1;
+
+    return tree;
+}
+
+tree_t *arena_create_tree(
+  Mpc_arena *arena, size_t numLeaves, size_t dataSize) noexcept
+{
+    if (arena == nullptr) { return createTree(numLeaves, dataSize); }
+
+    size_t size = arena_tree_bytes(numLeaves, dataSize);
+    auto *mem = static_cast<uint8_t *>(arena->allocate(size, alignof(tree_t)));
+    if (mem == nullptr) { return nullptr; }
+
+    return place_tree(mem, numLeaves, dataSize);
+}
+
+tree_t *arena_generate_seeds(Mpc_arena *arena, size_t nSeeds,
+  uint8_t *rootSeed, uint8_t *salt, size_t repIndex,
+  paramset_t *params) noexcept
+{
+    if (arena == nullptr) {
+        return generateSeeds(nSeeds, rootSeed, salt, repIndex, params);
+    }
+
+    tree_t *tree = arena_create_tree(arena, nSeeds, params->seedSizeBytes);
+    if (tree == nullptr) { return nullptr; }
+    memcpy(tree->nodes[0], rootSeed, params->seedSizeBytes);
+    tree->haveNode[0] = 1;
+    expand_seeds_x4(tree, salt, repIndex, params);
+
+    return tree;
+}
+
+void arena_free_tree(Mpc_arena *arena, tree_t *tree) noexcept
+{
+    if (arena == nullptr) { freeTree(tree); }
+}
+
+commitments_t *arena_allocate_commitments(
+  Mpc_arena *arena, paramset_t *params, size_t numCommitments) noexcept
+{
+    if (arena == nullptr) {
+        return allocateCommitments(params, numCommitments);
+    }
+
+    size_t n_commitments =
+      (numCommitments != 0) ? numCommitments : params->numMPCParties;
+    size_t round_size =
+      n_commitments * (params->digestSizeBytes + sizeof(uint8_t *));
+    auto *mem = static_cast<uint8_t *>(arena->allocate(
+      params->numMPCRounds * (sizeof(commitments_t) + round_size),
+      alignof(commitments_t)));
+    if (mem == nullptr) { return nullptr; }
+
+    auto *commitments = reinterpret_cast<commitments_t *>(mem);
+    mem += params->numMPCRounds * sizeof(commitments_t);
+    commitments->nCommitments = n_commitments;
+    for (uint32_t i = 0; i < params->numMPCRounds; i++) {
+        commitments[i].hashes = reinterpret_cast<uint8_t **>(mem);
+        mem += n_commitments * sizeof(uint8_t *);
+        for (size_t j = 0; j < n_commitments; j++) {
+            commitments[i].hashes[j] = mem;
+            mem += params->digestSizeBytes;
+        }
+    }
+
+    return commitments;
+}
+
+void arena_free_commitments(
+  Mpc_arena *arena, commitments_t *commitments) noexcept
+{
+    if (arena == nullptr) { freeCommitments(commitments); }
+}
+
+void arena_allocate_commitments2(Mpc_arena *arena, commitments_t *commitments,
+  paramset_t *params, size_t numCommitments) noexcept
+{
+    if (arena == nullptr) {
+        allocateCommitments2(commitments, params, numCommitments);
+        return;
+    }
+
+    commitments->nCommitments = numCommitments;
+    auto *mem = static_cast<uint8_t *>(arena->allocate(
+      numCommitments * (params->digestSizeBytes + sizeof(uint8_t *)),
+      alignof(uint8_t *)));
+    commitments->hashes = reinterpret_cast<uint8_t **>(mem);
+    if (mem == nullptr) { return; }
+    mem += numCommitments * sizeof(uint8_t *);
+    for (size_t i = 0; i < numCommitments; i++) {
+        commitments->hashes[i] = mem;
+        mem += params->digestSizeBytes;
+    }
+}
+
+void arena_free_commitments2(
+  Mpc_arena *arena, commitments_t *commitments) noexcept
+{
+    if (arena == nullptr) { freeCommitments2(commitments); }
+}
@@ -0,0 +1,281 @@
+/*******************************************************************************
+ * File:        Mpc_footprint.cpp
+ * Description: A model of the memory used to sign and verify, and the
+ *              measurement of the memory actually used in each phase
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <algorithm>
+#include <sys/resource.h>
+
+#include "Hbgs_param.h"
+#include "Lowmc64.h"
+#include "Mpc_memory.h"
+#include "Mpc_arena.h"
+#include "Mpc_seed_trees.h"
+#include "Mpc_streaming_tapes.h"
+#include "Mpc_repetition_stream.h"
+#include "Mpc_working_data.h"
+#include "Mpc_signature_utils.h"
+#include "Mpc_footprint.h"
+
+namespace {
+std::atomic<Mpc_memory_probe *> installed_probe{ nullptr };
+
+double to_mb(size_t bytes) noexcept
+{
+    return static_cast<double>(bytes) / (1024 * 1024);
+}
+
+size_t peak_rss_bytes() noexcept
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;// ru_maxrss is in KB
+}
+
+// An arena is never given a block smaller than this
+size_t arena_block_bytes(size_t bytes) noexcept
+{
+    return std::max(bytes, mpc_arena_block_size);
+}
+
+// Setting the peak RSS back to the current RSS is Linux specific
+bool reset_peak_rss() noexcept
+{
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (fp == nullptr) { return false; }
+    bool ok = (fputs("5", fp) >= 0);
+    return (fclose(fp) == 0) && ok;
+}
+}// namespace
+
+char const *mpc_phase_name(Mpc_phase phase) noexcept
+{
+    switch (phase) {
+    case Mpc_phase::sign_prepare:
+        return "sign_prepare";
+    case Mpc_phase::sign_repetitions:
+        return "sign_repetitions";
+    case Mpc_phase::sign_proofs:
+        return "sign_proofs";
+    case Mpc_phase::verify_prepare:
+        return "verify_prepare";
+    case Mpc_phase::verify_repetitions:
+        return "verify_repetitions";
+    case Mpc_phase::verify_challenge:
+        return "verify_challenge";
+    }
+    return "unknown";
+}
+
+size_t Mpc_memory_estimate::sign_arena_bytes() const noexcept
+{
+    // A streaming signature is written to the caller's buffer
+    return working_data_ + msgs_ + commitments_ + proof_data_
+           + (streaming_ ? 0 : signature_) + padding_;
+}
+
+size_t Mpc_memory_estimate::verify_arena_bytes() const noexcept
+{
+    return commitments_ + proof_data_ + (streaming_ ? 0 : signature_)
+           + padding_;
+}
+
+size_t Mpc_memory_estimate::phase_bytes(Mpc_phase phase) const noexcept
+{
+    // The arenas are sized when the state is set up, so they are all taken
+    // from the first phase on. If the seeds come from the same arena as the
+    // rest it is one block, no larger than the two allowed for here.
+    switch (phase) {
+    case Mpc_phase::sign_prepare:
+        return arena_block_bytes(sign_arena_bytes())
+               + arena_block_bytes(seeds_) + seed_pool_;
+    case Mpc_phase::sign_repetitions:
+        return phase_bytes(Mpc_phase::sign_prepare) + scratch_;
+    case Mpc_phase::sign_proofs:
+        return phase_bytes(Mpc_phase::sign_repetitions)
+               + (streaming_ ? signature_ : 0);
+    case Mpc_phase::verify_prepare:
+        return arena_block_bytes(verify_arena_bytes())
+               + arena_block_bytes(seeds_) + seed_pool_;
+    case Mpc_phase::verify_repetitions:
+    case Mpc_phase::verify_challenge:
+        return phase_bytes(Mpc_phase::verify_prepare) + scratch_;
+    }
+    return 0;
+}
+
+size_t Mpc_memory_estimate::peak_bytes() const noexcept
+{
+    return std::max(phase_bytes(Mpc_phase::sign_proofs),
+      phase_bytes(Mpc_phase::verify_challenge));
+}
+
+Mpc_memory_estimate mpc_memory_estimate(Mpc_param const &param,
+  paramset_t const &paramset, size_t n_workers, size_t max_step_bits,
+  size_t tape_window_bits, bool streaming) noexcept
+{
+    size_t T = paramset.numMPCRounds;
+    size_t N = paramset.numMPCParties;
+    size_t D = paramset.digestSizeBytes;
+    size_t S = paramset.seedSizeBytes;
+    size_t aux_bytes = param.aux_size_bytes_;
+
+    Mpc_memory_estimate me;
+    me.streaming_ = streaming;
+
+    // The tree of initial seeds and a tree of party seeds for each repetition
+    me.seeds_ = arena_tree_bytes(T, S);
+    me.seed_pool_ = Mpc_tree_pool::slab_bytes(T, N, S);
+
+    if (!streaming) {
+        size_t n_states =
+          param.n_inputs_ + param.n_mpc_inputs_ + param.n_outputs_;
+        me.working_data_ =
+          T * aux_bytes + T * n_states * Mpc_state_slab::state_bytes_;
+        me.msgs_ = T * sizeof(msgs_t) + T * N * (aux_bytes + sizeof(uint8_t *));
+    }
+
+    // C, then Ch and Cv, then the Merkle tree of Cv
+    me.commitments_ = T * (sizeof(commitments_t) + N * (D + sizeof(uint8_t *)))
+                      + 2 * T * (D + sizeof(uint8_t *))
+                      + arena_tree_bytes(T, D);
+
+    // As Mpc_worker_scratch: the shares, the tape window and a window of aux
+    // bits and messages for each of the commitment and proof streams
+    size_t step_bytes = (max_step_bits + 7) / 8 + 1;
+    size_t window_bytes = (tape_window_bits + 7) / 8 + 1;
+    size_t worker_bytes =
+      sizeof(Mpc_worker_scratch) + sizeof(shares_t)
+      + paramset.stateSizeBits * sizeof(uint16_t) + sizeof(Mpc_streaming_tapes)
+      + N * window_bytes + sizeof(Mpc_commitment_stream)
+      + sizeof(Mpc_proof_stream) + 2 * (N + 1) * step_bytes;
+    me.scratch_ = n_workers * worker_bytes;
+
+    // As Mpc_proof_data and Signature_data, the info buffers are allocated
+    // for the most a signature can reveal
+    size_t u = paramset.numOpenedRounds;
+    me.proof_data_ = paramset.saltSizeBytes + 2 * u * sizeof(uint16_t)
+                     + Mpc_parameters::challenge_hash_bytes_
+                     + max_tree_values(paramset) * (S + D)
+                     + T * sizeof(Proof2 *) + u * sizeof(Proof2);
+
+    // Up to 63 bytes to align each allocation: six for the working data, four
+    // for the commitments, six for the proof data, the proofs, each opened
+    // round's proof, the signature and the tree of initial seeds
+    size_t n_allocations = 6 + 4 + 6 + 1 + u + 1 + 1;
+    me.padding_ = n_allocations * 64;
+
+    me.signature_ = signature_size_estimate(param, paramset);
+    return me;
+}
+
+Mpc_memory_estimate mpc_arena_estimate(
+  Mpc_param const &param, bool streaming) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+    return mpc_memory_estimate(param, paramset, 0, 0, 0, streaming);
+}
+
+void print_memory_estimate(std::ostream &os, Mpc_memory_estimate const &me)
+{
+    os << "# memory estimate (Mb)" << (me.streaming_ ? ", streaming" : "")
+       << ": seeds " << to_mb(me.seeds_ + me.seed_pool_) << ", working data "
+       << to_mb(me.working_data_) << ", msgs " << to_mb(me.msgs_)
+       << ", commitments " << to_mb(me.commitments_) << ", proof data "
+       << to_mb(me.proof_data_ + me.padding_) << ", scratch "
+       << to_mb(me.scratch_) << ", signature " << to_mb(me.signature_)
+       << '\n';
+}
+
+Mpc_memory_probe::~Mpc_memory_probe() { uninstall(); }
+
+void Mpc_memory_probe::install() noexcept
+{
+    records_.fill(Record{});
+    installed_probe.store(this);
+    start_phase();
+}
+
+void Mpc_memory_probe::uninstall() noexcept
+{
+    Mpc_memory_probe *expected = this;
+    installed_probe.compare_exchange_strong(expected, nullptr);
+}
+
+void Mpc_memory_probe::start_phase() noexcept
+{
+    reset_slab_high_water();
+    rss_reset_ = reset_peak_rss();
+}
+
+void Mpc_memory_probe::record(Mpc_phase phase) noexcept
+{
+    Record &r = records_[static_cast<size_t>(phase)];
+    r.count_++;
+    r.slab_peak_ = std::max(r.slab_peak_, mpc_slab_high_water());
+    r.rss_peak_ = std::max(r.rss_peak_, peak_rss_bytes());
+    start_phase();
+}
+
+void Mpc_memory_probe::print(
+  std::ostream &os, Mpc_memory_estimate const *me) const
+{
+    os << "# memory by phase (Mb): estimate, slab peak, rss peak"
+       << (rss_reset_ ? "" : " (since start)") << '\n';
+    for (size_t p = 0; p < mpc_n_phases; ++p) {
+        auto phase = static_cast<Mpc_phase>(p);
+        Record const &r = records_[p];
+        if (r.count_ == 0) { continue; }
+        os << "# memory " << mpc_phase_name(phase) << ": ";
+        if (me != nullptr) {
+            os << to_mb(me->phase_bytes(phase));
+        } else {
+            os << '-';
+        }
+        os << ' ' << to_mb(r.slab_peak_) << ' ' << to_mb(r.rss_peak_) << '\n';
+    }
+}
+
+void mpc_memory_phase(Mpc_phase phase) noexcept
+{
+    Mpc_memory_probe *probe = installed_probe.load(std::memory_order_relaxed);
+    if (probe != nullptr) { probe->record(phase); }
+}
@@ -163,7 +163,8 @@ void Mpc_lowmc64::get_aux_bits(
 }
 
 void Mpc_lowmc64::set_aux_bits(
-  randomTape_t *current_tape_ptr, uint32_t &pos, uint8_t *input) const noexcept
+  randomTape_t *current_tape_ptr, uint32_t &pos,
+  uint8_t const *input) const noexcept
 {
     constexpr uint32_t last = Mpc_parameters::mpc_parties_ - 1U;
     constexpr uint32_t n = Mpc_parameters::lowmc_state_bits_;
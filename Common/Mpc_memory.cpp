@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * File:        Mpc_memory.cpp
+ * Description: Allocation of the large per-repetition slabs (random tapes,
+ *              broadcast messages) with optional huge page backing
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+
+#include "Io_utils.h"
+#include "Mpc_thread_pool.h"
+#include "Mpc_memory.h"
+
+namespace {
+constexpr size_t slab_header_size = 64;
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+enum class Slab_kind : uint32_t { heap = 0x68656170, mapped = 0x6d617070 };
+
+struct Slab_header
+{
+    size_t mapped_size_;
+    size_t size_;// As asked for, for the byte counts
+    Slab_kind kind_;
+};
+
+std::atomic<size_t> slab_bytes{ 0 };
+std::atomic<size_t> slab_high_water{ 0 };
+
+void add_slab_bytes(size_t size) noexcept
+{
+    size_t now = slab_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = slab_high_water.load(std::memory_order_relaxed);
+    while (now > peak
+           && !slab_high_water.compare_exchange_weak(
+             peak, now, std::memory_order_relaxed)) {}
+}
+
+static_assert(sizeof(Slab_header) <= slab_header_size,
+  "Slab_header must fit in the slab header");
+}// namespace
+
+bool mpc_huge_pages_enabled() noexcept
+{
+    static const bool enabled = []() {
+        std::string hp = get_environment_variable("HBGS_HUGE_PAGES", "0");
+        return !hp.empty() && hp != "0";
+    }();
+    return enabled;
+}
+
+void *allocate_slab(size_t size) noexcept
+{
+    size_t total = size + slab_header_size;
+    if (size < mpc_mapped_slab_minimum) {
+        total = (total + slab_header_size - 1) & ~(slab_header_size - 1);
+        auto *mem =
+          static_cast<uint8_t *>(aligned_alloc(slab_header_size, total));
+        if (mem == nullptr) { return nullptr; }
+        memset(mem, 0, total);
+        auto *header = reinterpret_cast<Slab_header *>(mem);
+        header->mapped_size_ = 0;
+        header->size_ = size;
+        header->kind_ = Slab_kind::heap;
+        add_slab_bytes(size);
+        return mem + slab_header_size;
+    }
+
+    bool huge = mpc_huge_pages_enabled();
+    if (huge) { total = (total + huge_page_size - 1) & ~(huge_page_size - 1); }
+    void *map = mmap(nullptr, total, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) { return nullptr; }
+#ifdef MADV_HUGEPAGE
+    if (huge) { madvise(map, total, MADV_HUGEPAGE); }
+#endif
+    auto *mem = static_cast<uint8_t *>(map);
+    auto *header = reinterpret_cast<Slab_header *>(mem);
+    header->mapped_size_ = total;
+    header->size_ = size;
+    header->kind_ = Slab_kind::mapped;
+    add_slab_bytes(size);
+    return mem + slab_header_size;
+}
+
+void free_slab(void *slab) noexcept
+{
+    if (slab == nullptr) { return; }
+    auto *mem = static_cast<uint8_t *>(slab) - slab_header_size;
+    auto *header = reinterpret_cast<Slab_header *>(mem);
+    slab_bytes.fetch_sub(header->size_, std::memory_order_relaxed);
+    if (header->kind_ == Slab_kind::mapped) {
+        munmap(mem, header->mapped_size_);
+    } else {
+        free(mem);
+    }
+}
+
+size_t mpc_slab_bytes() noexcept
+{
+    return slab_bytes.load(std::memory_order_relaxed);
+}
+
+size_t mpc_slab_high_water() noexcept
+{
+    return slab_high_water.load(std::memory_order_relaxed);
+}
+
+void reset_slab_high_water() noexcept
+{
+    slab_high_water.store(mpc_slab_bytes(), std::memory_order_relaxed);
+}
+
+void print_memory_placement(std::ostream &os)
+{
+    Mpc_thread_pool::instance().print_placement(os);
+    os << "# huge pages: " << (mpc_huge_pages_enabled() ? "on" : "off")
+       << '\n';
+}
@@ -0,0 +1,306 @@
+/*******************************************************************************
+ * File:        Mpc_repetition_stream.cpp
+ * Description: Streams for the values produced by one MPC repetition, so that
+ *              they can be committed to or written out a step at a time
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Io_utils.h"
+#include "Hbgs_param.h"
+#include "Mpc_memory.h"
+#include "Mpc_repetition_stream.h"
+
+Mpc_bit_window::Mpc_bit_window(
+  size_t n_streams, size_t max_step_bits) noexcept
+{
+    // A step can start part way through a byte
+    capacity_ = (max_step_bits + 7U) / 8U + 1U;
+    slab_ = static_cast<uint8_t *>(allocate_slab(n_streams * capacity_));
+    if (slab_ == nullptr) { return; }
+    ptrs_.resize(n_streams);
+    for (size_t i = 0; i < n_streams; ++i) { ptrs_[i] = slab_ + i * capacity_; }
+    is_initialised_ = true;
+}
+
+Mpc_bit_window::~Mpc_bit_window() { free_slab(slab_); }
+
+void Mpc_view_hash::start(paramset_t *params) noexcept
+{
+    for (auto &c : ctx_) { hash_init_x4(&c.ctx_, params->digestSizeBytes); }
+}
+
+void Mpc_view_hash::update(uint8_t *const *msgs, size_t n_bytes) noexcept
+{
+    for (size_t c = 0; c < n_contexts_; ++c) {
+        size_t i = 4 * c;
+        hash_update_x4_4(&ctx_[c].ctx_, msgs[i], msgs[i + 1], msgs[i + 2],
+          msgs[i + 3], n_bytes);
+    }
+}
+
+void Mpc_view_hash::finish(
+  uint8_t *cv, uint8_t const *mpc_input0, paramset_t *params) noexcept
+{
+    uint8_t digests[Mpc_parameters::mpc_parties_]
+                   [Mpc_parameters::digest_size_bytes_];
+    for (size_t c = 0; c < n_contexts_; ++c) {
+        size_t i = 4 * c;
+        hash_final_x4(&ctx_[c].ctx_);
+        hash_squeeze_x4_4(&ctx_[c].ctx_, digests[i], digests[i + 1],
+          digests[i + 2], digests[i + 3], params->digestSizeBytes);
+    }
+
+    HashInstance ctx;
+    HashInit(&ctx, params, HASH_PREFIX_NONE);
+    HashUpdate(&ctx, mpc_input0, params->stateSizeBytes);
+    for (size_t i = 0; i < params->numMPCParties; i++) {
+        HashUpdate(&ctx, digests[i], params->digestSizeBytes);
+    }
+    HashFinal(&ctx);
+    HashSqueeze(&ctx, cv, params->digestSizeBytes);
+}
+
+void commit_v_views(uint8_t *cv, uint8_t const *mpc_input0,
+  msgs_t const *msgs, paramset_t *params) noexcept
+{
+    Mpc_view_hash view_hash;
+    view_hash.start(params);
+    view_hash.update(msgs->msgs, numBytes(static_cast<uint32_t>(msgs->pos)));
+    view_hash.finish(cv, mpc_input0, params);
+}
+
+void Mpc_aux_commitment::start(
+  uint8_t const *seed, paramset_t *params) noexcept
+{
+    HashInit(&ctx_, params, HASH_PREFIX_NONE);
+    HashUpdate(&ctx_, seed, params->seedSizeBytes);
+}
+
+void Mpc_aux_commitment::update(uint8_t const *aux, size_t n_bytes) noexcept
+{
+    HashUpdate(&ctx_, aux, n_bytes);
+}
+
+void Mpc_aux_commitment::finish(uint8_t *digest, uint8_t const *salt,
+  uint16_t t, uint16_t j, paramset_t *params) noexcept
+{
+    HashUpdate(&ctx_, salt, params->saltSizeBytes);
+    HashUpdateIntLE(&ctx_, t);
+    HashUpdateIntLE(&ctx_, j);
+    HashFinal(&ctx_);
+    HashSqueeze(&ctx_, digest, params->digestSizeBytes);
+}
+
+void commit_c_aux(uint8_t *digest, uint8_t const *seed, uint8_t const *aux,
+  size_t aux_size_bytes, uint8_t const *salt, uint16_t t, uint16_t j,
+  paramset_t *params) noexcept
+{
+    Mpc_aux_commitment commitment;
+    commitment.start(seed, params);
+    commitment.update(aux, aux_size_bytes);
+    commitment.finish(digest, salt, t, j, params);
+}
+
+Mpc_commitment_stream::Mpc_commitment_stream(
+  size_t max_step_bits, size_t msgs_bytes) noexcept
+  : msgs_bytes_(msgs_bytes), aux_window_(1, max_step_bits),
+    msgs_window_(Mpc_parameters::mpc_parties_, max_step_bits)
+{
+    if (!aux_window_.is_initialised_ || !msgs_window_.is_initialised_) {
+        return;
+    }
+    aux_bits_ = aux_window_.buffer(0);
+    msgs_window_state_.msgs = msgs_window_.buffers();
+    msgs_ = &msgs_window_state_;
+    is_initialised_ = true;
+}
+
+void Mpc_commitment_stream::start(
+  uint8_t const *last_party_seed, paramset_t *params) noexcept
+{
+    aux_window_.reset();
+    msgs_window_.reset();
+    aux_pos_ = 0;
+    msgs_window_state_.pos = 0;
+    msgs_window_state_.unopened = -1;
+    unopened_msgs_ = nullptr;
+    commit_aux_ = (last_party_seed != nullptr);
+    if (commit_aux_) { aux_commitment_.start(last_party_seed, params); }
+    view_hash_.start(params);
+}
+
+void Mpc_commitment_stream::set_unopened(
+  size_t party, uint8_t const *unopened_msgs) noexcept
+{
+    msgs_window_state_.unopened = static_cast<int>(party);
+    unopened_msgs_ = unopened_msgs;
+    refill_unopened();
+}
+
+// The window for the unopened party holds the proof's messages from the
+// first byte that has not been flushed
+void Mpc_commitment_stream::refill_unopened() noexcept
+{
+    size_t from = msgs_window_.flushed_bytes();
+    size_t n_bytes = std::min(msgs_window_.capacity(), msgs_bytes_ - from);
+    std::memcpy(msgs_window_.buffer(
+                  static_cast<size_t>(msgs_window_state_.unopened)),
+      unopened_msgs_ + from, n_bytes);
+}
+
+void Mpc_commitment_stream::step_done() noexcept
+{
+    aux_pos_ = static_cast<uint32_t>(aux_window_.flush(
+      aux_pos_, [this](uint8_t *const *aux, size_t n_bytes) {
+          if (commit_aux_) { aux_commitment_.update(aux[0], n_bytes); }
+      }));
+    msgs_window_state_.pos = msgs_window_.flush(msgs_window_state_.pos,
+      [this](uint8_t *const *msgs, size_t n_bytes) {
+          view_hash_.update(msgs, n_bytes);
+      });
+    if (unopened_msgs_ != nullptr) { refill_unopened(); }
+}
+
+void Mpc_commitment_stream::finish_aux(uint8_t *digest, uint8_t const *salt,
+  uint16_t t, uint16_t j, paramset_t *params) noexcept
+{
+    aux_window_.finish(aux_pos_, [this](uint8_t *const *aux, size_t n_bytes) {
+        aux_commitment_.update(aux[0], n_bytes);
+    });
+    aux_commitment_.finish(digest, salt, t, j, params);
+}
+
+void Mpc_commitment_stream::finish_view(
+  uint8_t *cv, uint8_t const *mpc_input0, paramset_t *params) noexcept
+{
+    msgs_window_.finish(msgs_window_state_.pos,
+      [this](uint8_t *const *msgs, size_t n_bytes) {
+          view_hash_.update(msgs, n_bytes);
+      });
+    view_hash_.finish(cv, mpc_input0, params);
+}
+
+Mpc_proof_stream::Mpc_proof_stream(size_t max_step_bits) noexcept
+  : aux_window_(1, max_step_bits),
+    msgs_window_(Mpc_parameters::mpc_parties_, max_step_bits)
+{
+    if (!aux_window_.is_initialised_ || !msgs_window_.is_initialised_) {
+        return;
+    }
+    aux_bits_ = aux_window_.buffer(0);
+    msgs_window_state_.msgs = msgs_window_.buffers();
+    msgs_ = &msgs_window_state_;
+    is_initialised_ = true;
+}
+
+void Mpc_proof_stream::start(Mpc_proof_destination const &dest) noexcept
+{
+    dest_ = dest;
+    aux_window_.reset();
+    msgs_window_.reset();
+    aux_pos_ = 0;
+    msgs_window_state_.pos = 0;
+    msgs_window_state_.unopened = -1;
+    n_states_ = 0;
+}
+
+Word *Mpc_proof_stream::mpc_input(size_t i) noexcept
+{
+    assertm(n_states_ < max_step_states_,
+      "Mpc_proof_stream: too many states in one step");
+    state_dest_[n_states_] =
+      dest_.mpc_inputs_ + i * Mpc_parameters::lowmc_state_bytes_;
+    std::memset(states_[n_states_], 0, lowmc_state_words64_bytes);
+    return states_[n_states_++];
+}
+
+Word *Mpc_proof_stream::output(size_t i) noexcept
+{
+    assertm(n_states_ < max_step_states_,
+      "Mpc_proof_stream: too many states in one step");
+    state_dest_[n_states_] =
+      dest_.outputs_ + i * Mpc_parameters::lowmc_state_bytes_;
+    std::memset(states_[n_states_], 0, lowmc_state_words64_bytes);
+    return states_[n_states_++];
+}
+
+void Mpc_proof_stream::copy_states() noexcept
+{
+    for (size_t s = 0; s < n_states_; ++s) {
+        std::memcpy(
+          state_dest_[s], states_[s], Mpc_parameters::lowmc_state_bytes_);
+    }
+    n_states_ = 0;
+}
+
+// The sinks are called before the flushed byte count is updated, so it gives
+// where the bytes go in the proof
+auto Mpc_proof_stream::aux_sink() noexcept
+{
+    return [this](uint8_t *const *aux, size_t n_bytes) {
+        if (dest_.aux_ != nullptr) {
+            std::memcpy(
+              dest_.aux_ + aux_window_.flushed_bytes(), aux[0], n_bytes);
+        }
+    };
+}
+
+auto Mpc_proof_stream::msgs_sink() noexcept
+{
+    return [this](uint8_t *const *msgs, size_t n_bytes) {
+        std::memcpy(dest_.msgs_ + msgs_window_.flushed_bytes(),
+          msgs[dest_.party_], n_bytes);
+    };
+}
+
+void Mpc_proof_stream::step_done() noexcept
+{
+    copy_states();
+    aux_pos_ = static_cast<uint32_t>(aux_window_.flush(aux_pos_, aux_sink()));
+    msgs_window_state_.pos =
+      msgs_window_.flush(msgs_window_state_.pos, msgs_sink());
+}
+
+void Mpc_proof_stream::finish() noexcept
+{
+    copy_states();
+    aux_window_.finish(aux_pos_, aux_sink());
+    msgs_window_.finish(msgs_window_state_.pos, msgs_sink());
+}
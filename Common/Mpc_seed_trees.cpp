@@ -0,0 +1,207 @@
+/*******************************************************************************
+ * File:        Mpc_seed_trees.cpp
+ * Description: Seed trees for all of the repetitions held together, and
+ *              the seed expansion using the x4 Keccak
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+#include "picnic_impl.h"
+#include "tree.h"
+#include "hash.h"
+#include "kdf_shake.h"
+}
+#include "Mpc_memory.h"
+#include "Mpc_arena.h"
+#include "Mpc_seed_trees.h"
+
+namespace {
+constexpr size_t tree_alignment = 64;
+
+// Hash the n (at most four) nodes in batch and set their children, as the
+// loop body of expandSeeds. Unused lanes repeat the first node.
+void expand_nodes_x4(tree_t *tree, size_t const *batch, size_t n,
+  uint8_t const *salt, size_t repIndex, paramset_t *params) noexcept
+{
+    size_t seed_bytes = params->seedSizeBytes;
+
+    hash_context_x4 ctx;
+    hash_init_prefix_x4(&ctx, params->digestSizeBytes, HASH_PREFIX_1);
+    uint8_t const *seeds[4];
+    uint16_t nodes[4];
+    for (size_t k = 0; k < 4; ++k) {
+        size_t i = batch[k < n ? k : 0];
+        seeds[k] = tree->nodes[i];
+        nodes[k] = static_cast<uint16_t>(i);
+    }
+    hash_update_x4(&ctx, seeds, seed_bytes);
+    hash_update_x4_1(&ctx, salt, params->saltSizeBytes);
+    hash_update_x4_uint16_le(&ctx, static_cast<uint16_t>(repIndex));
+    hash_update_x4_uint16s_le(&ctx, nodes);
+    hash_final_x4(&ctx);
+
+    uint8_t digests[4][2 * MAX_SEED_SIZE_BYTES];
+    uint8_t *out[4] = { digests[0], digests[1], digests[2], digests[3] };
+    hash_squeeze_x4(&ctx, out, 2 * seed_bytes);
+
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = batch[k];
+        size_t left = 2 * i + 1;
+        size_t right = 2 * i + 2;
+        if (tree->haveNode[left] == 0) {
+            memcpy(tree->nodes[left], digests[k], seed_bytes);
+            tree->haveNode[left] = 1;
+        }
+        // The last non-leaf node only has a left child when there are an odd
+        // number of leaves
+        if (right < tree->numNodes && tree->exists[right] != 0
+            && tree->haveNode[right] == 0) {
+            memcpy(tree->nodes[right], digests[k] + seed_bytes, seed_bytes);
+            tree->haveNode[right] = 1;
+        }
+    }
+}
+
+// Each tree of the pool starts on a cache line
+size_t tree_stride(size_t numLeaves, size_t dataSize) noexcept
+{
+    size_t stride = arena_tree_bytes(numLeaves, dataSize);
+    return (stride + tree_alignment - 1) / tree_alignment * tree_alignment;
+}
+
+size_t trees_header(size_t n_trees) noexcept
+{
+    size_t header = n_trees * sizeof(tree_t *);
+    return (header + tree_alignment - 1) / tree_alignment * tree_alignment;
+}
+}// namespace
+
+void expand_seeds_x4(tree_t *tree, uint8_t const *salt, size_t repIndex,
+  paramset_t *params) noexcept
+{
+    if (tree->numNodes < 2) { return; }
+    size_t last_non_leaf = (tree->numNodes - 2) / 2;
+
+    // Level d holds nodes 2^d - 1 to 2^(d+1) - 2
+    for (size_t first = 0; first <= last_non_leaf; first = 2 * first + 1) {
+        size_t last = std::min(2 * first, last_non_leaf);
+        size_t batch[4];
+        size_t n = 0;
+        for (size_t i = first; i <= last; i++) {
+            if (tree->haveNode[i] == 0) { continue; }
+            batch[n++] = i;
+            if (n == 4) {
+                expand_nodes_x4(tree, batch, n, salt, repIndex, params);
+                n = 0;
+            }
+        }
+        if (n > 0) { expand_nodes_x4(tree, batch, n, salt, repIndex, params); }
+    }
+}
+
+Mpc_tree_pool::~Mpc_tree_pool() { release(); }
+
+void Mpc_tree_pool::release() noexcept
+{
+    free_slab(slab_);
+    slab_ = nullptr;
+    trees_ = nullptr;
+    capacity_ = 0;
+    n_trees_ = 0;
+}
+
+size_t Mpc_tree_pool::slab_bytes(
+  size_t n_trees, size_t numLeaves, size_t dataSize) noexcept
+{
+    return trees_header(n_trees) + n_trees * tree_stride(numLeaves, dataSize);
+}
+
+bool Mpc_tree_pool::reserve(
+  size_t n_trees, size_t numLeaves, size_t dataSize) noexcept
+{
+    if (slab_ != nullptr && n_trees <= capacity_ && numLeaves == n_leaves_
+        && dataSize == data_size_) {
+        n_trees_ = n_trees;
+        return true;
+    }
+    release();
+
+    size_t stride = tree_stride(numLeaves, dataSize);
+    size_t header = trees_header(n_trees);
+    slab_ = static_cast<uint8_t *>(
+      allocate_slab(slab_bytes(n_trees, numLeaves, dataSize)));
+    if (slab_ == nullptr) { return false; }
+
+    trees_ = reinterpret_cast<tree_t **>(slab_);
+    uint8_t *mem = slab_ + header;
+    for (size_t i = 0; i < n_trees; ++i) {
+        trees_[i] = place_tree(mem, numLeaves, dataSize);
+        mem += stride;
+    }
+    capacity_ = n_trees;
+    n_trees_ = n_trees;
+    n_leaves_ = numLeaves;
+    data_size_ = dataSize;
+    return true;
+}
+
+tree_t *Mpc_tree_pool::empty_tree(size_t i) noexcept
+{
+    // The node data is contiguous, clear it so nothing is left from the last
+    // time the tree was used
+    tree_t *tree = trees_[i];
+    memset(tree->nodes[0], 0, tree->numNodes * tree->dataSize);
+    memset(tree->haveNode, 0, tree->numNodes);
+    return tree;
+}
+
+tree_t *Mpc_tree_pool::generate_seeds(size_t i, uint8_t const *rootSeed,
+  uint8_t const *salt, size_t repIndex, paramset_t *params) noexcept
+{
+    // Every node is written as the seeds are expanded
+    tree_t *tree = trees_[i];
+    memset(tree->haveNode, 0, tree->numNodes);
+    memcpy(tree->nodes[0], rootSeed, params->seedSizeBytes);
+    tree->haveNode[0] = 1;
+    expand_seeds_x4(tree, salt, repIndex, params);
+    return tree;
+}
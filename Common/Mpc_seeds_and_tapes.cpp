@@ -38,6 +38,7 @@
 *******************************************************************************/
 
 #include <iostream>
+#include <atomic>
 
 #include "picnic.h"
 extern "C" {
@@ -48,120 +49,153 @@ extern "C" {
 #include "Mpc_parameters.h"
 #include "Mpc_utils.h"
 #include "Mpc_signature_utils.h"
+#include "Mpc_thread_pool.h"
 #include "Mpc_seeds_and_tapes.h"
 
-Signing_seeds_and_tapes::Signing_seeds_and_tapes(
-  size_t tape_size_bytes, uint8_t *salt, tree_t *iSeedsTree) noexcept
-  : iSeedsTree_(iSeedsTree)
+Signing_seeds_and_tapes::Signing_seeds_and_tapes(uint8_t *salt,
+  tree_t *iSeedsTree, Mpc_arena *arena, Mpc_tree_pool *seed_trees) noexcept
+  : iSeedsTree_(iSeedsTree), arena_(arena), seed_trees_(seed_trees)
 {
 
     iSeeds_ = getLeaves(iSeedsTree_);
 
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
-    tapes_ = static_cast<randomTape_t *>(
-      malloc(paramset.numMPCRounds * sizeof(randomTape_t)));
-    if (tapes_ == nullptr) { return; }
-    seeds_ =
-      static_cast<tree_t **>(malloc(paramset.numMPCRounds * sizeof(tree_t *)));
-    if (seeds_ == nullptr) { return; }
-    for (uint32_t t = 0; t < paramset.numMPCRounds; t++) {
-        seeds_[t] =
-          generateSeeds(paramset.numMPCParties, iSeeds_[t], salt, t, &paramset);
-        create_random_tapes_times4(&tapes_[t],
-          getLeaves(seeds_[t]),
-          salt,
-          t,
-          tape_size_bytes,
-          &paramset);
+    if (seed_trees_ != nullptr) {
+        if (!seed_trees_->reserve(paramset.numMPCRounds,
+              paramset.numMPCParties, paramset.seedSizeBytes)) {
+            seed_trees_ = nullptr;
+            return;
+        }
+        seeds_ = seed_trees_->trees();
+    } else {
+        seeds_ = static_cast<tree_t **>(
+          arena_allocate(arena_, paramset.numMPCRounds * sizeof(tree_t *)));
+        if (seeds_ == nullptr) { return; }
     }
-    is_initialised = true;
+    // Each worker expands the seeds for its own block of repetitions. The
+    // tapes are squeezed from these seeds as each repetition is simulated.
+    std::atomic<bool> seeds_ok{ true };
+    Mpc_thread_pool::instance().parallel_for(paramset.numMPCRounds,
+      [&](size_t begin, size_t end, [[maybe_unused]] size_t worker) {
+          for (size_t t = begin; t < end; t++) {
+              if (seed_trees_ != nullptr) {
+                  seed_trees_->generate_seeds(
+                    t, iSeeds_[t], salt, t, &paramset);
+                  continue;
+              }
+              seeds_[t] = arena_generate_seeds(arena_,
+                paramset.numMPCParties, iSeeds_[t], salt, t, &paramset);
+              if (seeds_[t] == nullptr) { seeds_ok = false; }
+          }
+      });
+    is_initialised = seeds_ok;
 }
 
 Signing_seeds_and_tapes::~Signing_seeds_and_tapes()
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        freeRandomTape(&tapes_[t]);
-        freeTree(seeds_[t]);
+    if (seeds_ != nullptr && seed_trees_ == nullptr) {
+        for (size_t t = 0; t < paramset.numMPCRounds; t++) {
+            arena_free_tree(arena_, seeds_[t]);
+        }
+        arena_free(arena_, seeds_);
     }
-    free(tapes_);
-    free(seeds_);
-    freeTree(iSeedsTree_);
+    arena_free_tree(arena_, iSeedsTree_);
 }
 
 Verification_seeds_and_tapes::Verification_seeds_and_tapes(
-  size_t tape_size_bytes, Signature_data const &sig_data) noexcept
+  Mpc_proof_data const &pd, std::vector<Mpc_proof_view> const &proofs,
+  Mpc_arena *arena, Mpc_tree_pool *seed_trees) noexcept
+  : arena_(arena), seed_trees_(seed_trees)
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
 
     //=========================================================================
     // Build the iSeeds tree
-    iSeedsTree_ = createTree(paramset.numMPCRounds, paramset.seedSizeBytes);
+    iSeedsTree_ = arena_create_tree(
+      arena_, paramset.numMPCRounds, paramset.seedSizeBytes);
     if (iSeedsTree_ == nullptr) {
         std::cerr << "Unable to allocate memory for the iSeedsTree\n";
         return;
     }
-    int ret = reconstructSeeds(iSeedsTree_, sig_data.mpc_pd_.challengeC_,
-      paramset.numOpenedRounds, sig_data.mpc_pd_.iSeedInfo_,
-      sig_data.mpc_pd_.iSeedInfoLen_, sig_data.mpc_pd_.salt_, 0, &paramset);
+    int ret = reconstructSeeds(iSeedsTree_, pd.challengeC_,
+      paramset.numOpenedRounds, pd.iSeedInfo_,
+      pd.iSeedInfoLen_, pd.salt_, 0, &paramset);
     if (ret != 0) {
         std::cerr << "Unable to recontruct the seeds\n";
         return;
     }
     //=========================================================================
-    // Populate seeds and tapes with values from the signature
-    seeds_ =
-      static_cast<tree_t **>(calloc(paramset.numMPCRounds, sizeof(tree_t *)));
-    if (seeds_ == nullptr) { return; }
-    tapes_ = static_cast<randomTape_t *>(
-      malloc(paramset.numMPCRounds * sizeof(randomTape_t)));
-    if (tapes_ == nullptr) { return; }
-    for (uint16_t t = 0; t < paramset.numMPCRounds; t++) {
-        if (!contains(
-              sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
-            // Expand iSeed[t] to seeds for each parties, using a seed tree
-            // These are the opened rounds.
-            seeds_[t] = generateSeeds(paramset.numMPCParties,
-              getLeaf(iSeedsTree_, t),
-              sig_data.mpc_pd_.salt_,
-              t,
-              &paramset);
-        } else {
-            // We don't have the initial seed for the round, but instead a
-            // seed for each unopened party
-            seeds_[t] =
-              createTree(paramset.numMPCParties, paramset.seedSizeBytes);
-            int P_index = indexOf(
-              sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t);
-            uint16_t hideList[1];
-            hideList[0] = sig_data.mpc_pd_.challengeP_[P_index];
-            ret = reconstructSeeds(seeds_[t],
-              hideList,
-              1,
-              sig_data.proofs_[t]->seedInfo_,
-              sig_data.proofs_[t]->seedInfoLen_,
-              sig_data.mpc_pd_.salt_,
-              t,
-              &paramset);
-            if (ret != 0) {
-                std::cerr << "Failed to reconstruct seeds for round " << t
-                          << '\n';
-                return;
-            }
+    // Populate the seeds with values from the signature
+    if (seed_trees_ != nullptr) {
+        if (!seed_trees_->reserve(paramset.numMPCRounds,
+              paramset.numMPCParties, paramset.seedSizeBytes)) {
+            seed_trees_ = nullptr;
+            return;
         }
-        // Compute random tapes for all parties.  One party for each
-        // repitition challengeC will have a bogus seed; but we won't use
-        // that party's random tape.
-        create_random_tapes(&tapes_[t],
-          getLeaves(seeds_[t]),
-          sig_data.mpc_pd_.salt_,
-          t,
-          tape_size_bytes,
-          &paramset);
+        seeds_ = seed_trees_->trees();
+    } else {
+        seeds_ = static_cast<tree_t **>(
+          arena_allocate(arena_, paramset.numMPCRounds * sizeof(tree_t *)));
+        if (seeds_ == nullptr) { return; }
     }
+    std::atomic<bool> seeds_ok{ true };
+    Mpc_thread_pool::instance().parallel_for(paramset.numMPCRounds,
+      [&](size_t begin, size_t end, [[maybe_unused]] size_t worker) {
+          for (size_t t = begin; t < end; t++) {
+              if (!contains(
+                    pd.challengeC_, paramset.numOpenedRounds, t)) {
+                  // Expand iSeed[t] to seeds for each parties, using a seed
+                  // tree. These are the opened rounds.
+                  if (seed_trees_ != nullptr) {
+                      seed_trees_->generate_seeds(t, getLeaf(iSeedsTree_, t),
+                        pd.salt_, t, &paramset);
+                      continue;
+                  }
+                  seeds_[t] = arena_generate_seeds(arena_,
+                    paramset.numMPCParties,
+                    getLeaf(iSeedsTree_, t),
+                    pd.salt_,
+                    t,
+                    &paramset);
+                  if (seeds_[t] == nullptr) { seeds_ok = false; }
+              } else {
+                  // We don't have the initial seed for the round, but instead
+                  // a seed for each unopened party
+                  seeds_[t] = (seed_trees_ != nullptr)
+                                ? seed_trees_->empty_tree(t)
+                                : arena_create_tree(arena_,
+                                  paramset.numMPCParties,
+                                  paramset.seedSizeBytes);
+                  if (seeds_[t] == nullptr) {
+                      seeds_ok = false;
+                      continue;
+                  }
+                  int P_index = indexOf(
+                    pd.challengeC_, paramset.numOpenedRounds, t);
+                  uint16_t hideList[1];
+                  hideList[0] = pd.challengeP_[P_index];
+                  // picnic does not change the seed information
+                  int rs = reconstructSeeds(seeds_[t],
+                    hideList,
+                    1,
+                    const_cast<uint8_t *>(proofs[t].seed_info_),
+                    proofs[t].seed_info_len_,
+                    pd.salt_,
+                    t,
+                    &paramset);
+                  if (rs != 0) {
+                      std::cerr << "Failed to reconstruct seeds for round " << t
+                                << '\n';
+                      seeds_ok = false;
+                  }
+              }
+          }
+      });
+    if (!seeds_ok) { return; }
 
     is_initialised_ = true;
 }
@@ -170,11 +204,11 @@ Verification_seeds_and_tapes::~Verification_seeds_and_tapes()
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        freeRandomTape(&tapes_[t]);
-        freeTree(seeds_[t]);
+    if (seeds_ != nullptr && seed_trees_ == nullptr) {
+        for (size_t t = 0; t < paramset.numMPCRounds; t++) {
+            arena_free_tree(arena_, seeds_[t]);
+        }
+        arena_free(arena_, seeds_);
     }
-    free(tapes_);
-    free(seeds_);
-    freeTree(iSeedsTree_);
+    arena_free_tree(arena_, iSeedsTree_);
 }
@@ -39,7 +39,10 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <vector>
+#include <new>
 
 #include "Io_utils.h"
 
@@ -54,25 +57,26 @@ extern "C" {
 #include "Mpc_utils.h"
 #include "Mpc_signature_utils.h"
 
-Mpc_proof_data::Mpc_proof_data() noexcept
+Mpc_proof_data::Mpc_proof_data(Mpc_arena *arena) noexcept : arena_(arena)
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
 
-    salt_ = static_cast<uint8_t *>(malloc(paramset.saltSizeBytes));
+    salt_ =
+      static_cast<uint8_t *>(arena_allocate(arena_, paramset.saltSizeBytes));
     if (salt_ == nullptr) { return; }
     iSeedInfo_ = nullptr;
     iSeedInfoLen_ = 0;
     cvInfo_ = nullptr;// Sign/verify code sets it
     cvInfoLen_ = 0;
     challengeC_ = static_cast<uint16_t *>(
-      malloc(paramset.numOpenedRounds * sizeof(uint16_t)));
+      arena_allocate(arena_, paramset.numOpenedRounds * sizeof(uint16_t)));
     if (challengeC_ == nullptr) { return; }
     challengeP_ = static_cast<uint16_t *>(
-      malloc(paramset.numOpenedRounds * sizeof(uint16_t)));
+      arena_allocate(arena_, paramset.numOpenedRounds * sizeof(uint16_t)));
     if (challengeP_ == nullptr) { return; }
-    challengeHash_ =
-      static_cast<uint8_t *>(malloc(Mpc_parameters::challenge_hash_bytes_));
+    challengeHash_ = static_cast<uint8_t *>(
+      arena_allocate(arena_, Mpc_parameters::challenge_hash_bytes_));
     if (challengeHash_ == nullptr) { return; }
 
     is_initialised_ = true;
@@ -80,91 +84,161 @@ Mpc_proof_data::Mpc_proof_data() noexcept
 
 Mpc_proof_data::~Mpc_proof_data()
 {
-    free(salt_);
-    free(iSeedInfo_);
-    free(cvInfo_);
-    free(challengeC_);
-    free(challengeP_);
-    free(challengeHash_);
+    arena_free(arena_, salt_);
+    arena_free(arena_, iSeedInfo_);
+    arena_free(arena_, cvInfo_);
+    arena_free(arena_, challengeC_);
+    arena_free(arena_, challengeP_);
+    arena_free(arena_, challengeHash_);
+}
+
+bool Mpc_proof_data::reserve_info(
+  size_t iSeedInfoLen, size_t cvInfoLen) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    // Allow for the most a signature can reveal, so that the buffers are only
+    // allocated once (and an arena sized for a signature is not outgrown)
+    size_t n_values = max_tree_values(paramset);
+    if (iSeedInfo_ == nullptr || iSeedInfoLen > iSeedInfoCapacity_) {
+        size_t capacity =
+          std::max(iSeedInfoLen, n_values * paramset.seedSizeBytes);
+        arena_free(arena_, iSeedInfo_);
+        iSeedInfo_ = static_cast<uint8_t *>(arena_allocate(arena_, capacity));
+        iSeedInfoCapacity_ = (iSeedInfo_ == nullptr) ? 0 : capacity;
+    }
+    if (cvInfo_ == nullptr || cvInfoLen > cvInfoCapacity_) {
+        size_t capacity =
+          std::max(cvInfoLen, n_values * paramset.digestSizeBytes);
+        arena_free(arena_, cvInfo_);
+        cvInfo_ = static_cast<uint8_t *>(arena_allocate(arena_, capacity));
+        cvInfoCapacity_ = (cvInfo_ == nullptr) ? 0 : capacity;
+    }
+
+    return iSeedInfo_ != nullptr && cvInfo_ != nullptr;
 }
 
 // Based on picnic proof2_t
 Proof2::Proof2(Mpc_param const &param)
+  : inputs_(param.n_inputs_, nullptr), mpc_inputs_(param.n_mpc_inputs_, nullptr),
+    outputs_(param.n_outputs_, nullptr)
 {
-    // paramset_t paramset;
-    // get_param_set(get_picnic_parameter_set_id(), &paramset);
-    aux_ = static_cast<uint8_t *>(calloc(1, param.aux_size_bytes_));
-    if (aux_ == nullptr) { return; }
-    C_ = static_cast<uint8_t *>(malloc(Mpc_parameters::digest_size_bytes_));
-    if (C_ == nullptr) { return; }
-    msgs_ = static_cast<uint8_t *>(calloc(1, param.aux_size_bytes_));
-    if (msgs_ == nullptr) { return; }
-
-    bool allocations_ok{ true };
-    inputs_.resize(param.n_inputs_);
-    for (size_t i = 0; i < param.n_inputs_; ++i) {
-        inputs_[i] =
-          static_cast<uint8_t *>(calloc(1, Mpc_parameters::lowmc_state_bytes_));
-        if (inputs_[i] == nullptr) {
-            allocations_ok = false;
-            break;
-        }
+    is_initialised_ = true;
+}
+
+void Proof2::bind(uint8_t *signature, Proof_offsets const &po,
+  size_t seed_info_len) noexcept
+{
+    seedInfo_ = signature + po.seed_info_;
+    seedInfoLen_ = seed_info_len;
+    aux_ = po.has_aux_ ? signature + po.aux_ : nullptr;
+    msgs_ = signature + po.msgs_;
+    states_ = signature + po.inputs_;
+    uint8_t *state = states_;
+    for (auto &m : inputs_) {
+        m = state;
+        state += Mpc_parameters::lowmc_state_bytes_;
     }
-    if (!allocations_ok) { return; }
-
-    mpc_inputs_.resize(param.n_mpc_inputs_);
-    for (size_t i = 0; i < param.n_mpc_inputs_; ++i) {
-        mpc_inputs_[i] =
-          static_cast<uint8_t *>(calloc(1, Mpc_parameters::lowmc_state_bytes_));
-        if (mpc_inputs_[i] == nullptr) {
-            allocations_ok = false;
-            break;
-        }
+    for (auto &m : mpc_inputs_) {
+        m = state;
+        state += Mpc_parameters::lowmc_state_bytes_;
     }
-    if (!allocations_ok) { return; }
-
-    outputs_.resize(param.n_outputs_);
-    for (size_t i = 0; i < param.n_outputs_; ++i) {
-        outputs_[i] =
-          static_cast<uint8_t *>(calloc(1, Mpc_parameters::lowmc_state_bytes_));
-        if (outputs_[i] == nullptr) {
-            allocations_ok = false;
-            break;
-        }
+    for (auto &m : outputs_) {
+        m = state;
+        state += Mpc_parameters::lowmc_state_bytes_;
     }
+    C_ = signature + po.C_;
+}
 
-    if (!allocations_ok) { return; }
-
-    is_initialised_ = true;
+Mpc_proof_view Proof2::view(bool with_aux) const noexcept
+{
+    Mpc_proof_view pv;
+    pv.seed_info_ = seedInfo_;
+    pv.seed_info_len_ = seedInfoLen_;
+    pv.aux_ = with_aux ? aux_ : nullptr;
+    pv.msgs_ = msgs_;
+    pv.inputs_ = states_;
+    pv.mpc_inputs_ =
+      pv.inputs_ + inputs_.size() * Mpc_parameters::lowmc_state_bytes_;
+    pv.outputs_ = pv.mpc_inputs_
+                  + mpc_inputs_.size() * Mpc_parameters::lowmc_state_bytes_;
+    pv.C_ = C_;
+    return pv;
 }
 
-Proof2::~Proof2()
+void Signature_layout::set(
+  Mpc_proof_data const &pd, Mpc_param const &param) noexcept
 {
-    free(seedInfo_);
-    free(aux_);
-    free(C_);
-    free(msgs_);
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
 
-    for (auto &m : inputs_) { free(m); }
+    uint16_t hideList[1] = { 0 };
+    seed_info_len_ =
+      revealSeedsSize(paramset.numMPCParties, hideList, 1, &paramset);
 
-    for (auto &m : mpc_inputs_) { free(m); }
+    size_t offset =
+      Mpc_parameters::challenge_hash_bytes_ + paramset.saltSizeBytes;
+    iSeedInfo_ = offset;
+    offset += pd.iSeedInfoLen_;
+    cvInfo_ = offset;
+    offset += pd.cvInfoLen_;
 
-    for (auto &m : outputs_) { free(m); }
+    proofs_.assign(paramset.numMPCRounds, Proof_offsets{});
+    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
+        if (contains(pd.challengeC_, paramset.numOpenedRounds, t)) {
+            size_t P_t = pd.challengeP_[indexOf(
+              pd.challengeC_, paramset.numOpenedRounds, t)];
+            Proof_offsets &po = proofs_[t];
+            po.seed_info_ = offset;
+            offset += seed_info_len_;
+            po.has_aux_ = (P_t != (paramset.numMPCParties - 1));
+            po.aux_ = offset;
+            if (po.has_aux_) { offset += param.aux_size_bytes_; }
+            po.msgs_ = offset;
+            offset += param.aux_size_bytes_;
+            po.inputs_ = offset;
+            offset += param.n_inputs_ * paramset.stateSizeBytes;
+            po.mpc_inputs_ = offset;
+            offset += param.n_mpc_inputs_ * paramset.stateSizeBytes;
+            po.outputs_ = offset;
+            offset += param.n_outputs_ * paramset.stateSizeBytes;
+            po.C_ = offset;
+            offset += paramset.digestSizeBytes;
+        }
+    }
+    size_ = offset;
+}
 
-    is_initialised_ = false;
+Mpc_proof_view Signature_layout::proof_view(
+  uint8_t const *signature, size_t t) const noexcept
+{
+    Proof_offsets const &po = proofs_[t];
+    Mpc_proof_view pv;
+    pv.seed_info_ = signature + po.seed_info_;
+    pv.seed_info_len_ = seed_info_len_;
+    pv.aux_ = po.has_aux_ ? signature + po.aux_ : nullptr;
+    pv.msgs_ = signature + po.msgs_;
+    pv.inputs_ = signature + po.inputs_;
+    pv.mpc_inputs_ = signature + po.mpc_inputs_;
+    pv.outputs_ = signature + po.outputs_;
+    pv.C_ = signature + po.C_;
+    return pv;
 }
 
-Signature_data::Signature_data(Mpc_param const &param) noexcept
-  : proof_param_(param)
+Signature_data::Signature_data(Mpc_param const &param, Mpc_arena *arena) noexcept
+  : mpc_pd_(arena), proof_param_(param), arena_(arena)
 {
     if (!mpc_pd_.is_initialised_) { return; }
 
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
-    proofs_ = new (std::nothrow) Proof2 *[paramset.numMPCRounds] { nullptr };
+    proofs_ = static_cast<Proof2 **>(
+      arena_allocate(arena_, paramset.numMPCRounds * sizeof(Proof2 *)));
     if (proofs_ == nullptr) { return; }
     // Individual proofs are allocated during signature generation, only for
     // rounds when neeeded
+    spare_proofs_.reserve(paramset.numOpenedRounds);
 
     is_initialised_ = true;
 }
@@ -174,108 +248,110 @@ Signature_data::~Signature_data()
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
 
-    for (size_t i = 0; i < paramset.numMPCRounds; i++) {
-        if (proofs_[i] != nullptr) { delete proofs_[i]; }
+    if (proofs_ != nullptr) {
+        for (size_t i = 0; i < paramset.numMPCRounds; i++) {
+            delete_proof(proofs_[i]);
+        }
     }
-
-    delete[] proofs_;
+    for (auto p : spare_proofs_) { delete_proof(p); }
+    arena_free(arena_, proofs_);
+    arena_free(arena_, wire_);
 
     is_initialised_ = false;
 }
 
-size_t Signature_data::signature_size() const noexcept
+int Signature_data::set_layout() noexcept
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
 
-    size_t bytes_required = Mpc_parameters::challenge_hash_bytes_
-                            + paramset.saltSizeBytes;// challenge and salt
+    layout_.set(mpc_pd_, proof_param_);
+    if (layout_.size_ > wire_capacity_) {
+        // Allow for the largest signature, so the slab is only allocated once
+        size_t capacity = std::max(
+          layout_.size_, signature_size_estimate(proof_param_, paramset));
+        arena_free(arena_, wire_);
+        wire_ = static_cast<uint8_t *>(arena_allocate(arena_, capacity));
+        wire_capacity_ = (wire_ == nullptr) ? 0 : capacity;
+        if (wire_ == nullptr) {
+            layout_.size_ = 0;
+            return EXIT_FAILURE;
+        }
+    }
+
+    memcpy(wire_, mpc_pd_.challengeHash_, Mpc_parameters::challenge_hash_bytes_);
+    memcpy(wire_ + Mpc_parameters::challenge_hash_bytes_, mpc_pd_.salt_,
+      paramset.saltSizeBytes);
+    memcpy(wire_ + layout_.iSeedInfo_, mpc_pd_.iSeedInfo_, mpc_pd_.iSeedInfoLen_);
+    memcpy(wire_ + layout_.cvInfo_, mpc_pd_.cvInfo_, mpc_pd_.cvInfoLen_);
 
-    bytes_required += mpc_pd_.iSeedInfoLen_;// Encode only iSeedInfo, the length
-                                            // will be recomputed by deserialize
-    bytes_required += mpc_pd_.cvInfoLen_;
+    return EXIT_SUCCESS;
+}
 
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {// proofs
-        if (contains(mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
-            size_t P_t = mpc_pd_.challengeP_[indexOf(
-              mpc_pd_.challengeC_, paramset.numOpenedRounds, t)];
-            bytes_required += proofs_[t]->seedInfoLen_;
-            if (P_t != (paramset.numMPCParties - 1)) {
-                bytes_required += proof_param_.aux_size_bytes_;
-            }
-            bytes_required += proof_param_.aux_size_bytes_;// For msgs
-            bytes_required += proof_param_.n_inputs_ * paramset.stateSizeBytes;
-            bytes_required +=
-              proof_param_.n_mpc_inputs_ * paramset.stateSizeBytes;
-            bytes_required += proof_param_.n_outputs_ * paramset.stateSizeBytes;
-            bytes_required += paramset.digestSizeBytes;
+Proof2 *Signature_data::new_proof(size_t t) noexcept
+{
+    if (proofs_[t] == nullptr && !spare_proofs_.empty()) {
+        proofs_[t] = spare_proofs_.back();
+        spare_proofs_.pop_back();
+    }
+    if (proofs_[t] == nullptr) {
+        if (arena_ == nullptr) {
+            proofs_[t] = new (std::nothrow) Proof2(proof_param_);
+        } else {
+            void *mem = arena_->allocate(sizeof(Proof2), alignof(Proof2));
+            if (mem != nullptr) { proofs_[t] = new (mem) Proof2(proof_param_); }
         }
     }
-
-    return bytes_required;
+    if (proofs_[t] == nullptr) { return nullptr; }
+    proofs_[t]->bind(wire_, layout_.proofs_[t], layout_.seed_info_len_);
+    return proofs_[t];
 }
 
-size_t Signature_data::serialise_signature(
-  uint8_t *signature, size_t signature_len_assigned) const noexcept
+void Signature_data::reset() noexcept
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
 
-    if (signature_len_assigned < signature_size()) {
-        std::cerr << "serialise_signature: buffer provided is too small\n";
-        return 0;
+    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
+        if (proofs_[t] != nullptr) {
+            spare_proofs_.push_back(proofs_[t]);
+            proofs_[t] = nullptr;
+        }
     }
+    mpc_pd_.iSeedInfoLen_ = 0;
+    mpc_pd_.cvInfoLen_ = 0;
+    layout_.size_ = 0;
+}
 
-    const uint8_t *signature_base = signature;
-
-    memcpy(
-      signature, mpc_pd_.challengeHash_, Mpc_parameters::challenge_hash_bytes_);
-    signature += Mpc_parameters::challenge_hash_bytes_;
-
-    memcpy(signature, mpc_pd_.salt_, paramset.saltSizeBytes);
-    signature += paramset.saltSizeBytes;
-
-    memcpy(signature, mpc_pd_.iSeedInfo_, mpc_pd_.iSeedInfoLen_);
-    signature += mpc_pd_.iSeedInfoLen_;
+void Signature_data::delete_proof(Proof2 *proof) noexcept
+{
+    if (proof == nullptr) { return; }
+    if (arena_ == nullptr) {
+        delete proof;
+    } else {
+        proof->~Proof2();
+    }
+}
 
-    memcpy(signature, mpc_pd_.cvInfo_, mpc_pd_.cvInfoLen_);
-    signature += mpc_pd_.cvInfoLen_;
-    // Write the proofs
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        if (contains(mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
-            memcpy(signature, proofs_[t]->seedInfo_, proofs_[t]->seedInfoLen_);
-            signature += proofs_[t]->seedInfoLen_;
-            size_t P_t = mpc_pd_.challengeP_[indexOf(
-              mpc_pd_.challengeC_, paramset.numOpenedRounds, t)];
-            if (P_t != (paramset.numMPCParties - 1)) {
-                memcpy(
-                  signature, proofs_[t]->aux_, proof_param_.aux_size_bytes_);
-                signature += proof_param_.aux_size_bytes_;
-            }
-            memcpy(signature, proofs_[t]->msgs_, proof_param_.aux_size_bytes_);
-            signature += proof_param_.aux_size_bytes_;
-            for (auto const &m : proofs_[t]->inputs_) {
-                memcpy(signature, m, paramset.stateSizeBytes);
-                signature += paramset.stateSizeBytes;
-            }
-            for (auto const &m : proofs_[t]->mpc_inputs_) {
-                memcpy(signature, m, paramset.stateSizeBytes);
-                signature += paramset.stateSizeBytes;
-            }
-            for (auto const &m : proofs_[t]->outputs_) {
-                memcpy(signature, m, paramset.stateSizeBytes);
-                signature += paramset.stateSizeBytes;
-            }
-            memcpy(signature, proofs_[t]->C_, paramset.digestSizeBytes);
-            signature += paramset.digestSizeBytes;
-        }
+size_t Signature_data::serialise_signature(
+  uint8_t *signature, size_t signature_len_assigned) const noexcept
+{
+    if (wire_ == nullptr || layout_.size_ == 0) {
+        std::cerr << "serialise_signature: no signature\n";
+        return 0;
+    }
+    if (signature_len_assigned < layout_.size_) {
+        std::cerr << "serialise_signature: buffer provided is too small\n";
+        return 0;
     }
 
-    return static_cast<size_t>(signature - signature_base);
+    memcpy(signature, wire_, layout_.size_);
+
+    return layout_.size_;
 }
 
-int Signature_data::deserialise_signature(
-  const uint8_t *signature, size_t signature_len) noexcept
+int Signature_data::deserialise_signature_header(const uint8_t *signature,
+  size_t signature_len, Signature_layout &layout) noexcept
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
@@ -288,123 +364,87 @@ int Signature_data::deserialise_signature(
 
     memcpy(
       mpc_pd_.challengeHash_, signature, Mpc_parameters::challenge_hash_bytes_);
-    signature += Mpc_parameters::challenge_hash_bytes_;
-    memcpy(mpc_pd_.salt_, signature, paramset.saltSizeBytes);
-    signature += paramset.saltSizeBytes;
+    memcpy(mpc_pd_.salt_, signature + Mpc_parameters::challenge_hash_bytes_,
+      paramset.saltSizeBytes);
 
     calculate_challenge_lists(mpc_pd_.challengeHash_, mpc_pd_.challengeC_,
       mpc_pd_.challengeP_, &paramset);
 
-    // Add size of iSeeds tree data
+    // The size of iSeeds tree data
     mpc_pd_.iSeedInfoLen_ = revealSeedsSize(paramset.numMPCRounds,
       mpc_pd_.challengeC_, paramset.numOpenedRounds, &paramset);
-    bytes_required += mpc_pd_.iSeedInfoLen_;
 
-    // Add the size of the Cv Merkle tree data
+    // The size of the Cv Merkle tree data
     size_t missingLeavesSize = paramset.numMPCRounds - paramset.numOpenedRounds;
     uint16_t *missingLeaves =
       getMissingLeavesList(mpc_pd_.challengeC_, &paramset);
     mpc_pd_.cvInfoLen_ = openMerkleTreeSize(
       paramset.numMPCRounds, missingLeaves, missingLeavesSize, &paramset);
-    bytes_required += mpc_pd_.cvInfoLen_;
     free(missingLeaves);
 
-    // Compute the number of bytes required for the proofs
-    uint16_t hideList[1] = { 0 };
-    size_t seedInfoLen =
-      revealSeedsSize(paramset.numMPCParties, hideList, 1, &paramset);
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        if (contains(mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
-            size_t P_t = mpc_pd_.challengeP_[indexOf(
-              mpc_pd_.challengeC_, paramset.numOpenedRounds, t)];
-            if (P_t != (paramset.numMPCParties - 1)) {
-                bytes_required += proof_param_.aux_size_bytes_;// For aux
-            }
-            bytes_required += seedInfoLen;
-            bytes_required += proof_param_.aux_size_bytes_;// For msgs
-
-            bytes_required +=
-              (proof_param_.n_inputs_ + proof_param_.n_mpc_inputs_
-                + proof_param_.n_outputs_)
-              * paramset.stateSizeBytes;
-            bytes_required += paramset.digestSizeBytes;
-        }
-    }
-
     // Fail if the signature does not have the exact number of bytes we expect
-    if (signature_len != bytes_required) {
+    layout.set(mpc_pd_, proof_param_);
+    if (signature_len != layout.size_) {
         std::cerr << "signature_len = " << signature_len
-                  << ", expected bytes_required =" << bytes_required << '\n';
+                  << ", expected bytes_required =" << layout.size_ << '\n';
         return EXIT_FAILURE;
     }
 
-    mpc_pd_.iSeedInfo_ = static_cast<uint8_t *>(malloc(mpc_pd_.iSeedInfoLen_));
-    memcpy(mpc_pd_.iSeedInfo_, signature, mpc_pd_.iSeedInfoLen_);
-    signature += mpc_pd_.iSeedInfoLen_;
-
-    mpc_pd_.cvInfo_ = static_cast<uint8_t *>(malloc(mpc_pd_.cvInfoLen_));
-    memcpy(mpc_pd_.cvInfo_, signature, mpc_pd_.cvInfoLen_);
-    signature += mpc_pd_.cvInfoLen_;
+    if (!mpc_pd_.reserve_info(mpc_pd_.iSeedInfoLen_, mpc_pd_.cvInfoLen_)) {
+        return EXIT_FAILURE;
+    }
+    memcpy(
+      mpc_pd_.iSeedInfo_, signature + layout.iSeedInfo_, mpc_pd_.iSeedInfoLen_);
+    memcpy(mpc_pd_.cvInfo_, signature + layout.cvInfo_, mpc_pd_.cvInfoLen_);
 
-    // Read the proofs
+    // Check the padding of the aux bits and messages in place
     for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-
         if (contains(mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
-            proofs_[t] = new Proof2(proof_param_);
-            proofs_[t]->seedInfoLen_ = seedInfoLen;
-            proofs_[t]->seedInfo_ =
-              static_cast<uint8_t *>(malloc(proofs_[t]->seedInfoLen_));
-            memcpy(proofs_[t]->seedInfo_, signature, proofs_[t]->seedInfoLen_);
-            signature += proofs_[t]->seedInfoLen_;
-
-            size_t P_t = mpc_pd_.challengeP_[indexOf(
-              mpc_pd_.challengeC_, paramset.numOpenedRounds, t)];
-            if (P_t != (paramset.numMPCParties - 1)) {
-                memcpy(
-                  proofs_[t]->aux_, signature, proof_param_.aux_size_bytes_);
-                signature += proof_param_.aux_size_bytes_;
-                if (!arePaddingBitsZero(
-                      proofs_[t]->aux_, proof_param_.aux_size_bits_)) {
-                    std::cerr << "failed while deserializing aux bits\n";
-                    return EXIT_FAILURE;
-                }
+            Proof_offsets const &po = layout.proofs_[t];
+            if (po.has_aux_
+                && !arePaddingBitsZero(const_cast<uint8_t *>(signature + po.aux_),
+                  proof_param_.aux_size_bits_)) {
+                std::cerr << "failed while deserializing aux bits\n";
+                return EXIT_FAILURE;
             }
-            memcpy(proofs_[t]->msgs_, signature, proof_param_.aux_size_bytes_);
-            signature += proof_param_.aux_size_bytes_;
-            if (!arePaddingBitsZero(
-                  proofs_[t]->msgs_, proof_param_.aux_size_bits_)) {
+            if (!arePaddingBitsZero(const_cast<uint8_t *>(signature + po.msgs_),
+                  proof_param_.aux_size_bits_)) {
                 std::cerr << "failed while deserializing msgs bits\n";
                 return EXIT_FAILURE;
             }
-            for (auto &m : proofs_[t]->inputs_) {
-                memcpy(m, signature, paramset.stateSizeBytes);
-                signature += paramset.stateSizeBytes;
-            }
-            for (auto &m : proofs_[t]->mpc_inputs_) {
-                memcpy(m, signature, paramset.stateSizeBytes);
-                signature += paramset.stateSizeBytes;
-            }
-            for (auto &m : proofs_[t]->outputs_) {
-                memcpy(m, signature, paramset.stateSizeBytes);
-                signature += paramset.stateSizeBytes;
-            }
-            memcpy(proofs_[t]->C_, signature, paramset.digestSizeBytes);
-            signature += paramset.digestSizeBytes;
         }
     }
+
     return EXIT_SUCCESS;
 }
 
+int Signature_data::deserialise_signature(
+  const uint8_t *signature, size_t signature_len) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    int ret = deserialise_signature_header(signature, signature_len, layout_);
+    if (ret != EXIT_SUCCESS) { return ret; }
+
+    // The header has been checked and the slab has the same layout, so the
+    // whole signature can be copied at once
+    if (set_layout() != EXIT_SUCCESS) { return EXIT_FAILURE; }
+    memcpy(wire_, signature, signature_len);
+    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
+        if (contains(mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
+            if (new_proof(t) == nullptr) { return EXIT_FAILURE; }
+        }
+    }
+    return EXIT_SUCCESS;
+}
 
 size_t signature_size_estimate(
   Mpc_param const &proof_param, paramset_t const &paramset)
 {
     // Picnic3 parameter sets only
     size_t u = paramset.numOpenedRounds;
-    size_t T = paramset.numMPCRounds;
-    size_t numTreeValues = u
-                           * ceil_log2(static_cast<uint32_t>(
-                             (T + (u - 1)) / u));// u*ceil(log2(ceil(T/u)))
+    size_t numTreeValues = max_tree_values(paramset);
 
     size_t proof_size =
       paramset.seedSizeBytes
@@ -430,6 +470,14 @@ size_t signature_size_estimate(
     return signatureSize;
 }
 
+size_t max_tree_values(paramset_t const &paramset) noexcept
+{
+    size_t u = paramset.numOpenedRounds;
+    size_t T = paramset.numMPCRounds;
+    // u*ceil(log2(ceil(T/u)))
+    return u * ceil_log2(static_cast<uint32_t>((T + (u - 1)) / u));
+}
+
 void Signature_data::print_signature_data(
   std::ostream &os, signature_data_print_mask pm) const
 {
@@ -454,7 +502,8 @@ void Signature_data::print_signature_data(
         if (contains(mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
             Proof2 const *p2_ptr = proofs_[t];
 
-            if (pm & signature_data_print_mask::proofs_aux) {
+            if ((pm & signature_data_print_mask::proofs_aux)
+                && p2_ptr->aux_ != nullptr) {
                 os << "proof2[" << t << "].aux:\n";
                 print_buffer(os, p2_ptr->aux_, proof_param_.aux_size_bytes_);
             }
@@ -61,13 +61,29 @@ Epid_arl_entry calculate_epid_arl_entry(Lowmc_state_words64_const_ptr r,
   paramset_t *params) noexcept
 {
     Epid_arl_entry arl_entry;
+    calculate_epid_arl_entry(arl_entry, r, sku, srl, params);
+    return arl_entry;
+}
 
+void calculate_epid_arl_entry(Epid_arl_entry &arl_entry,
+  Lowmc_state_words64_const_ptr r, Lowmc_state_words64_const_ptr sku,
+  Epid_sigrl_entry const &srl, paramset_t *params) noexcept
+{
     Lowmc_state_words64 intermediate_state{ 0 };
     lowmc64(intermediate_state, sku, srl.first(), params);
 
     lowmc64(arl_entry.entry(), intermediate_state, r, params);
+}
 
-    return arl_entry;
+void extend_epid_arl(Epid_a_rl &arl, Lowmc_state_words64_const_ptr r,
+  Lowmc_state_words64_const_ptr sku, Sigrl_view srl,
+  paramset_t *params) noexcept
+{
+    size_t first_new = arl.size();
+    arl.resize(srl.size());
+    for (size_t e = first_new; e < srl.size(); ++e) {
+        calculate_epid_arl_entry(arl[e], r, sku, srl[e], params);
+    }
 }
 
 Tape_offset Mpc_sigrl_entry::set_offsets(Tape_offset const &of) noexcept
@@ -165,7 +181,7 @@ void Mpc_sigrl_entry::get_aux_bits(
 }
 
 void Mpc_sigrl_entry::set_aux_bits(
-  randomTape_t *tapes, uint32_t &pos, uint8_t *aux_bits) const noexcept
+  randomTape_t *tapes, uint32_t &pos, uint8_t const *aux_bits) const noexcept
 {
     lowmc_a_.set_aux_bits(tapes, pos, aux_bits);
     lowmc_a_j_.set_aux_bits(tapes, pos, aux_bits);
@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * File:        Mpc_streaming_tapes.cpp
+ * Description: Random tapes for one repetition that are squeezed a window
+ *              at a time, as the circuit works through the tape
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Io_utils.h"
+#include "Hbgs_param.h"
+#include "Mpc_memory.h"
+#include "Mpc_streaming_tapes.h"
+
+Mpc_streaming_tapes::Mpc_streaming_tapes(Tape_offset max_window_bits) noexcept
+{
+    // A window can start part way through a byte
+    capacity_ = (max_window_bits + 7U) / 8U + 1U;
+    slab_ = static_cast<uint8_t *>(
+      allocate_slab(Mpc_parameters::mpc_parties_ * capacity_));
+    if (slab_ == nullptr) { return; }
+    for (size_t i = 0; i < Mpc_parameters::mpc_parties_; ++i) {
+        tape_ptrs_[i] = slab_ + i * capacity_;
+    }
+    tape_.tape = tape_ptrs_;
+    tape_.nTapes = Mpc_parameters::mpc_parties_;
+    tape_.pos = 0;
+    is_initialised_ = true;
+}
+
+Mpc_streaming_tapes::~Mpc_streaming_tapes() { free_slab(slab_); }
+
+void Mpc_streaming_tapes::start(uint8_t **seeds, uint8_t const *salt,
+  size_t t, paramset_t *params) noexcept
+{
+    // As create_random_tapes_times4, but without the squeeze
+    for (size_t c = 0; c < n_contexts_; ++c) {
+        size_t i = 4 * c;
+        hash_init_x4(&ctx_[c].ctx_, params->digestSizeBytes);
+        const uint8_t *seeds_ptr[4] = { seeds[i], seeds[i + 1], seeds[i + 2],
+            seeds[i + 3] };
+        hash_update_x4(&ctx_[c].ctx_, seeds_ptr, params->seedSizeBytes);
+        const uint8_t *salt_ptr[4] = { salt, salt, salt, salt };
+        hash_update_x4(&ctx_[c].ctx_, salt_ptr, params->saltSizeBytes);
+        hash_update_x4_uint16_le(&ctx_[c].ctx_, static_cast<uint16_t>(t));
+        const uint16_t i_arr[4] = { static_cast<uint16_t>(i + 0),
+            static_cast<uint16_t>(i + 1), static_cast<uint16_t>(i + 2),
+            static_cast<uint16_t>(i + 3) };
+        hash_update_x4_uint16s_le(&ctx_[c].ctx_, i_arr);
+        hash_final_x4(&ctx_[c].ctx_);
+    }
+    window_start_ = 0;
+    squeezed_ = 0;
+    hidden_party_ = no_party_;
+    tape_.pos = 0;
+}
+
+// Squeeze the next n_bytes of each tape into the window, starting at byte to
+void Mpc_streaming_tapes::squeeze(size_t to, size_t n_bytes) noexcept
+{
+    for (size_t c = 0; c < n_contexts_; ++c) {
+        size_t i = 4 * c;
+        uint8_t *out_ptr[4] = { tape_ptrs_[i] + to, tape_ptrs_[i + 1] + to,
+            tape_ptrs_[i + 2] + to, tape_ptrs_[i + 3] + to };
+        hash_squeeze_x4(&ctx_[c].ctx_, out_ptr, n_bytes);
+    }
+    if (hidden_party_ != no_party_) {
+        memset(tape_ptrs_[hidden_party_] + to, 0, n_bytes);
+    }
+}
+
+randomTape_t *Mpc_streaming_tapes::window(
+  Tape_offset begin, Tape_offset end) noexcept
+{
+    size_t begin_byte = begin / 8U;
+    size_t end_byte = (end + 7U) / 8U;
+    assertm(begin_byte >= window_start_,
+      "Mpc_streaming_tapes: the tapes can only move forward");
+    assertm(end_byte - begin_byte <= capacity_,
+      "Mpc_streaming_tapes: the window is too large");
+
+    if (begin_byte < squeezed_) {
+        // Keep the part of the current window that is still needed, it may
+        // include aux bits written for the previous window
+        size_t keep = squeezed_ - begin_byte;
+        size_t shift = begin_byte - window_start_;
+        if (shift != 0) {
+            for (auto *tp : tape_ptrs_) { memmove(tp, tp + shift, keep); }
+        }
+        window_start_ = begin_byte;
+    } else {
+        // Skip over any bytes that are not needed
+        window_start_ = begin_byte;
+        while (squeezed_ < begin_byte) {
+            size_t n = std::min(capacity_, begin_byte - squeezed_);
+            squeeze(0, n);
+            squeezed_ += n;
+        }
+    }
+    if (end_byte > squeezed_) {
+        squeeze(squeezed_ - window_start_, end_byte - squeezed_);
+        squeezed_ = end_byte;
+    }
+    tape_.pos = 0;
+    return &tape_;
+}
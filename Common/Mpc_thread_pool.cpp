@@ -0,0 +1,255 @@
+/*******************************************************************************
+ * File:        Mpc_thread_pool.cpp
+ * Description: A small pool of worker threads used to split the per-repetition
+ *              work of the MPC proofs into blocks
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#include <cstdlib>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+
+#include "Io_utils.h"
+#include "Mpc_thread_pool.h"
+
+namespace {
+// Set for the pool's threads (and the caller while it runs its block) so that
+// nested calls to parallel_for do not deadlock
+thread_local size_t current_worker{ SIZE_MAX };
+
+// Parse a list such as "0-3,8,10-11", appending the values to cpus
+bool parse_cpu_list(std::string const &list, std::vector<int> &cpus) noexcept
+{
+    std::istringstream is(list);
+    std::string range;
+    while (std::getline(is, range, ',')) {
+        if (range.empty()) { continue; }
+        char *end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-') { last = std::strtol(end + 1, &end, 10); }
+        if (*end != '\0' || first < 0 || last < first) { return false; }
+        for (long c = first; c <= last; ++c) {
+            cpus.push_back(static_cast<int>(c));
+        }
+    }
+    return true;
+}
+}// namespace
+
+size_t mpc_thread_count() noexcept
+{
+    std::string threads = get_environment_variable("HBGS_THREADS", "");
+    if (!threads.empty()) {
+        size_t n = std::strtoul(threads.c_str(), nullptr, 10);
+        if (n > 0) { return n; }
+    }
+    size_t hc = std::thread::hardware_concurrency();
+    return (hc == 0) ? 1 : hc;
+}
+
+std::vector<int> mpc_cpu_list() noexcept
+{
+    std::vector<int> cpus;
+    std::string list = get_environment_variable("HBGS_CPUS", "");
+    if (!parse_cpu_list(list, cpus)) {
+        std::cerr << "Ignoring invalid HBGS_CPUS value: " << list << '\n';
+        cpus.clear();
+    }
+    return cpus;
+}
+
+int mpc_cpu_node(int cpu) noexcept
+{
+    // Each node directory holds a cpulist file, e.g. "0-7,16-23"
+    for (int node = 0; node < 1024; ++node) {
+        std::ifstream is(
+          "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!is) {
+            if (node == 0) { return -1; }
+            break;
+        }
+        std::string list;
+        std::getline(is, list);
+        std::vector<int> cpus;
+        if (!parse_cpu_list(list, cpus)) { continue; }
+        for (auto c : cpus) {
+            if (c == cpu) { return node; }
+        }
+    }
+    return -1;
+}
+
+Mpc_thread_pool::Mpc_thread_pool(size_t n_threads) noexcept
+  : Mpc_thread_pool(n_threads, std::vector<int>{})
+{}
+
+Mpc_thread_pool::Mpc_thread_pool(
+  size_t n_threads, std::vector<int> cpus) noexcept
+  : cpus_(std::move(cpus))
+{
+    if (n_threads == 0) { n_threads = 1; }
+    workers_.reserve(n_threads - 1);
+    for (size_t w = 1; w < n_threads; ++w) {
+        workers_.emplace_back(&Mpc_thread_pool::worker_loop, this, w);
+    }
+}
+
+Mpc_thread_pool::~Mpc_thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto &w : workers_) { w.join(); }
+}
+
+Mpc_thread_pool &Mpc_thread_pool::instance() noexcept
+{
+    static Mpc_thread_pool pool(mpc_thread_count(), mpc_cpu_list());
+    return pool;
+}
+
+int Mpc_thread_pool::worker_cpu(size_t worker) const noexcept
+{
+    if (cpus_.empty()) { return -1; }
+    return cpus_[worker % cpus_.size()];
+}
+
+void Mpc_thread_pool::print_placement(std::ostream &os) const
+{
+    os << "# threads: " << size() << '\n';
+    for (size_t w = 0; w < size(); ++w) {
+        int cpu = worker_cpu(w);
+        os << "# worker " << w << ": cpu ";
+        if (cpu < 0) {
+            os << "any";
+        } else {
+            os << cpu << ", node " << mpc_cpu_node(cpu);
+        }
+        os << '\n';
+    }
+}
+
+void Mpc_thread_pool::pin_current_thread(size_t worker) const noexcept
+{
+    int cpu = worker_cpu(worker);
+    if (cpu < 0) { return; }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(static_cast<size_t>(cpu), &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set)
+        != 0) {
+        std::cerr << "Failed to pin worker " << worker << " to cpu " << cpu
+                  << '\n';
+    }
+}
+
+void Mpc_thread_pool::parallel_for(
+  size_t n_items, Block_function const &fn) noexcept
+{
+    if (n_items == 0) { return; }
+    if (current_worker != SIZE_MAX || workers_.empty() || n_items == 1) {
+        fn(0, n_items, (current_worker == SIZE_MAX) ? 0 : current_worker);
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    // The caller runs block 0 on worker 0's CPU and then gets back the CPUs
+    // it had, so that no thread is left pinned by calling parallel_for
+    cpu_set_t caller_cpus;
+    bool pin_caller = worker_cpu(0) >= 0
+                      && pthread_getaffinity_np(pthread_self(),
+                           sizeof(cpu_set_t), &caller_cpus)
+                           == 0;
+    if (pin_caller) { pin_current_thread(0); }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        n_items_ = n_items;
+        n_running_ = workers_.size();
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    current_worker = 0;
+    run_block(0);
+    current_worker = SIZE_MAX;
+    if (pin_caller
+        && pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+             &caller_cpus)
+             != 0) {
+        std::cerr << "Failed to restore the CPUs of the calling thread\n";
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return n_running_ == 0; });
+    job_ = nullptr;
+}
+
+void Mpc_thread_pool::run_block(size_t worker) noexcept
+{
+    size_t n_workers = size();
+    size_t begin = (n_items_ * worker) / n_workers;
+    size_t end = (n_items_ * (worker + 1)) / n_workers;
+    if (begin < end) { (*job_)(begin, end, worker); }
+}
+
+void Mpc_thread_pool::worker_loop(size_t worker) noexcept
+{
+    current_worker = worker;
+    pin_current_thread(worker);
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(
+              lock, [this, seen] { return stopping_ || generation_ != seen; });
+            if (stopping_) { return; }
+            seen = generation_;
+        }
+        run_block(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --n_running_;
+        }
+        done_cv_.notify_one();
+    }
+}
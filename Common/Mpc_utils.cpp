@@ -54,6 +54,9 @@ extern "C" {
 #include "Hbgs_param.h"
 #include "Lowmc64.h"
 #include "Mpc_utils.h"
+#include "Mpc_memory.h"
+#include "Mpc_arena.h"
+#include "Mpc_thread_pool.h"
 
 picnic_params_t get_picnic_parameter_set_id()
 {
@@ -193,8 +196,10 @@ void allocate_random_tapes(randomTape_t *tape, size_t tape_size_bytes)
     tape->nTapes = Mpc_parameters::mpc_parties_;
     tape->tape =
       static_cast<uint8_t **>(malloc(tape->nTapes * sizeof(uint8_t *)));
-    auto *slab =
-      static_cast<uint8_t *>(calloc(1, tape->nTapes * tape_size_bytes));
+    // Called from the worker that generates the tapes for this repetition, so
+    // the pages are first touched (and placed) by that worker
+    auto *slab = static_cast<uint8_t *>(
+      allocate_slab(tape->nTapes * tape_size_bytes));
     for (uint8_t i = 0; i < tape->nTapes; i++) {
         tape->tape[i] = slab;
         slab += tape_size_bytes;
@@ -202,6 +207,13 @@ void allocate_random_tapes(randomTape_t *tape, size_t tape_size_bytes)
     tape->pos = 0;
 }
 
+void free_random_tapes(randomTape_t *tape)
+{
+    if (tape->tape == nullptr) { return; }
+    free_slab(tape->tape[0]);
+    free(tape->tape);
+}
+
 void create_random_tapes(randomTape_t *tapes,
   uint8_t **seeds,
   uint8_t *salt,
@@ -303,33 +315,48 @@ size_t hbgs_signature_size(paramset_t *params, size_t proof_data_size)
     return signatureSize;
 }
 
-msgs_t *allocate_msgs(size_t msgs_size)
+msgs_t *allocate_msgs(size_t msgs_size, Mpc_arena *arena)
 {
     auto *msgs = static_cast<msgs_t *>(
-      malloc(Mpc_parameters::mpc_rounds_ * sizeof(msgs_t)));
-    auto *slab = static_cast<uint8_t *>(calloc(1,
-      Mpc_parameters::mpc_rounds_
-        * (Mpc_parameters::mpc_parties_ * msgs_size
-           + Mpc_parameters::mpc_parties_ * sizeof(uint8_t *))));
-
-    for (uint32_t i = 0; i < Mpc_parameters::mpc_rounds_; i++) {
-        msgs[i].pos = 0;
-        msgs[i].unopened = -1;
-        msgs[i].msgs = reinterpret_cast<uint8_t **>(slab);
-        slab += Mpc_parameters::mpc_parties_ * sizeof(uint8_t *);
-
-        for (uint32_t j = 0; j < Mpc_parameters::mpc_parties_; j++) {
-            msgs[i].msgs[j] = slab;
-            slab += msgs_size;
-        }
+      arena_allocate(arena, Mpc_parameters::mpc_rounds_ * sizeof(msgs_t)));
+    if (msgs == nullptr) { return nullptr; }
+    size_t round_size = Mpc_parameters::mpc_parties_ * msgs_size
+                        + Mpc_parameters::mpc_parties_ * sizeof(uint8_t *);
+    size_t slab_size = Mpc_parameters::mpc_rounds_ * round_size;
+    auto *slab = static_cast<uint8_t *>(arena != nullptr
+                                          ? arena->allocate(slab_size, 64)
+                                          : allocate_slab(slab_size));
+    if (slab == nullptr) {
+        arena_free(arena, msgs);
+        return nullptr;
     }
 
+    // Each round is set up by the worker that will later run that repetition,
+    // so that its part of the slab is placed on that worker's NUMA node
+    Mpc_thread_pool::instance().parallel_for(Mpc_parameters::mpc_rounds_,
+      [&](size_t begin, size_t end, size_t) {
+          for (size_t i = begin; i < end; i++) {
+              uint8_t *round = slab + i * round_size;
+              msgs[i].pos = 0;
+              msgs[i].unopened = -1;
+              msgs[i].msgs = reinterpret_cast<uint8_t **>(round);
+              round += Mpc_parameters::mpc_parties_ * sizeof(uint8_t *);
+
+              for (uint32_t j = 0; j < Mpc_parameters::mpc_parties_; j++) {
+                  msgs[i].msgs[j] = round;
+                  memset(round, 0, msgs_size);
+                  round += msgs_size;
+              }
+          }
+      });
+
     return msgs;
 }
 
-void free_msgs(msgs_t *msgs)
+void free_msgs(msgs_t *msgs, Mpc_arena *arena)
 {
-    free(msgs[0].msgs);
+    if (msgs == nullptr || arena != nullptr) { return; }
+    free_slab(msgs[0].msgs);
     free(msgs);
 }
 
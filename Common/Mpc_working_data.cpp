@@ -40,6 +40,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstring>
 #include "Io_utils.h"
 
 #include "picnic.h"
@@ -54,73 +55,66 @@ extern "C" {
 #include "Lowmc64.h"
 #include "Mpc_working_data.h"
 
-inputs_t allocate_inputs64()
+bool Mpc_state_slab::allocate(size_t n_entries, Mpc_arena *arena) noexcept
 {
-    auto *slab = static_cast<uint8_t *>(calloc(1,
-      Mpc_parameters::mpc_rounds_
-        * (lowmc_state_words64_bytes + sizeof(uint8_t *))));
-    // Add this test for success allocating the memory
-    if (slab == nullptr) { return nullptr; }
+    n_entries_ = n_entries;
+    if (n_entries_ == 0) { return true; }
+    states_ = static_cast<uint8_t *>(arena_allocate(arena,
+      Mpc_parameters::mpc_rounds_ * n_entries_ * state_bytes_));
 
-    auto inputs = reinterpret_cast<inputs_t>(slab);// inputs_t is uint8_t**
-
-    slab += Mpc_parameters::mpc_rounds_ * sizeof(uint8_t *);
-
-    for (uint32_t i = 0; i < Mpc_parameters::mpc_rounds_; i++) {
-        inputs[i] = reinterpret_cast<uint8_t *>(slab);
-        slab += lowmc_state_words64_bytes;
-    }
-
-    return inputs;
+    return states_ != nullptr;
 }
 
+void Mpc_state_slab::release(Mpc_arena *arena) noexcept
+{
+    arena_free(arena, states_);
+    states_ = nullptr;
+    n_entries_ = 0;
+}
 
-Mpc_working_data::Mpc_working_data(Mpc_param const &param) noexcept
+Mpc_working_data::Mpc_working_data(
+  Mpc_param const &param, Mpc_arena *arena) noexcept
+  : arena_(arena)
 {
     aux_size_bytes_ = param.aux_size_bytes_;
     paramset_t paramset;
     [[maybe_unused]] int ret =
       get_param_set(get_picnic_parameter_set_id(), &paramset);
-    aux_bits_ = static_cast<uint8_t *>(calloc(aux_size_bytes_, 1));
+    aux_bits_ = static_cast<uint8_t *>(
+      arena_allocate(arena_, Mpc_parameters::mpc_rounds_ * aux_size_bytes_));
     if (aux_bits_ == nullptr) { return; }
 
-    // Currently using picnic allocation functions - no status returned
-    msgs_ = allocate_msgs(aux_size_bytes_);
-
-    inputs_.resize(param.n_inputs_);
-    for (size_t i = 0; i < param.n_inputs_; ++i) {
-        inputs_[i] = allocate_inputs64();
-    }
-
-    mpc_inputs_.resize(param.n_mpc_inputs_);
-    for (size_t i = 0; i < param.n_mpc_inputs_; ++i) {
-        mpc_inputs_[i] = allocate_inputs64();
-    }
-
-    outputs_.resize(param.n_outputs_);
-    for (size_t i = 0; i < param.n_outputs_; ++i) {
-        outputs_[i] = allocate_inputs64();
-    }
+    msgs_ = allocate_msgs(aux_size_bytes_, arena_);
+    if (msgs_ == nullptr) { return; }
 
+    if (!inputs_.allocate(param.n_inputs_, arena_)) { return; }
+    if (!mpc_inputs_.allocate(param.n_mpc_inputs_, arena_)) { return; }
+    if (!outputs_.allocate(param.n_outputs_, arena_)) { return; }
 
     is_initialised_ = true;
 }
 
 Mpc_working_data::~Mpc_working_data()
 {
-    freeMsgs(msgs_);
+    free_msgs(msgs_, arena_);
 
-    if (aux_bits_ != nullptr) { free(aux_bits_); }
+    arena_free(arena_, aux_bits_);
 
-    for (auto &m : inputs_) { freeInputs(m); }
-
-    for (auto &m : mpc_inputs_) { freeInputs(m); }
-
-    for (auto &m : outputs_) { freeInputs(m); }
+    inputs_.release(arena_);
+    mpc_inputs_.release(arena_);
+    outputs_.release(arena_);
 
     is_initialised_ = false;
 }
 
+void Mpc_working_data::reset() noexcept
+{
+    for (size_t t = 0; t < Mpc_parameters::mpc_rounds_; ++t) {
+        msgs_[t].pos = 0;
+        msgs_[t].unopened = -1;
+    }
+}
+
 void Mpc_working_data::print_working_data(
   std::ostream &os, mpc_wd_print_mask pm)
 {
@@ -131,9 +125,11 @@ void Mpc_working_data::print_working_data(
     }
 
     if (pm & mpc_wd_print_mask::aux_bits) {
-        os << "aux_bits: ";
-        print_buffer(os, aux_bits_, aux_size_bytes_);
-        os << '\n';
+        for (size_t t = 0; t < Mpc_parameters::mpc_rounds_; ++t) {
+            os << "aux_bits[" << t << "]: ";
+            print_buffer(os, aux_bits(t), aux_size_bytes_);
+            os << '\n';
+        }
     }
 
     if (pm & mpc_wd_print_mask::msgs) {
@@ -159,7 +155,7 @@ void Mpc_working_data::print_working_data(
             for (size_t ni = 0; ni < n_mpc_inputs; ++ni) {
                 os << ni << '\t';
                 print_lowmc_state_words(
-                  os, reinterpret_cast<uint32_t *>(mpc_inputs_[ni][t]));
+                  os, reinterpret_cast<uint32_t *>(mpc_inputs_.state(ni, t)));
                 os << '\n';
             }
         }
@@ -177,7 +173,7 @@ void Mpc_working_data::print_working_data(
             for (size_t ni = 0; ni < n_inputs; ++ni) {
                 os << ni << '\t';
                 print_lowmc_state_words(
-                  os, reinterpret_cast<uint32_t *>(inputs_[ni][t]));
+                  os, reinterpret_cast<uint32_t *>(inputs_.state(ni, t)));
                 os << '\n';
             }
         }
@@ -196,7 +192,7 @@ void Mpc_working_data::print_working_data(
             for (size_t ni = 0; ni < n_outputs; ++ni) {
                 os << ni << '\t';
                 print_lowmc_state_words(
-                  os, reinterpret_cast<uint32_t *>(outputs_[ni][t]));
+                  os, reinterpret_cast<uint32_t *>(outputs_.state(ni, t)));
                 os << '\n';
             }
         }
@@ -204,30 +200,103 @@ void Mpc_working_data::print_working_data(
 }
 
 
-Commitment_data1::Commitment_data1() noexcept
+Commitment_data1::Commitment_data1(Mpc_arena *arena) noexcept : arena_(arena)
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
-    C_ = allocateCommitments(&paramset, 0);
-    is_initialised = true;
+    C_ = arena_allocate_commitments(arena_, &paramset, 0);
+    is_initialised = (C_ != nullptr);
+}
+
+Commitment_data1::~Commitment_data1()
+{
+    if (C_ != nullptr) { arena_free_commitments(arena_, C_); }
 }
 
-Commitment_data1::~Commitment_data1() { freeCommitments(C_); }
+Commitment_data2::Commitment_data2(Mpc_arena *arena) noexcept : arena_(arena)
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+    arena_allocate_commitments2(arena_, &Ch, &paramset, paramset.numMPCRounds);
+    arena_allocate_commitments2(arena_, &Cv, &paramset, paramset.numMPCRounds);
+    treeCv = arena_create_tree(
+      arena_, paramset.numMPCRounds, paramset.digestSizeBytes);
+    is_initialised =
+      (Ch.hashes != nullptr && Cv.hashes != nullptr && treeCv != nullptr);
+}
 
-Commitment_data2::Commitment_data2() noexcept
+void Commitment_data2::reset() noexcept
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
-    allocateCommitments2(&Ch, &paramset, paramset.numMPCRounds);
-    allocateCommitments2(&Cv, &paramset, paramset.numMPCRounds);
-    treeCv = createTree(paramset.numMPCRounds, paramset.digestSizeBytes);
-    is_initialised = true;
+    // Verification clears the Cv pointers for the unopened rounds, restore
+    // them from the slab (laid out as in allocateCommitments2)
+    auto *slab = reinterpret_cast<uint8_t *>(Cv.hashes)
+                 + Cv.nCommitments * sizeof(uint8_t *);
+    for (size_t i = 0; i < Cv.nCommitments; i++) {
+        Cv.hashes[i] = slab;
+        slab += paramset.digestSizeBytes;
+    }
+    // The Merkle tree only computes the nodes it does not already have
+    std::memset(treeCv->haveNode, 0, treeCv->numNodes);
 }
 
 Commitment_data2::~Commitment_data2()
 {
-    freeCommitments2(&Ch);
-    freeCommitments2(&Cv);
-    freeTree(treeCv);
+    arena_free_commitments2(arena_, &Ch);
+    arena_free_commitments2(arena_, &Cv);
+    arena_free_tree(arena_, treeCv);
     is_initialised = false;
 }
+
+Mpc_worker_scratch::Mpc_worker_scratch(size_t aux_size_bytes,
+  size_t max_step_bits, Tape_offset tape_window_bits) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+    tmp_shares_.reset(allocateShares(paramset.stateSizeBits));
+    if (tmp_shares_ == nullptr) { return; }
+    tapes_ = std::make_unique<Mpc_streaming_tapes>(tape_window_bits);
+    if (!tapes_->is_initialised_) { return; }
+    commitment_stream_ =
+      std::make_unique<Mpc_commitment_stream>(max_step_bits, aux_size_bytes);
+    if (!commitment_stream_->is_initialised_) { return; }
+    proof_stream_ = std::make_unique<Mpc_proof_stream>(max_step_bits);
+    if (!proof_stream_->is_initialised_) { return; }
+
+    is_initialised_ = true;
+}
+
+bool allocate_worker_scratch(Mpc_scratch_set &scratch, size_t n_workers,
+  size_t aux_size_bytes, size_t max_step_bits,
+  Tape_offset tape_window_bits) noexcept
+{
+    scratch.resize(n_workers);
+    for (auto &s : scratch) {
+        s = std::make_unique<Mpc_worker_scratch>(
+          aux_size_bytes, max_step_bits, tape_window_bits);
+        if (!s->is_initialised_) {
+            std::cerr << "Unable to allocate the worker scratch data\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+Mpc_scratch_set *Mpc_session::worker_scratch(size_t n_workers,
+  size_t aux_size_bytes, size_t max_step_bits,
+  Tape_offset tape_window_bits) noexcept
+{
+    std::array<size_t, 4> sizes{ n_workers, aux_size_bytes, max_step_bits,
+        static_cast<size_t>(tape_window_bits) };
+    if (sizes != scratch_sizes_) {
+        scratch_sizes_.fill(0);
+        if (!allocate_worker_scratch(scratch_, n_workers, aux_size_bytes,
+              max_step_bits, tape_window_bits)) {
+            scratch_.clear();
+            return nullptr;
+        }
+        scratch_sizes_ = sizes;
+    }
+    return &scratch_;
+}
@@ -37,10 +37,14 @@
 *******************************************************************************/
 #include <cmath>
 #include <cinttypes>
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <thread>
 #include <exception>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <iomanip>
 #include <string>
 #include <vector>
@@ -59,6 +63,12 @@ extern "C" {
 #include "Mpc_parameters.h"
 #include "Lowmc64.h"
 #include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_binary.h"
+#include "Hb_epid_rl_text.h"
+#include "Hb_epid_rl_store.h"
+#include "Hb_epid_rl_shards.h"
+#include "Hb_epid_rl_transport.h"
+#include "Hb_epid_rl_index.h"
 #include "Generate_epid_srl.h"
 
 bool generate_epid_revocation_lists(Epid_sig_rl &srlist, size_t n_srl_entries)
@@ -68,11 +78,13 @@ bool generate_epid_revocation_lists(Epid_sig_rl &srlist, size_t n_srl_entries)
 
     Lowmc_matrices::assign_lowmc_matrices();
 
-    Lowmc_state_words64 first{ 0 };
     Lowmc_state_words64 sk{ 0 };
-    Lowmc_state_words64 second{ 0 };
 
+    srlist.reserve(srlist.size() + n_srl_entries);
     for (size_t i = 0; i < n_srl_entries; ++i) {
+        // Each entry is written where it will be held
+        Epid_sigrl_entry &srle = srlist.emplace();
+        Lowmc_state_words64_ptr first = srle.first();
         if (picnic_random_bytes(reinterpret_cast<uint8_t *>(first),
               Mpc_parameters::lowmc_state_bytes_)
             != 0) {
@@ -91,18 +103,228 @@ bool generate_epid_revocation_lists(Epid_sig_rl &srlist, size_t n_srl_entries)
         zeroTrailingBits(
           reinterpret_cast<uint8_t *>(sk), Mpc_parameters::lowmc_state_bits_);
 
-        lowmc64(second, sk, first, &paramset);
-
-        Epid_rl_entry<Sigrl> srle(first, second);
-        srlist.add(srle);
+        lowmc64(srle.second(), sk, first, &paramset);
     }
 
     return true;
 }
 
+// Convert the text list <filename>.srlist to <filename>.srlbin
+int convert_srl(std::string const &filename)
+{
+    Epid_sig_rl sig_rl;
+    if (!read_rl_text(sig_rl, filename + '.' + sigrl_file_ext)) {
+        std::cerr << "Reading the sigRL data file failed\n";
+        return EXIT_FAILURE;
+    }
+    if (!sig_rl.save_rl(
+          filename + '.' + sigrl_binary_file_ext, Rl_file_format::binary)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Convert the text list <filename>.srlist to n_shards shards and a manifest
+int shard_srl(std::string const &filename, size_t n_shards)
+{
+    Epid_sig_rl sig_rl;
+    if (!read_rl_text(sig_rl, filename + '.' + sigrl_file_ext)) {
+        std::cerr << "Reading the sigRL data file failed\n";
+        return EXIT_FAILURE;
+    }
+    return save_rl_shards(sig_rl, filename, n_shards) ? EXIT_SUCCESS
+                                                      : EXIT_FAILURE;
+}
+
+// Generate a list straight into n_shards shards, one shard at a time, so
+// only one shard is held in memory
+int generate_srl_shards(
+  std::string const &filename, size_t n_srl_entries, size_t n_shards)
+{
+    n_shards = std::max<size_t>(1, std::min(n_shards, n_srl_entries));
+    Rl_shard_writer writer;
+    writer.open(filename, Epid_sigrl_entry::list_name, Rl_binary_type::sigrl,
+      Epid_sigrl_entry::n_states_, sizeof(Epid_sigrl_entry),
+      sigrl_binary_file_ext, sigrl_manifest_file_ext);
+    Epid_sig_rl shard;
+    size_t first = 0;
+    for (size_t s = 0; s < n_shards; ++s) {
+        size_t end = n_srl_entries * (s + 1) / n_shards;
+        shard.clear();
+        if (!generate_epid_revocation_lists(shard, end - first)
+            || !writer.add_shard(
+              reinterpret_cast<uint8_t const *>(shard.data()), shard.size())) {
+            return EXIT_FAILURE;
+        }
+        first = end;
+    }
+    return writer.commit() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Convert the text list <filename>.srlist to the transport form,
+// <filename>.srlt
+int make_srl_transport(std::string const &filename)
+{
+    Epid_sig_rl sig_rl;
+    if (!read_rl_text(sig_rl, filename + '.' + sigrl_file_ext)) {
+        std::cerr << "Reading the sigRL data file failed\n";
+        return EXIT_FAILURE;
+    }
+    std::string transport_filename = filename + '.' + sigrl_transport_file_ext;
+    std::ofstream os{ transport_filename, std::ios::binary };
+    if (!os || !send_rl(os, sig_rl) || !os.flush()) {
+        std::cerr << "Failed to write the file " << transport_filename << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Check the text list <filename>.srlist for entries with their padding set
+// and for repeated entries, and print what was found
+int check_srl(std::string const &filename)
+{
+    Epid_sig_rl sig_rl;
+    if (!read_rl_text(sig_rl, filename + '.' + sigrl_file_ext)) {
+        std::cerr << "Reading the sigRL data file failed\n";
+        return EXIT_FAILURE;
+    }
+    Rl_check_report report;
+    bool usable = check_rl(Sigrl_view(sig_rl), report);
+    print_rl_check_report(std::cout, report);
+    return (usable && report.clean()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Compare the text, binary and transport forms of <filename>.srlist: the
+// bytes each takes and the time to read (or receive) each. The transport
+// form is decoded from memory, as it would be from the network, both into a
+// list in memory and into the binary form on disk.
+int benchmark_srl_forms(std::string const &filename)
+{
+    size_t const entry_bytes = sizeof(Epid_sigrl_entry);
+    F_timer_ms timer;
+    Epid_sig_rl text_rl;
+    if (!read_rl_text(text_rl, filename + '.' + sigrl_file_ext)) {
+        return EXIT_FAILURE;
+    }
+    float text_ms = timer.get_duration();
+    std::ifstream text_is{ filename + '.' + sigrl_file_ext,
+        std::ios::binary | std::ios::ate };
+    auto text_bytes = static_cast<size_t>(text_is.tellg());
+
+    std::string binary_filename = filename + ".bench." + sigrl_binary_file_ext;
+    if (!save_rl_binary(text_rl, binary_filename)) { return EXIT_FAILURE; }
+    Epid_sig_rl binary_rl;
+    timer.reset();
+    if (!read_rl_binary(binary_rl, binary_filename)) { return EXIT_FAILURE; }
+    float binary_ms = timer.get_duration();
+    timer.reset();
+    if (!read_rl_binary(binary_rl, binary_filename, false)) {
+        return EXIT_FAILURE;
+    }
+    float unchecked_ms = timer.get_duration();
+    size_t binary_bytes = rl_binary_header_bytes + text_rl.size() * entry_bytes;
+
+    std::ostringstream os;
+    timer.reset();
+    if (!send_rl(os, text_rl)) { return EXIT_FAILURE; }
+    float encode_ms = timer.get_duration();
+    std::string wire = os.str();
+
+    Epid_sig_rl received_rl;
+    Rl_transport_sink sink;
+    sink.header_ = [&received_rl](Rl_transport_header const &header) {
+        received_rl.reserve(static_cast<size_t>(
+          std::min<uint64_t>(header.n_entries_, rl_read_max_reserve)));
+        return true;
+    };
+    sink.records_ = [&received_rl](uint8_t const *records, size_t n) {
+        received_rl.append_range(
+          reinterpret_cast<Epid_sigrl_entry const *>(records), n);
+        return true;
+    };
+    Rl_transport_decoder decoder(Rl_binary_type::sigrl,
+      Epid_sigrl_entry::n_states_, entry_bytes, std::move(sink));
+    std::istringstream wire_is{ wire };
+    timer.reset();
+    if (!decode_rl_transport_stream(wire_is, decoder)) { return EXIT_FAILURE; }
+    float decode_ms = timer.get_duration();
+
+    wire_is.clear();
+    wire_is.seekg(0);
+    timer.reset();
+    if (!receive_rl_binary<Epid_sigrl_entry>(wire_is, binary_filename)) {
+        return EXIT_FAILURE;
+    }
+    float receive_ms = timer.get_duration();
+    std::remove(binary_filename.c_str());
+
+    if (received_rl.size() != text_rl.size()
+        || std::memcmp(received_rl.data(), text_rl.data(),
+             text_rl.size() * entry_bytes)
+             != 0) {
+        std::cerr << "The list received is not the list sent\n";
+        return EXIT_FAILURE;
+    }
+
+    // The binary and transport forms are checked against their digest as
+    // they are read, the text form has none
+    std::cout << filename << '\t' << text_rl.size() << " entries\n"
+              << "form\tbytes\tbytes/entry\tread (ms)\n"
+              << std::fixed << std::setprecision(2);
+    auto per_entry = [&text_rl](size_t bytes) {
+        return text_rl.empty() ? 0.0 : double(bytes) / double(text_rl.size());
+    };
+    std::cout << "text\t" << text_bytes << '\t' << per_entry(text_bytes)
+              << '\t' << text_ms << '\n'
+              << "binary\t" << binary_bytes << '\t' << per_entry(binary_bytes)
+              << '\t' << binary_ms << " (without the digest check "
+              << unchecked_ms << ")\n"
+              << "transport\t" << wire.size() << '\t' << per_entry(wire.size())
+              << '\t' << decode_ms << " (to disk " << receive_ms
+              << ", encode " << encode_ms << ")\n";
+    return EXIT_SUCCESS;
+}
+
+// Generate n_srl_entries new entries and append them to the store
+// <filename> as one delta
+int append_srl_delta(std::string const &filename, size_t n_srl_entries)
+{
+    Epid_sig_rl delta;
+    if (!generate_epid_revocation_lists(delta, n_srl_entries)) {
+        return EXIT_FAILURE;
+    }
+    uint64_t version = 0;
+    if (!append_rl_delta(filename, delta.data(), delta.size(), version)) {
+        return EXIT_FAILURE;
+    }
+    std::cout << filename << " is now at version " << version << '\n';
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char **argv)
 {
-    if (argc != 4) {
+    if (argc == 4 && std::string(argv[1]) == "-c") {
+        return convert_srl(make_filename(argv[2], argv[3]));
+    }
+    if (argc == 5 && std::string(argv[1]) == "-d") {
+        return append_srl_delta(make_filename(argv[2], argv[3]),
+          std::strtoul(argv[4], nullptr, 10));
+    }
+    if (argc == 4 && std::string(argv[1]) == "-t") {
+        return make_srl_transport(make_filename(argv[2], argv[3]));
+    }
+    if (argc == 4 && std::string(argv[1]) == "-b") {
+        return benchmark_srl_forms(make_filename(argv[2], argv[3]));
+    }
+    if (argc == 4 && std::string(argv[1]) == "-v") {
+        return check_srl(make_filename(argv[2], argv[3]));
+    }
+    if (argc == 5 && std::string(argv[1]) == "-s") {
+        return shard_srl(make_filename(argv[2], argv[3]),
+          std::strtoul(argv[4], nullptr, 10));
+    }
+
+    if (argc < 4 || argc > 6) {
         usage(std::cout, argv[0]);
         return EXIT_FAILURE;
     }
@@ -110,20 +332,41 @@ int main(int argc, char **argv)
     std::string base_dir{ argv[1] };
     std::string revocation_file{ argv[2] };
     size_t n_srl_entries = std::strtoul(argv[3], nullptr, 10);
+    std::string format{ (argc >= 5) ? str_tolower(argv[4]) : "text" };
+    bool text = (format == "text" || format == "both");
+    bool binary = (format == "binary" || format == "both");
+    bool store = (format == "store");
+    bool shards = (format == "shards");
+    if ((!text && !binary && !store && !shards) || (argc == 6 && !shards)) {
+        std::cerr << "The format must be text, binary, both, store or shards "
+                     "<number of shards>\n";
+        usage(std::cerr, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string filename = make_filename(base_dir, revocation_file);
+    if (shards) {
+        size_t n_shards =
+          (argc == 6) ? std::strtoul(argv[5], nullptr, 10) : default_n_shards;
+        return generate_srl_shards(filename, n_srl_entries, n_shards);
+    }
 
     Epid_sig_rl sig_rl;
 
-    generate_epid_revocation_lists(sig_rl, n_srl_entries);
+    if (!generate_epid_revocation_lists(sig_rl, n_srl_entries)) {
+        return EXIT_FAILURE;
+    }
 
-    std::string filename = make_filename(base_dir, revocation_file);
-    std::string srl_filename = filename + '.' + sigrl_file_ext;
-    std::ofstream srl_os{ srl_filename };
-    if (!srl_os) {
-        std::cerr << "Unable to create the file " << srl_filename << '\n';
+    if (text && !sig_rl.save_rl(filename + '.' + sigrl_file_ext)) {
+        return EXIT_FAILURE;
+    }
+    if (binary
+        && !sig_rl.save_rl(
+          filename + '.' + sigrl_binary_file_ext, Rl_file_format::binary)) {
         return EXIT_FAILURE;
     }
-    sig_rl.print_rl(srl_os);
-    srl_os.close();
+    if (store && !save_rl_snapshot(sig_rl, filename)) { return EXIT_FAILURE; }
+    return EXIT_SUCCESS;
 }
 
 void usage(std::ostream &os, std::string program)
@@ -132,5 +375,30 @@ void usage(std::ostream &os, std::string program)
        << "A program to generate and save the revocation data for the hash "
           "based EPID protocol.\n"
        << normal << program
-       << " <base dir> <revocation file name> <number of srl entries> \n\n";
+       << " <base dir> <revocation file name> <number of srl entries> "
+          "[text|binary|both|store|shards [<number of shards>]]\n"
+       << program << " -c <base dir> <revocation file name>\n"
+       << program
+       << " -s <base dir> <revocation file name> <number of shards>\n"
+       << program << " -t <base dir> <revocation file name>\n"
+       << program << " -b <base dir> <revocation file name>\n"
+       << program << " -v <base dir> <revocation file name>\n"
+       << program
+       << " -d <base dir> <revocation file name> <number of new entries>\n\n"
+       << "The list is saved as text (." << sigrl_file_ext
+       << ") by default, or in the binary form (." << sigrl_binary_file_ext
+       << ").\nWith store a versioned store is started, a binary snapshot "
+          "and an empty log (."
+       << sigrl_log_file_ext
+       << ").\nWith -c an existing text list is converted to the binary "
+          "form.\nWith shards the list is saved as shards in the binary form, "
+          "with a manifest (."
+       << sigrl_manifest_file_ext << "), " << default_n_shards
+       << " shards by default.\nWith -s an existing text list is split into "
+          "shards.\nWith -t an existing text list is saved in the transport "
+          "form (."
+       << sigrl_transport_file_ext
+       << ") and with -b the sizes and read times of the text, binary and "
+          "transport forms are compared.\nWith -v an existing text list is "
+          "checked for repeated entries and padding.\nWith -d new entries are added to a store as a delta.\n\n";
 }
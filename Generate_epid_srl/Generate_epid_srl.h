@@ -39,12 +39,16 @@
 #ifndef GENERATE_EPID_RL_H
 #define GENERATE_EPID_RL_H
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 #include "Clock_utils.h"
 
 void usage(std::ostream &os, std::string program);
 
+// The number of shards a list is split into if it is not given
+constexpr size_t default_n_shards = 4;
+
 struct Mpc_time_point
 {
     std::string type_;
@@ -36,7 +36,9 @@
 *                                                                              *
 *******************************************************************************/
 #include <cmath>
+#include <algorithm>
 #include <cinttypes>
+#include <cstdio>
 #include <cstring>
 #include <thread>
 #include <exception>
@@ -44,6 +46,10 @@
 #include <iomanip>
 #include <string>
 #include <vector>
+#include <array>
+#include <memory>
+#include <fstream>
+#include <sstream>
 #include "Io_utils.h"
 
 #include "picnic.h"
@@ -60,7 +66,17 @@ extern "C" {
 #include "Mpc_working_data.h"
 #include "Mpc_sign.h"
 #include "Mpc_verify.h"
+#include "Mpc_memory.h"
+#include "Mpc_footprint.h"
+#include "Mpc_pipeline.h"
+#include "Mpc_thread_pool.h"
 #include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_binary.h"
+#include "Hb_epid_rl_text.h"
+#include "Hb_epid_rl_store.h"
+#include "Hb_epid_rl_shards.h"
+#include "Hb_epid_rl_transport.h"
+#include "Hb_epid_rl_index.h"
 #include "Hbgs_epid_signature.h"
 #include "Hbgs_sigrl_list_test.h"
 
@@ -75,15 +91,28 @@ Mpc_param Hbgs_sigrl_list_test::mpc_param_{
 };
 
 Hbgs_sigrl_list_test::Hbgs_sigrl_list_test(Lowmc_state_words64_const_ptr sid,
-  Lowmc_state_words64_const_ptr r_value, Epid_sig_rl const &srl) noexcept
-  : srl_(srl)
+  Lowmc_state_words64_const_ptr r_value, Sigrl_view srl) noexcept
+  : srl_(srl), n_entries_(srl.size())
 {
     std::memcpy(sid_, sid, Mpc_parameters::lowmc_state_bytes_);
     std::memcpy(r_value_, r_value, Mpc_parameters::lowmc_state_bytes_);
 
     mpc_param_ =
-      scale_mpc_param(single_entry_mpc_param_, srl_.size()) + sst_mpc_param_;
-    sigrl_entry_offsets_.resize(srl_.size());
+      scale_mpc_param(single_entry_mpc_param_, n_entries_) + sst_mpc_param_;
+
+    get_param_set(get_picnic_parameter_set_id(), &paramset_);
+}
+
+Hbgs_sigrl_list_test::Hbgs_sigrl_list_test(Lowmc_state_words64_const_ptr sid,
+  Lowmc_state_words64_const_ptr r_value,
+  Epid_sig_rl_packed const &srl) noexcept
+  : packed_srl_(&srl), n_entries_(srl.size())
+{
+    std::memcpy(sid_, sid, Mpc_parameters::lowmc_state_bytes_);
+    std::memcpy(r_value_, r_value, Mpc_parameters::lowmc_state_bytes_);
+
+    mpc_param_ =
+      scale_mpc_param(single_entry_mpc_param_, n_entries_) + sst_mpc_param_;
 
     get_param_set(get_picnic_parameter_set_id(), &paramset_);
 }
@@ -115,14 +144,10 @@ Tape_offset Hbgs_sigrl_list_test::set_offsets(Tape_offset const &of) noexcept
     next_offset = sst_lowmc_.set_offsets(next_offset);
 
     Mpc_sigrl_entry entry;
-    Tape_offset entry_offset_delta = entry.set_offsets(0);
-    auto srl_size = static_cast<uint32_t>(srl_.size());
-    sigrl_entry_offsets_[0] = next_offset;
-    for (uint32_t e = 1; e < srl_size; ++e) {
-        sigrl_entry_offsets_[e] = next_offset + e * entry_offset_delta;
-    }
+    entry_offset_delta_ = entry.set_offsets(0);
+    first_entry_offset_ = next_offset;
 
-    return next_offset + srl_size * entry_offset_delta;
+    return entry_offset(n_entries_);
 }
 
 void Hbgs_sigrl_list_test::compute_salt_and_root_seed(
@@ -139,114 +164,38 @@ void Hbgs_sigrl_list_test::compute_salt_and_root_seed(
     HashSqueeze(&ctx, salt_and_root, s_and_r_len);
 }
 
-void Hbgs_sigrl_list_test::compute_aux_tape_sign(
-  randomTape_t *tapes, Mpc_working_data &mpc_wd, size_t t) noexcept
-{
-    randomTape_t *current_tape_ptr = &tapes[t];
-
-    Lowmc_state_words64 null_mask{ 0 };
-    sst_lowmc_.compute_aux_tape(current_tape_ptr, null_mask, null_mask,
-      reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[0][t]), &paramset_);
-
-
-    Lowmc_state_words64 sku_mask = { 0 };
-    if (sku_mask_offset_ != null_offset) {
-        get_mask_from_tapes(
-          sku_mask, current_tape_ptr, sku_mask_offset_, &paramset_);
-    }
-
-    xor64(reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[0][t]), sku_mask);
-
-    Mpc_proof_indices cpi = pi_;
-    for (size_t e = 0; e < srl_.size(); ++e) {
-        size_t mpc_base = cpi.mpc_input_index_;
-        Mpc_sigrl_entry mpc_entry;
-        mpc_entry.set_offsets(sigrl_entry_offsets_[e]);
-
-        mpc_entry.compute_aux_tape(current_tape_ptr,
-          reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[mpc_base][t]),
-          reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[mpc_base + 1][t]),
-          &paramset_);
-
-        auto *masked_sku =
-          reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[mpc_base][t]);
-        xor64(masked_sku, sku_mask);
-
-        cpi = indices_add_mpc_param(cpi, single_entry_mpc_param_);
-    }
-}
-
-void Hbgs_sigrl_list_test::compute_aux_tape_verify(randomTape_t *tapes,
-  [[maybe_unused]] Signature_data const &sig_data, size_t t) noexcept
+Tape_offset Hbgs_sigrl_list_test::tape_window_bits() const noexcept
 {
-    randomTape_t *current_tape_ptr = &tapes[t];
-
-    Lowmc_state_words64 null_mask{ 0 };
-    sst_lowmc_.compute_aux_tape(
-      current_tape_ptr, null_mask, null_mask, nullptr, &paramset_);
-
-
-    for (size_t e = 0; e < srl_.size(); ++e) {
-        Mpc_sigrl_entry mpc_entry;
-        mpc_entry.set_offsets(sigrl_entry_offsets_[e]);
-        mpc_entry.compute_aux_tape(
-          current_tape_ptr, nullptr, nullptr, &paramset_);
-    }
+    // The sku mask and the sst LowMC come before the first entry
+    return std::max(first_entry_offset_, entry_offset_delta_);
 }
 
-void Hbgs_sigrl_list_test::get_aux_bits(
-  uint8_t *aux_bits, randomTape_t *tapes, size_t t) noexcept
+size_t Hbgs_sigrl_list_test::max_step_bits() const noexcept
 {
-    randomTape_t *current_tape_ptr = &tapes[t];
-
-    uint32_t aux_pos = 0;
-    sst_lowmc_.get_aux_bits(aux_bits, aux_pos, current_tape_ptr);
-
-    for (size_t e = 0; e < srl_.size(); ++e) {
-        Mpc_sigrl_entry mpc_entry;
-        mpc_entry.set_offsets(sigrl_entry_offsets_[e]);
-        mpc_entry.get_aux_bits(aux_bits, aux_pos, current_tape_ptr);
-    }
-#ifdef DEBUG_AUX
-    std::cout << "get - Tape: " << t << '\n' << magenta;
-    print_buffer(std::cout, aux_bits, mpc_param_.aux_size_bytes_);
-    std::cout << normal << '\n';
-#endif
+    return std::max(
+      sst_mpc_param_.aux_size_bits_, single_entry_mpc_param_.aux_size_bits_);
 }
 
-void Hbgs_sigrl_list_test::set_aux_bits(
-  randomTape_t *tapes, Signature_data const &sig_data, size_t t) noexcept
+// The tapes are streamed, so for each part of the tape the aux bits are
+// computed, saved and then used for the simulation before moving on. The
+// values produced are passed on to the stream a step at a time.
+int Hbgs_sigrl_list_test::sign_repetition(Mpc_streaming_tapes &tapes,
+  Mpc_repetition_stream &stream, shares_t *tmp_shares) noexcept
 {
-    randomTape_t *current_tape_ptr = &tapes[t];
-    uint32_t aux_pos = 0;
-    sst_lowmc_.set_aux_bits(
-      current_tape_ptr, aux_pos, sig_data.proofs_[t]->aux_);
+    // The first window starts at 0, so the offsets are unchanged
+    randomTape_t *current_tape_ptr = tapes.window(0, first_entry_offset_);
 
-    for (size_t e = 0; e < srl_.size(); ++e) {
-        Mpc_sigrl_entry mpc_entry;
-        mpc_entry.set_offsets(sigrl_entry_offsets_[e]);
-        mpc_entry.set_aux_bits(
-          current_tape_ptr, aux_pos, sig_data.proofs_[t]->aux_);
-    }
-#ifdef DEBUG_AUX
-    std::cout << "set - Tape: " << t << '\n' << magenta;
-    print_buffer(
-      std::cout, sig_data.proofs_[t]->aux_, mpc_param_.aux_size_bytes_);
-    std::cout << normal << '\n';
-#endif
-}
-
-int Hbgs_sigrl_list_test::mpc_simulate_sign(randomTape_t *tapes,
-  Mpc_working_data &mpc_wd, shares_t *tmp_shares, size_t t) noexcept
-{
-    // std::cout << "\nRound " << t;
-    randomTape_t *current_tape_ptr = &tapes[t];
+    Lowmc_state_words64 null_mask{ 0 };
+    Word *sku_input = stream.mpc_input(0);
+    sst_lowmc_.compute_aux_tape(
+      current_tape_ptr, null_mask, null_mask, sku_input, &paramset_);
 
     Lowmc_state_words64 sku_mask = { 0 };
     if (sku_mask_offset_ != null_offset) {
         get_mask_from_tapes(
           sku_mask, current_tape_ptr, sku_mask_offset_, &paramset_);
     }
+    sst_lowmc_.get_aux_bits(stream.aux_bits_, stream.aux_pos_, current_tape_ptr);
 
     Lowmc_state_words64 masked_sku = { 0 };
     xor64(masked_sku, sk_u_, sku_mask);
@@ -257,32 +206,39 @@ int Hbgs_sigrl_list_test::mpc_simulate_sign(randomTape_t *tapes,
     std::cout << '\n';
 #endif
 
-    xor64(reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[0][t]), masked_sku);
-    /*
-        auto remasked_sku_input = (Word *)mpc_wd.mpc_inputs_[0][t];
-        xor64(remasked_sku_input, masked_sku);
-    */
-    int rv{ 0 };
-    rv = sst_lowmc_.mpc_simulate(
-      reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[0][t]), sid_,
-      current_tape_ptr, tmp_shares, &mpc_wd.msgs_[t],
-      reinterpret_cast<Word *>(mpc_wd.outputs_[0][t]), &paramset_);
+    // The adjusted sku mask xor the masked sku
+    xor64(sku_input, sku_mask);
+    xor64(sku_input, masked_sku);
+
+    Word *sst_output = stream.output(0);
+    int rv = sst_lowmc_.mpc_simulate(sku_input, sid_, current_tape_ptr,
+      tmp_shares, stream.msgs_, sst_output, &paramset_);
 #ifdef DEBUG_OUTPUTS
     std::cout << green << "    simulated sst: ";
-    print_lowmc_state_words64(std::cout, (Word *)mpc_wd.outputs_[0][t]);
+    print_lowmc_state_words64(std::cout, sst_output);
     std::cout << normal << '\n';
 #endif
+    stream.step_done();
 
     Mpc_proof_indices cpi = pi_;
-    for (size_t e = 0; e < srl_.size(); ++e) {
+    for (size_t e = 0; e < n_entries_; ++e) {
         size_t mpc_base = cpi.mpc_input_index_;
         size_t output_base = cpi.output_index_;
+        Tape_offset entry_start = entry_offset(e);
+        current_tape_ptr =
+          tapes.window(entry_start, entry_start + entry_offset_delta_);
         Mpc_sigrl_entry mpc_entry;
-        mpc_entry.set_offsets(sigrl_entry_offsets_[e]);
+        mpc_entry.set_offsets(entry_start - tapes.window_offset());
+
+        Word *remasked_sku_input = stream.mpc_input(mpc_base);
+        Word *i_mask_adjustment = stream.mpc_input(mpc_base + 1);
+        mpc_entry.compute_aux_tape(
+          current_tape_ptr, remasked_sku_input, i_mask_adjustment, &paramset_);
+        mpc_entry.get_aux_bits(
+          stream.aux_bits_, stream.aux_pos_, current_tape_ptr);
 
         // Re-mask sku and save for verify
-        auto *remasked_sku_input =
-          reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[mpc_base][t]);
+        xor64(remasked_sku_input, sku_mask);
         xor64(remasked_sku_input, masked_sku);
 
 #ifdef DEBUG_MPC_INPUTS
@@ -290,42 +246,84 @@ int Hbgs_sigrl_list_test::mpc_simulate_sign(randomTape_t *tapes,
         print_lowmc_state_words64(std::cout, remasked_sku_input);
         std::cout << '\n';
 #endif
-        Epid_sigrl_entry const &entry = srl_[e];
-        rv = mpc_entry.mpc_simulate(remasked_sku_input, entry.first(),
-          reinterpret_cast<Word *>(mpc_wd.mpc_inputs_[mpc_base + 1][t]),
-          r_value_, current_tape_ptr, tmp_shares, &mpc_wd.msgs_[t],
-          reinterpret_cast<Word *>(mpc_wd.outputs_[output_base][t]),
-          &paramset_);
+        Lowmc_state_words64 sid_buffer;
+        Word *output_a_j = stream.output(output_base);
+        rv = mpc_entry.mpc_simulate(remasked_sku_input,
+          entry_sid(e, sid_buffer), i_mask_adjustment, r_value_,
+          current_tape_ptr, tmp_shares, stream.msgs_, output_a_j, &paramset_);
 
         cpi = indices_add_mpc_param(cpi, single_entry_mpc_param_);
 
 #ifdef DEBUG_OUTPUTS
         std::cout << red << "    simulated a_j: ";
-        print_lowmc_state_words64(
-          std::cout, reinterpret_cast<Word *>(mpc_wd.outputs_[output_base][t]));
+        print_lowmc_state_words64(std::cout, output_a_j);
         std::cout << normal << '\n';
 #endif
+        stream.step_done();
     }
     return rv;
 }
 
-int Hbgs_sigrl_list_test::mpc_simulate_and_verify(randomTape_t *tapes,
-  Signature_data const &sig_data, msgs_t *msgs,
-  Revocation_checking_data const &cd, shares_t *tmp_shares, size_t t) noexcept
+void Hbgs_sigrl_list_test::compute_aux_bits_verify(
+  Mpc_streaming_tapes &tapes, Mpc_repetition_stream &stream) noexcept
 {
-    // std::cout << "\nRound " << t;
-    randomTape_t *current_tape_ptr = &tapes[t];
-    int rv{ 0 };
+    randomTape_t *current_tape_ptr = tapes.window(0, first_entry_offset_);
 
+    Lowmc_state_words64 null_mask{ 0 };
+    sst_lowmc_.compute_aux_tape(
+      current_tape_ptr, null_mask, null_mask, nullptr, &paramset_);
+    sst_lowmc_.get_aux_bits(stream.aux_bits_, stream.aux_pos_, current_tape_ptr);
+    stream.step_done();
+
+    for (size_t e = 0; e < n_entries_; ++e) {
+        Tape_offset entry_start = entry_offset(e);
+        current_tape_ptr =
+          tapes.window(entry_start, entry_start + entry_offset_delta_);
+        Mpc_sigrl_entry mpc_entry;
+        mpc_entry.set_offsets(entry_start - tapes.window_offset());
+        mpc_entry.compute_aux_tape(
+          current_tape_ptr, nullptr, nullptr, &paramset_);
+        mpc_entry.get_aux_bits(
+          stream.aux_bits_, stream.aux_pos_, current_tape_ptr);
+        stream.step_done();
+    }
+}
+
+// The unopened party must already be hidden on the tapes and set in the
+// stream's messages. The states in the proof need not be aligned, so they are
+// copied before use.
+int Hbgs_sigrl_list_test::simulate_and_verify_repetition(
+  Mpc_streaming_tapes &tapes, Mpc_proof_view const &proof,
+  Mpc_repetition_stream &stream, Revocation_checking_view const &cd,
+  shares_t *tmp_shares, size_t t) noexcept
+{
+    // proof.aux_ is only set when the unopened party is not the last one
+    uint8_t const *proof_aux = proof.aux_;
+    uint32_t aux_pos = 0;
+#ifdef DEBUG_AUX
+    if (proof_aux != nullptr) {
+        std::cout << "set - Tape: " << t << '\n' << magenta;
+        print_buffer(std::cout, proof_aux, mpc_param_.aux_size_bytes_);
+        std::cout << normal << '\n';
+    }
+#endif
+
+    randomTape_t *current_tape_ptr = tapes.window(0, first_entry_offset_);
+    if (proof_aux != nullptr) {
+        sst_lowmc_.set_aux_bits(current_tape_ptr, aux_pos, proof_aux);
+    }
+
+    Lowmc_state_words64 sku_input{ 0 };
+    std::memcpy(sku_input, proof.mpc_input(0), paramset_.stateSizeBytes);
     Lowmc_state_words64 sst{ 0 };
-    rv = sst_lowmc_.mpc_simulate(
-      reinterpret_cast<Word *>(sig_data.proofs_[t]->mpc_inputs_[0]), sid_,
-      current_tape_ptr, tmp_shares, msgs, sst, &paramset_);
+    int rv = sst_lowmc_.mpc_simulate(sku_input, sid_, current_tape_ptr,
+      tmp_shares, stream.msgs_, sst, &paramset_);
     if (rv != 0) {
         std::cerr << "MPC simulation of sst failed for round " << t
                   << ", signature invalid\n";
         return EXIT_FAILURE;
     }
+    stream.step_done();
 
 #ifdef DEBUG_OUTPUTS
     std::cout << green << "  simulated sst - v: ";
@@ -333,8 +331,7 @@ int Hbgs_sigrl_list_test::mpc_simulate_and_verify(randomTape_t *tapes,
     std::cout << normal << '\n';
 #endif
 
-    if (memcmp(sig_data.proofs_[t]->outputs_[0], sst, paramset_.stateSizeBytes)
-        != 0) {
+    if (memcmp(proof.output(0), sst, paramset_.stateSizeBytes) != 0) {
         std::cerr << "Verification failed - the simulated output for sst "
                      "does not match\n";
         // return EXIT_FAILURE;
@@ -348,31 +345,39 @@ int Hbgs_sigrl_list_test::mpc_simulate_and_verify(randomTape_t *tapes,
 
     Epid_arl_entry output{};
     Mpc_proof_indices cpi = pi_;
-    for (size_t e = 0; e < srl_.size(); ++e) {
+    for (size_t e = 0; e < n_entries_; ++e) {
         size_t mpc_base = cpi.mpc_input_index_;
         size_t output_base = cpi.output_index_;
+        Tape_offset entry_start = entry_offset(e);
+        current_tape_ptr =
+          tapes.window(entry_start, entry_start + entry_offset_delta_);
         Mpc_sigrl_entry mpc_entry;
-        mpc_entry.set_offsets(sigrl_entry_offsets_[e]);
+        mpc_entry.set_offsets(entry_start - tapes.window_offset());
+        if (proof_aux != nullptr) {
+            mpc_entry.set_aux_bits(current_tape_ptr, aux_pos, proof_aux);
+        }
 
+        Lowmc_state_words64 masked_sku{ 0 };
+        std::memcpy(
+          masked_sku, proof.mpc_input(mpc_base), paramset_.stateSizeBytes);
+        Lowmc_state_words64 masked_s{ 0 };
+        std::memcpy(
+          masked_s, proof.mpc_input(mpc_base + 1), paramset_.stateSizeBytes);
 #ifdef DEBUG_MPC_INPUTS
         std::cout << "\n       masked sku: ";
-        print_lowmc_state_words64(
-          std::cout, (Word *)sig_data.proofs_[t]->mpc_inputs_[mpc_base]);
+        print_lowmc_state_words64(std::cout, masked_sku);
         std::cout << '\n';
 #endif
-        Epid_sigrl_entry const &srl_entry = srl_[e];
-        rv = mpc_entry.mpc_simulate(
-          reinterpret_cast<Word *>(sig_data.proofs_[t]->mpc_inputs_[mpc_base]),
-          srl_entry.first(),
-          reinterpret_cast<Word *>(
-            sig_data.proofs_[t]->mpc_inputs_[mpc_base + 1]),
-          r_value_, current_tape_ptr, tmp_shares, msgs, output.entry(),
-          &paramset_);
+        Lowmc_state_words64 sid_buffer;
+        rv = mpc_entry.mpc_simulate(masked_sku, entry_sid(e, sid_buffer),
+          masked_s, r_value_, current_tape_ptr, tmp_shares, stream.msgs_,
+          output.entry(), &paramset_);
         if (rv != 0) {
             std::cerr << "MPC simulation failed for round " << t
                       << ", signature invalid\n";
             return EXIT_FAILURE;
         }
+        stream.step_done();
 
 #ifdef DEBUG_OUTPUTS
         std::cout << red << "simulated entry - v: ";
@@ -380,7 +385,7 @@ int Hbgs_sigrl_list_test::mpc_simulate_and_verify(randomTape_t *tapes,
         std::cout << normal << '\n';
 #endif
 
-        if (memcmp(sig_data.proofs_[t]->outputs_[output_base], output.entry(),
+        if (memcmp(proof.output(output_base), output.entry(),
               paramset_.stateSizeBytes)
             != 0) {
             std::cerr << "Verification failed - the simulated outputs for a_j "
@@ -404,36 +409,8 @@ int Hbgs_sigrl_list_test::mpc_simulate_and_verify(randomTape_t *tapes,
 void Hbgs_sigrl_list_test::commit_v_sign(
   Commitment_data2 &c2, Mpc_working_data const &mpc_wd, size_t t)
 {
-    HashInstance ctx;
-
-    msgs_t *msgs = &mpc_wd.msgs_[t];
-
-    HashInit(&ctx, &paramset_, HASH_PREFIX_NONE);
-    HashUpdate(&ctx, mpc_wd.mpc_inputs_[0][t], paramset_.stateSizeBytes);
-    for (size_t i = 0; i < paramset_.numMPCParties; i++) {
-        auto msgs_size =
-          static_cast<size_t>(numBytes(static_cast<uint32_t>(msgs->pos)));
-        HashUpdate(&ctx, msgs->msgs[i], msgs_size);
-    }
-    HashFinal(&ctx);
-    HashSqueeze(&ctx, c2.Cv.hashes[t], paramset_.digestSizeBytes);
-}
-
-void Hbgs_sigrl_list_test::commit_v_verify(Commitment_data2 &c2,
-  Signature_data const &sig_data, msgs_t const *msgs, size_t t)
-{
-    HashInstance ctx;
-
-    HashInit(&ctx, &paramset_, HASH_PREFIX_NONE);
-    HashUpdate(
-      &ctx, sig_data.proofs_[t]->mpc_inputs_[0], paramset_.stateSizeBytes);
-    for (size_t i = 0; i < paramset_.numMPCParties; i++) {
-        auto msgs_size =
-          static_cast<size_t>(numBytes(static_cast<uint32_t>(msgs->pos)));
-        HashUpdate(&ctx, msgs->msgs[i], msgs_size);
-    }
-    HashFinal(&ctx);
-    HashSqueeze(&ctx, c2.Cv.hashes[t], paramset_.digestSizeBytes);
+    commit_v_views(c2.Cv.hashes[t], mpc_wd.mpc_inputs_.state(0, t),
+      &mpc_wd.msgs_[t], &paramset_);
 }
 
 void Hbgs_sigrl_list_test::calculate_hcp(uint8_t *challenge_hash,
@@ -460,16 +437,16 @@ void Hbgs_sigrl_list_test::save_proof_data(
 {
     for (size_t i = 0; i < proof->mpc_inputs_.size(); ++i) {
         memcpy(proof->mpc_inputs_[i],
-          mpc_wd.mpc_inputs_[i][t],
+          mpc_wd.mpc_inputs_.state(i, t),
           paramset_.stateSizeBytes);
     }
     for (size_t i = 0; i < proof->outputs_.size(); ++i) {
-        memcpy(
-          proof->outputs_[i], mpc_wd.outputs_[i][t], paramset_.stateSizeBytes);
+        memcpy(proof->outputs_[i], mpc_wd.outputs_.state(i, t),
+          paramset_.stateSizeBytes);
     }
     for (size_t i = 0; i < proof->inputs_.size(); ++i) {
-        memcpy(
-          proof->inputs_[i], mpc_wd.inputs_[i][t], paramset_.stateSizeBytes);
+        memcpy(proof->inputs_[i], mpc_wd.inputs_.state(i, t),
+          paramset_.stateSizeBytes);
     }
 }
 
@@ -554,16 +531,44 @@ bool read_srl_data(
   Epid_sig_rl &sig_rl, std::string const &base_dir, std::string const &srl_name)
 {
     std::string filename = make_filename(base_dir, srl_name);
-    std::string srl_filename = filename + '.' + sigrl_file_ext;
-    std::ifstream srl_is{ srl_filename };
-    if (!srl_is) {
-        std::cerr << "Unable to open the file " << srl_filename << '\n';
-        return false;
+    bool read_status_ok = false;
+    // If HBGS_SRL_STORE is set the list is read from a store (a snapshot and
+    // its log of deltas), if HBGS_SRL_SHARDS is set from the shards given by
+    // its manifest and if HBGS_SRL_BINARY is set the binary form of the list
+    // is read instead. If HBGS_SRL_TRANSPORT is set the list is received from
+    // its transport form, as a verifier would be sent it, into the binary
+    // form which is then read.
+    if (!get_environment_variable("HBGS_SRL_STORE", "").empty()) {
+        Hb_epid_rl_store<Epid_sigrl_entry> store;
+        read_status_ok = store.open(filename);
+        if (read_status_ok) { sig_rl = store.list(); }
+#ifndef MINIMAL_PRINTING
+        std::cout << "Store version " << store.version() << '\n';
+#endif
+    } else if (!get_environment_variable("HBGS_SRL_TRANSPORT", "").empty()) {
+        std::ifstream is{ filename + '.' + sigrl_transport_file_ext,
+            std::ios::binary };
+        if (!is) {
+            std::cerr << "Unable to open the file " << filename << '.'
+                      << sigrl_transport_file_ext << '\n';
+        }
+        // The digest is checked as the list is received
+        read_status_ok =
+          is
+          && receive_rl_binary<Epid_sigrl_entry>(
+            is, filename + '.' + sigrl_binary_file_ext)
+          && read_rl_binary(
+            sig_rl, filename + '.' + sigrl_binary_file_ext, false);
+    } else if (!get_environment_variable("HBGS_SRL_SHARDS", "").empty()) {
+        read_status_ok = read_rl_shards(sig_rl, filename);
+    } else if (!get_environment_variable("HBGS_SRL_BINARY", "").empty()) {
+        read_status_ok = read_rl_binary(
+          sig_rl, filename + '.' + sigrl_binary_file_ext);
+    } else {
+        read_status_ok =
+          read_rl_text(sig_rl, filename + '.' + sigrl_file_ext);
     }
 
-    bool read_status_ok = sig_rl.read_rl(srl_is);
-    srl_is.close();
-
     if (!read_status_ok) {
         std::cerr << "Reading the sigRL data file failed\n";
         return false;
@@ -576,9 +581,17 @@ bool read_srl_data(
     return true;
 }
 
-bool check_a_j_and_b_j(
-  Epid_sig_rl const &srl, Revocation_signature &rsig, paramset_t *params)
+// The SRL's content digest is checked first, so a signature made against a
+// different list is turned away before any of the MPC work is done
+bool check_a_j_and_b_j(Sigrl_view srl, Rl_digest const &srl_digest,
+  Revocation_signature_view const &rsig, paramset_t *params)
 {
+    if (!check_srl_digest(rsig, srl_digest.data())) { return false; }
+    if (rsig.rev_check().n_a_j_ != srl.size()) {
+        std::cerr << "The signature has " << rsig.rev_check().n_a_j_
+                  << " A_j entries, the SRL has " << srl.size() << '\n';
+        return false;
+    }
     Lowmc_state_words64 test_value{};
     for (size_t e = 0; e < srl.size(); ++e) {
         lowmc64(test_value, srl[e].second(), rsig.rv(), params);
@@ -593,9 +606,222 @@ bool check_a_j_and_b_j(
     return true;
 }
 
+bool check_a_j_and_b_j(Sigrl_view srl, Rl_digest const &srl_digest,
+  Revocation_signature &rsig, paramset_t *params)
+{
+    return check_a_j_and_b_j(
+      srl, srl_digest, Revocation_signature_view(rsig), params);
+}
+
+// A signature to be checked by the verification pipeline, read from its file
+// as it would be by a verification service. The message digest is not part
+// of the signature, so it is given with it.
+struct Pipeline_job
+{
+    std::string base_dir_;
+    std::string sig_name_;
+    uint8_t const *msg_digest_;
+};
+
+struct Pipeline_raw
+{
+    std::vector<uint8_t> signature_;// The wire form, as read
+};
+
+struct Pipeline_loaded
+{
+    std::vector<uint8_t> signature_;
+    Revocation_signature_view rsig_;// Parsed in place from signature_
+};
+
+// Verify the batch signatures again through the read, deserialise, verify and
+// report pipeline, so that reading and parsing the next signatures overlaps
+// verification of the current one. Every signature is against srlist.
+bool pipeline_verify_test(std::vector<Pipeline_job> const &jobs,
+  Sigrl_view srlist, Rl_digest const &srl_digest, Mpc_timing_data &td)
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    Pipeline_stages<Pipeline_job, Pipeline_raw, Pipeline_loaded, int> stages;
+    stages.read_ = [](Pipeline_job const &job, Pipeline_raw &raw) {
+        return read_revocation_signature_buffer(
+          raw.signature_, job.base_dir_, job.sig_name_);
+    };
+    stages.deserialise_ = [](Pipeline_raw &raw, Pipeline_loaded &loaded) {
+        loaded.signature_ = std::move(raw.signature_);
+        return loaded.rsig_.parse(
+          loaded.signature_.data(), loaded.signature_.size());
+    };
+    // The verify stage runs on one thread, so it keeps one verifier context
+    // and its buffers are reused from one signature to the next. The proofs
+    // are read in place, the loaded signature is kept until verify returns.
+    Mpc_verifier_context verifier;
+    stages.verify_ = [&paramset, &verifier, srlist, &srl_digest](
+                       Pipeline_job const &job, Pipeline_loaded &loaded) {
+        Revocation_signature_view const &rsig = loaded.rsig_;
+        if (!check_a_j_and_b_j(srlist, srl_digest, rsig, &paramset)) {
+            return EXIT_FAILURE;
+        }
+        Hbgs_sigrl_list_test mpc_class(rsig.sid(), rsig.rv(), srlist);
+        return verify_mpc_signature(mpc_class, rsig.sig(), rsig.siglen(),
+          job.msg_digest_, rsig.str(), rsig.rev_check(), verifier, true);
+    };
+    size_t n_failed{ 0 };
+    stages.report_ = [&n_failed](size_t index, Pipeline_job const &,
+                       bool loaded_ok, int const &result) {
+        if (!loaded_ok) {
+            std::cerr << "Pipeline failed to load signature " << index << '\n';
+            ++n_failed;
+        } else if (result != EXIT_SUCCESS) {
+            std::cerr << "Pipeline verification failed for signature " << index
+                      << '\n';
+            ++n_failed;
+        }
+    };
+
+    td.timer_.reset();
+
+    run_verification_pipeline(jobs, stages);
+
+    td.times_.emplace_back(Mpc_time_point{ "verify_srl_pipeline",
+      static_cast<float>(td.timer_.get_duration() + 0.5F) });
+
+    return n_failed == 0;
+}
+
+// Sign batch_size new messages using the same r value and key as one batch,
+// so that the A_j list is only calculated once, then verify them as a batch.
+bool batch_sign_and_verify_test(Sigrl_view srlist, Rl_digest const &srl_digest,
+  std::string const &base_dir, std::string const &srl_filename,
+  Lowmc_state_words64_const_ptr users_sk,
+  Lowmc_state_words64_const_ptr r_value, Epid_a_rl const &aj_list,
+  size_t batch_size, Mpc_timing_data &td)
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    using Nonce = std::array<uint8_t, Mpc_parameters::nonce_size_bytes_>;
+    using Digest = std::array<uint8_t, Mpc_parameters::digest_size_bytes_>;
+    std::vector<Nonce> strs(batch_size);
+    std::vector<Digest> msg_digests(batch_size);
+    std::vector<std::unique_ptr<Revocation_signature>> rsigs(batch_size);
+    std::vector<Hbgs_sigrl_list_test> mpc_classes;
+    mpc_classes.reserve(batch_size);
+    std::vector<std::unique_ptr<Signature_data>> sig_data(batch_size);
+    for (size_t k = 0; k < batch_size; ++k) {
+        if (picnic_random_bytes(strs[k].data(), strs[k].size()) != 0
+            || picnic_random_bytes(msg_digests[k].data(), msg_digests[k].size())
+                 != 0) {
+            std::cerr << "Failed to generate the batch messages\n";
+            return false;
+        }
+        Lowmc_state_words64 sid{ 0 };
+        Lowmc_state_words64 sst{ 0 };
+        calculate_sid(sid, strs[k].data(), msg_digests[k].data(), &paramset);
+        lowmc64(sst, users_sk, sid, &paramset);
+        rsigs[k] = std::make_unique<Revocation_signature>(
+          srl_filename, srl_digest, strs[k].data(), sid, sst, r_value);
+        rsigs[k]->rev_check().a_j_ = aj_list;
+        mpc_classes.emplace_back(sid, r_value, srlist);
+        mpc_classes[k].set_sku(users_sk);
+        sig_data[k] =
+          std::make_unique<Signature_data>(Hbgs_sigrl_list_test::mpc_param_);
+        if (!sig_data[k]->is_initialised_) {
+            std::cerr << "Failed to initialise the signature data\n";
+            return false;
+        }
+    }
+
+    td.timer_.reset();
+
+    std::vector<Mpc_sign_item<Hbgs_sigrl_list_test>> sign_items(batch_size);
+    for (size_t k = 0; k < batch_size; ++k) {
+        sign_items[k] = { &mpc_classes[k], msg_digests[k].data(),
+            strs[k].data(), sig_data[k].get() };
+    }
+    std::vector<int> results = generate_mpc_signature_batch(sign_items);
+
+    size_t max_signature_size =
+      signature_size_estimate(Hbgs_sigrl_list_test::mpc_param_, paramset);
+    std::vector<size_t> signature_lens(batch_size, 0);
+    for (size_t k = 0; k < batch_size; ++k) {
+        if (results[k] != EXIT_SUCCESS) {
+            std::cerr << "Failed to create batch signature " << k << '\n';
+            return false;
+        }
+        rsigs[k]->sig_buf().resize(max_signature_size);
+        signature_lens[k] = sig_data[k]->serialise_signature(
+          rsigs[k]->sig_buf().data(), max_signature_size);
+        if (signature_lens[k] == 0) {
+            std::cerr << "Failed to serialize batch signature " << k << '\n';
+            return false;
+        }
+        rsigs[k]->sig_buf().resize(signature_lens[k]);
+        sig_data[k].reset();
+    }
+
+    td.times_.emplace_back(Mpc_time_point{ "generate_srl_batch",
+      static_cast<float>(td.timer_.get_duration() + 0.5F) });
+
+    for (auto &mc : mpc_classes) { mc.reset(); }
+
+    td.timer_.reset();
+
+    // The A_j list is shared, so only needs checking once
+    if (!check_a_j_and_b_j(srlist, srl_digest, *rsigs[0], &paramset)) {
+        return false;
+    }
+    for (size_t k = 1; k < batch_size; ++k) {
+        if (!check_srl_digest(
+              Revocation_signature_view(*rsigs[k]), srl_digest.data())) {
+            return false;
+        }
+    }
+
+    std::vector<
+      Mpc_verify_item<Hbgs_sigrl_list_test, Revocation_checking_data>>
+      verify_items(batch_size);
+    for (size_t k = 0; k < batch_size; ++k) {
+        verify_items[k] = { &mpc_classes[k], rsigs[k]->sig_buf().data(),
+            signature_lens[k], msg_digests[k].data(), strs[k].data(),
+            &rsigs[k]->rev_check() };
+    }
+    results = verify_mpc_signature_batch(verify_items);
+
+    td.times_.emplace_back(Mpc_time_point{ "verify_srl_batch",
+      static_cast<float>(td.timer_.get_duration() + 0.5F) });
+
+    for (size_t k = 0; k < batch_size; ++k) {
+        if (results[k] != EXIT_SUCCESS) {
+            std::cerr << "Batch verification failed for signature " << k
+                      << '\n';
+            return false;
+        }
+    }
+
+    // The signatures are saved, for the pipeline to read back one by one
+    std::vector<Pipeline_job> jobs(batch_size);
+    for (size_t k = 0; k < batch_size; ++k) {
+        jobs[k] = { base_dir, srl_filename + "_batch_" + std::to_string(k),
+            msg_digests[k].data() };
+        if (!print_revocation_signature(
+              *rsigs[k], base_dir, jobs[k].sig_name_)) {
+            return false;
+        }
+    }
+
+    bool verified_ok = pipeline_verify_test(jobs, srlist, srl_digest, td);
+    for (auto const &job : jobs) {
+        std::remove((make_filename(base_dir, job.sig_name_) + '.'
+                     + rsig_file_ext)
+                      .c_str());
+    }
+    return verified_ok;
+}
 
 int sigrl_list_test(std::string const &base_dir,
-  std::string const &srl_filename, bool make_it_fail)
+  std::string const &srl_filename, bool make_it_fail, size_t batch_size)
 {
     Lowmc_matrices::assign_lowmc_matrices();
     // Vaues for the signer
@@ -631,9 +857,41 @@ int sigrl_list_test(std::string const &base_dir,
         return EXIT_FAILURE;
     }
 
+    // If HBGS_SRL_MAPPED is set the binary list is mapped and signed and
+    // verified in place, without being read into memory. The failing test
+    // changes an entry, so it always reads its own copy.
     Epid_sig_rl srlist{};
+    Epid_sig_rl_mapped mapped_srlist;
+    Sigrl_view srl_view;
+    bool const use_mapped =
+      !get_environment_variable("HBGS_SRL_MAPPED", "").empty() && !make_it_fail;
+    if (use_mapped) {
+        if (!mapped_srlist.open(make_filename(base_dir, srl_filename) + '.'
+                                + sigrl_binary_file_ext)) {
+            return EXIT_FAILURE;
+        }
+        srl_view = mapped_srlist.view();
+    } else {
+        if (!read_srl_data(srlist, base_dir, srl_filename)) {
+            return EXIT_FAILURE;
+        }
+        srl_view = srlist;
+    }
 
-    if (!read_srl_data(srlist, base_dir, srl_filename)) { return EXIT_FAILURE; }
+    // If HBGS_SRL_REPORT is set the list is checked for entries with their
+    // padding set, which can't be used, and for repeated entries, which only
+    // make the proofs larger, and what was found is printed. The check reads
+    // the whole list, so it is not made otherwise: lists are checked when
+    // they are published (generate_epid_srl -v).
+    if (!get_environment_variable("HBGS_SRL_REPORT", "").empty()) {
+        Rl_check_report srl_report;
+        bool usable = check_rl(srl_view, srl_report);
+        print_rl_check_report(std::cout, srl_report);
+        if (!usable) {
+            std::cerr << "The sigRL can't be used\n";
+            return EXIT_FAILURE;
+        }
+    }
 
     size_t failing_entry = 3;
     if (make_it_fail) {// Fix an entry in the list using users_sk
@@ -644,7 +902,18 @@ int sigrl_list_test(std::string const &base_dir,
           << failing_entry << '\n';
     }
 
-    Revocation_signature rsig(srl_filename, str, users_sid, users_sst, r_value);
+    // The content digest of the list that is signed against, so taken after
+    // any change made for the failing test. A mapped list has it in its
+    // header.
+    Rl_digest srl_digest{};
+    if (use_mapped) {
+        std::memcpy(
+          srl_digest.data(), mapped_srlist.digest(), srl_digest.size());
+    } else {
+        srl_digest = rl_content_digest(srl_view);
+    }
+    Revocation_signature rsig(
+      srl_filename, srl_digest, str, users_sid, users_sst, r_value);
 
 #ifndef MINIMAL_PRINTING
     std::cout << green << "\n         users sk: ";
@@ -665,12 +934,7 @@ int sigrl_list_test(std::string const &base_dir,
 
     // Now do the actual test
     Epid_a_rl &aj_list = rsig.rev_check().a_j_;
-    aj_list.resize(srlist.size());
-
-    for (size_t e = 0; e < srlist.size(); ++e) {
-        aj_list[e] =
-          calculate_epid_arl_entry(rsig.rv(), users_sk, srlist[e], &paramset);
-    }
+    extend_epid_arl(aj_list, rsig.rv(), users_sk, srl_view, &paramset);
 
     uint8_t nonce[Mpc_parameters::nonce_size_bytes_];
     if (picnic_random_bytes(
@@ -680,22 +944,36 @@ int sigrl_list_test(std::string const &base_dir,
         return EXIT_FAILURE;
     }
 
-    Hbgs_sigrl_list_test hbgs_sigrl_list_test(users_sid, r_value, srlist);
+    // If HBGS_PACKED_SRL is set the MPC reads the SRL entries from a packed
+    // copy of the list
+    bool packed = !get_environment_variable("HBGS_PACKED_SRL", "").empty();
+    Epid_sig_rl_packed packed_srlist;
+    if (packed) {
+        packed_srlist.assign(srl_view);
+        std::cout << "# packed SRL: " << packed_srlist.size_bytes()
+                  << " bytes, unpacked "
+                  << srl_view.size() * sizeof(Epid_sigrl_entry) << " bytes\n";
+    }
+    Hbgs_sigrl_list_test hbgs_sigrl_list_test = packed
+      ? Hbgs_sigrl_list_test(users_sid, r_value, packed_srlist)
+      : Hbgs_sigrl_list_test(users_sid, r_value, srl_view);
 
     hbgs_sigrl_list_test.set_sku(users_sk);
 
-    Signature_data sig_data{ Hbgs_sigrl_list_test::mpc_param_ };
-    if (!sig_data.is_initialised_) {
-        std::cerr << "Failed to initialise the signature data\n";
-        return EXIT_FAILURE;
-    }
+    // If HBGS_STREAMING is set the signature is written straight into its
+    // buffer and verified in place, in constant working memory
+    bool streaming = !get_environment_variable("HBGS_STREAMING", "").empty();
 
-    ret =
-      generate_mpc_signature(hbgs_sigrl_list_test, msg_digest, str, sig_data);
-    if (ret != EXIT_SUCCESS) {
-        std::cerr << "Failed to create the signature\n ";
-        return EXIT_FAILURE;
-    }
+    // If HBGS_MEMORY_REPORT is set the memory used in each phase of signing
+    // and verifying is recorded and compared with the estimate
+    bool memory_report =
+      !get_environment_variable("HBGS_MEMORY_REPORT", "").empty();
+    Mpc_memory_probe probe;
+    if (memory_report) { probe.install(); }
+
+    // The same memory is used to sign and then to verify, except for the
+    // full (not streaming) signature which is made with a signer context
+    Mpc_session session;
 
     size_t max_signature_size =
       signature_size_estimate(Hbgs_sigrl_list_test::mpc_param_, paramset);
@@ -707,13 +985,34 @@ int sigrl_list_test(std::string const &base_dir,
 
     rsig.sig_buf().resize(max_signature_size);
 
-    size_t signature_len =
-      sig_data.serialise_signature(rsig.sig_buf().data(), max_signature_size);
-    if (signature_len == 0) {
-        std::cerr << "Failed to serialize signature\n" << std::flush;
-        return EXIT_FAILURE;
+    size_t signature_len = 0;
+    if (streaming) {
+        signature_len = generate_mpc_signature_streaming(hbgs_sigrl_list_test,
+          msg_digest, str, rsig.sig_buf().data(), max_signature_size,
+          &session);
+        if (signature_len == 0) {
+            std::cerr << "Failed to create the signature\n ";
+            return EXIT_FAILURE;
+        }
+    } else {
+        Mpc_signer_context signer;
+        ret = generate_mpc_signature(
+          hbgs_sigrl_list_test, msg_digest, str, signer);
+        if (ret != EXIT_SUCCESS) {
+            std::cerr << "Failed to create the signature\n ";
+            return EXIT_FAILURE;
+        }
+
+        signature_len = signer.signature_data().serialise_signature(
+          rsig.sig_buf().data(), max_signature_size);
+        if (signature_len == 0) {
+            std::cerr << "Failed to serialize signature\n" << std::flush;
+            return EXIT_FAILURE;
+        }
     }
 
+    rsig.sig_buf().resize(signature_len);
+    session.reset();
     rsig.sig_buf().shrink_to_fit();
 
     size_t total_signature_size =
@@ -734,17 +1033,39 @@ int sigrl_list_test(std::string const &base_dir,
     std::cout << "Verifying signature ... \n" << std::flush;
 #endif
 
+    // If HBGS_SIGNATURE_FILE is set the signature is saved in its wire form,
+    // read back with a single read and verified in place from that buffer
+    // (the proofs too)
+    Revocation_signature_view rsig_view(rsig);
+    std::vector<uint8_t> rsig_wire;
+    if (!get_environment_variable("HBGS_SIGNATURE_FILE", "").empty()) {
+        if (!print_revocation_signature(rsig, base_dir, srl_filename)
+            || !read_revocation_signature_buffer(
+              rsig_wire, base_dir, srl_filename)
+            || !rsig_view.parse(rsig_wire.data(), rsig_wire.size())) {
+            std::cerr << "Failed to save and read back the signature\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (memory_report) { probe.start_phase(); }
     td.timer_.reset();
 
-    bool verified_ok = check_a_j_and_b_j(srlist, rsig, &paramset);
+    bool verified_ok =
+      check_a_j_and_b_j(srl_view, srl_digest, rsig_view, &paramset);
 
     if (verified_ok) {
 #ifndef MINIMAL_PRINTING
         std::cout << green << "Comparison of A_j and B_j tested OK\n"
                   << normal << std::flush;
 #endif
-        ret = verify_mpc_signature(hbgs_sigrl_list_test, rsig.sig_buf().data(),
-          signature_len, msg_digest, str, rsig.rev_check());
+        ret = streaming ? verify_mpc_signature_streaming(hbgs_sigrl_list_test,
+                rsig_view.sig(), rsig_view.siglen(), msg_digest,
+                rsig_view.str(), rsig_view.rev_check(), &session)
+                        : verify_mpc_signature(hbgs_sigrl_list_test,
+                          rsig_view.sig(), rsig_view.siglen(), msg_digest,
+                          rsig_view.str(), rsig_view.rev_check(),
+                          !rsig_wire.empty(), &session);
 
         verified_ok = (ret == EXIT_SUCCESS);
     }
@@ -758,11 +1079,33 @@ int sigrl_list_test(std::string const &base_dir,
         return EXIT_FAILURE;
     }
 
-    std::cout << base_dir << '\t' << srl_filename << '\t' << srlist.size();
+    if (memory_report) {
+        probe.uninstall();
+        Mpc_memory_estimate me = mpc_memory_estimate(
+          Hbgs_sigrl_list_test::mpc_param_, paramset,
+          Mpc_thread_pool::instance().size(),
+          hbgs_sigrl_list_test.max_step_bits(),
+          hbgs_sigrl_list_test.tape_window_bits(), streaming);
+        print_memory_estimate(std::cout, me);
+        probe.print(std::cout, &me);
+    }
+
+    if (batch_size > 1) {
+        // Sign and verify a further batch_size messages as single batches
+        verified_ok = batch_sign_and_verify_test(srl_view, srl_digest, base_dir,
+          srl_filename, users_sk, r_value, aj_list, batch_size, td);
+        if (!verified_ok) {
+            std::cerr << "\nBatch signing and verification failed\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << base_dir << '\t' << srl_filename << '\t' << srl_view.size();
     for (auto const &tp : td.times_) { std::cout << '\t' << tp.time_; }
     std::cout << '\t'
-              << static_cast<double>(total_signature_size) / (1024 * 1024)
-              << std::endl;
+              << static_cast<double>(total_signature_size) / (1024 * 1024);
+    if (batch_size > 1) { std::cout << '\t' << batch_size; }
+    std::cout << std::endl;
 
 
 #ifndef MINIMAL_PRINTING
@@ -774,7 +1117,7 @@ int sigrl_list_test(std::string const &base_dir,
 
 int main(int argc, char **argv)
 {
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         usage(std::cerr, argv[0]);
         return EXIT_FAILURE;
     }
@@ -794,6 +1137,16 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    size_t batch_size{ 1 };
+    if (argc == 5) {
+        batch_size = std::strtoul(argv[4], nullptr, 10);
+        if (batch_size == 0) {
+            std::cerr << "batch size must be at least 1\n";
+            usage(std::cerr, argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
     if (!model_parameters_check_ok()) {
         std::cerr << "The picnic and HBGS parameters are inconsistent.\n";
         print_hbgs_parameters(std::cerr);
@@ -810,11 +1163,21 @@ int main(int argc, char **argv)
               << picnic_get_param_name(get_picnic_parameter_set_id()) << normal
               << "\n\n";
 #endif
-    return sigrl_list_test(base_dir, srl_name, make_it_fail);
+    // Record where the work ran when the placement has been changed, so that
+    // the timings can be compared
+    if (!mpc_cpu_list().empty() || mpc_huge_pages_enabled()) {
+        print_memory_placement(std::cout);
+    }
+    return sigrl_list_test(base_dir, srl_name, make_it_fail, batch_size);
 }
 
 void usage(std::ostream &os, std::string const &program)
 {
     os << green << "A test of a list of Sigrl_entries with different masks.\n\n"
-       << normal << program << " <base dir> <list name> <pass T/F>\n\n";
+       << normal << program
+       << " <base dir> <list name> <pass T/F> [<batch size>]\n\n"
+       << "If a batch size greater than one is given, that many new messages "
+          "are also\nsigned as a single batch and verified as a single batch, "
+          "and the signatures\nare verified again through the verification "
+          "pipeline.\n\n";
 }
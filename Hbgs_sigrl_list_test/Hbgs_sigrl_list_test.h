@@ -56,34 +56,44 @@ class Hbgs_sigrl_list_test
 {
   public:
     Hbgs_sigrl_list_test() = delete;
+    // The SRL is read in place, from a list or a mapped binary file
     Hbgs_sigrl_list_test(Lowmc_state_words64_const_ptr sid,
-      Lowmc_state_words64_const_ptr r_value, Epid_sig_rl const &srl) noexcept;
+      Lowmc_state_words64_const_ptr r_value, Sigrl_view srl) noexcept;
+    // The same, reading the SRL entries from a packed list
+    Hbgs_sigrl_list_test(Lowmc_state_words64_const_ptr sid,
+      Lowmc_state_words64_const_ptr r_value,
+      Epid_sig_rl_packed const &srl) noexcept;
     void set_sku(
       Lowmc_state_words64_const_ptr sk_u) noexcept;// Only used for signing
     Tape_offset set_offsets(Tape_offset const &of) noexcept;
     void compute_salt_and_root_seed(uint8_t *salt_and_root, size_t s_and_r_len,
       uint8_t const *nonce) noexcept;
-    void compute_aux_tape_sign(randomTape_t *tapes,
-      [[maybe_unused]] Mpc_working_data &mpc_wd, size_t t) noexcept;
-    void compute_aux_tape_verify(randomTape_t *tapes,
-      [[maybe_unused]] Signature_data const &sig_data, size_t t) noexcept;
-    void get_aux_bits(
-      uint8_t *aux_bits, randomTape_t *tapes, size_t t) noexcept;
-    void set_aux_bits(
-      randomTape_t *tapes, Signature_data const &sig_data, size_t t) noexcept;
-    int mpc_simulate_sign(randomTape_t *tapes, Mpc_working_data &mpc_wd,
-      shares_t *tmp_shares, size_t t) noexcept;
+    // The largest window of the tapes needed at any one time
+    Tape_offset tape_window_bits() const noexcept;
+    // The most aux bits (or messages) produced by one step, the sst LowMC or
+    // one SRL entry
+    size_t max_step_bits() const noexcept;
+    int sign_repetition(Mpc_streaming_tapes &tapes,
+      Mpc_repetition_stream &stream, shares_t *tmp_shares) noexcept;
+    void compute_aux_bits_verify(
+      Mpc_streaming_tapes &tapes, Mpc_repetition_stream &stream) noexcept;
     void commit_v_sign(
       Commitment_data2 &c2, Mpc_working_data const &wd, size_t t);
-    void commit_v_verify(Commitment_data2 &c2, Signature_data const &sig_data,
-      msgs_t const *msgs, size_t t);
     void calculate_hcp(uint8_t *challenge_hash, Signature_data const &sig_data,
       Commitment_data2 &cd2, uint8_t const *message_digest,
       uint8_t const *nonce) noexcept;
-    int mpc_simulate_and_verify(randomTape_t *tapes,
-      Signature_data const &sig_data, msgs_t *msgs,
-      Revocation_checking_data const &cd, shares_t *tmp_shares,
+    int simulate_and_verify_repetition(Mpc_streaming_tapes &tapes,
+      Mpc_proof_view const &proof, Mpc_repetition_stream &stream,
+      Revocation_checking_view const &cd, shares_t *tmp_shares,
       size_t t) noexcept;
+    int simulate_and_verify_repetition(Mpc_streaming_tapes &tapes,
+      Mpc_proof_view const &proof, Mpc_repetition_stream &stream,
+      Revocation_checking_data const &cd, shares_t *tmp_shares,
+      size_t t) noexcept
+    {
+        return simulate_and_verify_repetition(
+          tapes, proof, stream, cd.view(), tmp_shares, t);
+    }
     void save_proof_data(
       Proof2 *proof, Mpc_working_data const &mpc_wd, size_t t) const;
     void reset();
@@ -102,12 +112,31 @@ class Hbgs_sigrl_list_test
     Lowmc_state_words64 sk_u_{ 0 };
     Lowmc_state_words64 r_value_{ 0 };
 
-    Epid_sig_rl const &srl_;
+    // Unless packed_srl_ is set the entries are read from srl_
+    Sigrl_view srl_;
+    Epid_sig_rl_packed const *packed_srl_{ nullptr };
+    size_t n_entries_{ 0 };
+    // sid_j of entry e, a packed entry is unpacked into buffer
+    Lowmc_state_words64_const_ptr entry_sid(
+      size_t e, Lowmc_state_words64_ptr buffer) const noexcept
+    {
+        if (packed_srl_ == nullptr) { return srl_[e].first(); }
+        packed_srl_->unpack_state(e, 0, buffer);
+        return buffer;
+    }
 
     paramset_t paramset_;
     Tape_offset sku_mask_offset_{ null_offset };
 
-    std::vector<Tape_offset> sigrl_entry_offsets_{};
+    // The entries are laid out one after the other on the tapes, so the
+    // offsets for the whole list are fixed by the first offset and the delta
+    Tape_offset first_entry_offset_{ null_offset };
+    Tape_offset entry_offset_delta_{ 0 };
+    Tape_offset entry_offset(size_t e) const noexcept
+    {
+        return first_entry_offset_
+               + static_cast<Tape_offset>(e) * entry_offset_delta_;
+    }
 
     constexpr static Mpc_proof_indices pi_ =
       indices_from_mpc_param(sst_mpc_param_);
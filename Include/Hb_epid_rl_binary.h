@@ -0,0 +1,319 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_binary.h
+ * Description: A binary, memory mappable, file format for the revocation
+ *              lists
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef HB_EPID_RL_BINARY_H
+#define HB_EPID_RL_BINARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Hbgs_param.h"
+#include "Lowmc64.h"
+#include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_digest.h"
+
+// The binary form of a list. A 64 byte header is followed by one fixed size
+// record for each entry, each record holding the entry's states as they are
+// held in memory (padded to whole 64-bit words), so a mapped file can be
+// used as an array of entries without being parsed or copied. All of the
+// header values are little-endian:
+//
+//   0  magic "HBGS-RL\0"         24 records offset (u64)
+//   8  version (u16)             32 content digest of the records (32 bytes,
+//  10  list type (u8)               see Hb_epid_rl_digest.h)
+//  11  states per entry (u8)
+//  12  state size n, in bits (u16)
+//  14  record size, in bytes (u16)
+//  16  number of entries (u64)
+const std::string sigrl_binary_file_ext{ "srlbin" };
+const std::string arl_binary_file_ext{ "albin" };
+const std::string keyrl_binary_file_ext{ "krlbin" };
+
+constexpr size_t rl_binary_header_bytes = 64;
+// Version 2 has the tree hash content digest
+constexpr uint16_t rl_binary_version = 2;
+
+enum class Rl_binary_type : uint8_t { sigrl = 0, rl_a = 1, keyrl = 2 };
+
+struct Rl_binary_header
+{
+    uint16_t version_{ rl_binary_version };
+    Rl_binary_type type_{ Rl_binary_type::sigrl };
+    uint8_t n_states_{ 0 };
+    uint16_t state_bits_{ Mpc_parameters::lowmc_state_bits_ };
+    uint16_t record_bytes_{ 0 };
+    uint64_t n_entries_{ 0 };
+    uint64_t records_offset_{ rl_binary_header_bytes };
+    uint8_t digest_[rl_digest_bytes]{};
+};
+
+// The little-endian values in the headers
+inline void rl_put_le(uint8_t *out, uint64_t value, size_t n_bytes) noexcept
+{
+    for (size_t i = 0; i < n_bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+inline uint64_t rl_get_le(uint8_t const *in, size_t n_bytes) noexcept
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < n_bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+void encode_rl_binary_header(
+  uint8_t *out, Rl_binary_header const &header) noexcept;
+// Returns false if the buffer does not start with a header this code can
+// read
+bool decode_rl_binary_header(
+  Rl_binary_header &header, uint8_t const *in, size_t len) noexcept;
+
+// Check that a header describes records of the given shape, that the file
+// (of file_bytes bytes) holds them all and, if check_digest is set, that
+// the records match the digest. Reports any problem on std::cerr.
+bool check_rl_binary(Rl_binary_header const &header, Rl_binary_type type,
+  size_t n_states, size_t record_bytes, uint8_t const *file,
+  size_t file_bytes, bool check_digest) noexcept;
+
+// Write a header, with the digest, followed by the records (with
+// Rl_file_writer, so the file is replaced in one step)
+bool write_rl_binary(std::string const &filename, Rl_binary_type type,
+  size_t n_states, size_t record_bytes, uint8_t const *records,
+  size_t n_entries) noexcept;
+
+// A whole file mapped read-only
+class Rl_file_mapping
+{
+  public:
+    Rl_file_mapping() = default;
+    Rl_file_mapping(Rl_file_mapping const &) = delete;
+    Rl_file_mapping &operator=(Rl_file_mapping const &) = delete;
+    ~Rl_file_mapping() { unmap(); }
+
+    bool map(std::string const &filename) noexcept;
+    void unmap() noexcept;
+    // The file is mapped to be read once, in order. This is for a mapping
+    // that is read many times (a list used in place), the pages are kept.
+    void advise_reuse() const noexcept;
+    uint8_t const *data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+
+  private:
+    uint8_t const *data_{ nullptr };
+    size_t size_{ 0 };
+};
+
+// A file written in full and then put in place in one step. The data goes to
+// a temporary file in the same directory and commit() syncs it to disk and
+// renames it over the file, so a reader sees either the old file or the whole
+// of the new one. If commit() is not called the temporary file is removed.
+// The new file keeps the mode of the one it replaces, and otherwise has the
+// mode of any new file (0666 less the umask).
+class Rl_file_writer
+{
+  public:
+    Rl_file_writer() = default;
+    Rl_file_writer(Rl_file_writer const &) = delete;
+    Rl_file_writer &operator=(Rl_file_writer const &) = delete;
+    ~Rl_file_writer() { abort(); }
+
+    bool open(std::string const &filename) noexcept;
+    // Large writes go straight to the file, so callers buffer their output
+    bool write(void const *data, size_t len) noexcept;
+    bool commit() noexcept;
+    void abort() noexcept;
+
+  private:
+    std::string filename_;
+    std::string temp_filename_;
+    int fd_{ -1 };
+};
+
+template<typename T> constexpr Rl_binary_type rl_binary_type() noexcept;
+template<> constexpr Rl_binary_type rl_binary_type<Epid_sigrl_entry>() noexcept
+{
+    return Rl_binary_type::sigrl;
+}
+template<> constexpr Rl_binary_type rl_binary_type<Epid_arl_entry>() noexcept
+{
+    return Rl_binary_type::rl_a;
+}
+template<>
+constexpr Rl_binary_type rl_binary_type<Epid_keyRL_entry>() noexcept
+{
+    return Rl_binary_type::keyrl;
+}
+
+template<typename T> std::string rl_binary_file_ext();
+template<>
+inline std::string rl_binary_file_ext<Epid_sigrl_entry>()
+{
+    return sigrl_binary_file_ext;
+}
+template<>
+inline std::string rl_binary_file_ext<Epid_arl_entry>()
+{
+    return arl_binary_file_ext;
+}
+template<>
+inline std::string rl_binary_file_ext<Epid_keyRL_entry>()
+{
+    return keyrl_binary_file_ext;
+}
+
+// A list read straight from a mapped binary file, without copying. The
+// entries are only valid while this is open.
+template<typename T> class Hb_epid_rl_mapped
+{
+  public:
+    Hb_epid_rl_mapped() = default;
+    Hb_epid_rl_mapped(Hb_epid_rl_mapped const &) = delete;
+    Hb_epid_rl_mapped &operator=(Hb_epid_rl_mapped const &) = delete;
+
+    // Checking the digest reads the whole file
+    bool open(std::string const &filename, bool check_digest = true) noexcept;
+    void close() noexcept
+    {
+        mapping_.unmap();
+        entries_ = nullptr;
+        header_ = Rl_binary_header{};
+    }
+
+    T const &operator[](size_t index) const noexcept
+    {
+        return entries_[index];
+    }
+    T const *data() const noexcept { return entries_; }
+    // The entries, to be used in place
+    Hb_epid_rl_view<T> view() const noexcept
+    {
+        return Hb_epid_rl_view<T>(entries_, size());
+    }
+    bool empty() const noexcept { return size() == 0; }
+    size_t size() const noexcept
+    {
+        return static_cast<size_t>(header_.n_entries_);
+    }
+    Rl_binary_header const &header() const noexcept { return header_; }
+    // The content digest from the header, checked by open if asked
+    uint8_t const *digest() const noexcept { return header_.digest_; }
+    std::string const &list_name() const { return T::list_name; };
+
+  private:
+    Rl_file_mapping mapping_;
+    Rl_binary_header header_;
+    T const *entries_{ nullptr };
+};
+
+template<typename T>
+bool Hb_epid_rl_mapped<T>::open(
+  std::string const &filename, bool check_digest) noexcept
+{
+    close();
+    if (!mapping_.map(filename)) { return false; }
+    if (!decode_rl_binary_header(header_, mapping_.data(), mapping_.size())
+        || !check_rl_binary(header_, rl_binary_type<T>(), T::n_states_,
+          sizeof(T), mapping_.data(), mapping_.size(), check_digest)) {
+        std::cerr << "The file " << filename << " is not a valid "
+                  << T::list_name << " binary list\n";
+        close();
+        return false;
+    }
+    entries_ =
+      reinterpret_cast<T const *>(mapping_.data() + header_.records_offset_);
+    mapping_.advise_reuse();
+    return true;
+}
+
+using Epid_sig_rl_mapped = Hb_epid_rl_mapped<Epid_sigrl_entry>;
+
+// Save a list in the binary form
+template<typename T>
+bool save_rl_binary(
+  Hb_epid_rl<T> const &rl, std::string const &filename) noexcept
+{
+    static_assert(sizeof(T) == T::n_states_ * lowmc_state_words64_bytes,
+      "The entries must be held as whole states with no other data");
+    return write_rl_binary(filename, rl_binary_type<T>(), T::n_states_,
+      sizeof(T), reinterpret_cast<uint8_t const *>(rl.data()), rl.size());
+}
+
+// The content digest of a list held in memory, the same as the digest in the
+// binary form of the list
+template<typename T> Rl_digest rl_content_digest(Hb_epid_rl_view<T> rl)
+{
+    static_assert(sizeof(T) == T::n_states_ * lowmc_state_words64_bytes,
+      "The entries must be held as whole states with no other data");
+    Rl_digest digest{};
+    if (rl.empty() || rl.stride() == sizeof(T)) {
+        rl_content_digest(digest.data(),
+          reinterpret_cast<uint8_t const *>(rl.empty() ? nullptr : &rl[0]),
+          rl.size() * sizeof(T));
+        return digest;
+    }
+    // The entries are spread out, gather them first
+    std::vector<uint8_t> records(rl.size() * sizeof(T));
+    for (size_t e = 0; e < rl.size(); ++e) {
+        std::memcpy(records.data() + e * sizeof(T), &rl[e], sizeof(T));
+    }
+    rl_content_digest(digest.data(), records.data(), records.size());
+    return digest;
+}
+
+// Read a binary list into rl, copying the records in one go
+template<typename T>
+bool read_rl_binary(Hb_epid_rl<T> &rl, std::string const &filename,
+  bool check_digest = true) noexcept
+{
+    Hb_epid_rl_mapped<T> mapped;
+    if (!mapped.open(filename, check_digest)) { return false; }
+    rl.assign_from_buffer(
+      reinterpret_cast<uint8_t const *>(mapped.data()), mapped.size());
+    return true;
+}
+
+#endif
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_digest.h
+ * Description: The content digest of a revocation list, a tree hash over blocks
+ *              of its entries
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef HB_EPID_RL_DIGEST_H
+#define HB_EPID_RL_DIGEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <iostream>
+#include <vector>
+
+// The content digest identifies a list by its entries rather than by the name
+// of the file it came from, so it can key anything derived from a list and a
+// verifier can tell that a signature was made against a different list before
+// doing any of the MPC work.
+//
+// The records (the entries as they are held in memory) are split into blocks
+// of rl_digest_block_bytes. Each block is hashed, with its index, using
+// SHAKE256 and the blocks are hashed four at a time with the four-way Keccak.
+// The digest is then the SHAKE256 hash of the length of the records and the
+// block digests:
+//
+//   block_i = SHAKE256(0x00 || i (u64) || block i)
+//   digest  = SHAKE256(0x01 || length (u64) || block_0 || block_1 || ...)
+//
+// As lists only grow, the digests of the full blocks can be kept and when
+// entries are added only the last block and the new blocks are hashed
+// (Rl_digest_tree).
+constexpr size_t rl_digest_bytes = 32;
+constexpr size_t rl_digest_block_bytes = 64 * 1024;
+
+using Rl_digest = std::array<uint8_t, rl_digest_bytes>;
+
+class Mpc_thread_pool;
+
+// The digest as hex, for messages
+void print_rl_digest(std::ostream &os, uint8_t const *digest);
+
+class Rl_digest_tree
+{
+  public:
+    Rl_digest_tree() = default;
+
+    // Bring the digest up to date with the len bytes of records. The records
+    // must start with those given last time (the list has only grown). If a
+    // pool is given the new blocks are split between its workers, so this
+    // must not be called from work the pool is already running.
+    void update(uint8_t const *records, size_t len,
+      Mpc_thread_pool *pool = nullptr) noexcept;
+    // Add the next len bytes of records, for records that are not all held
+    // at once (for example a list written a shard at a time). The partly
+    // filled last block is kept. Use either this or update, not both.
+    void append(uint8_t const *records, size_t len) noexcept;
+    void clear() noexcept
+    {
+        blocks_.clear();
+        tail_.clear();
+        len_ = 0;
+    }
+    size_t size() const noexcept { return len_; }
+    void digest(uint8_t *digest) const noexcept;
+    Rl_digest digest() const noexcept
+    {
+        Rl_digest d;
+        digest(d.data());
+        return d;
+    }
+
+  private:
+    // One digest for each full block
+    std::vector<Rl_digest> blocks_;
+    // The digest of the partly filled last block, if there is one
+    Rl_digest last_{};
+    // The records of the last block, when they are given by append
+    std::vector<uint8_t> tail_;
+    size_t len_{ 0 };
+};
+
+// The digest of the len bytes of records, hashed in full
+void rl_content_digest(
+  uint8_t *digest, uint8_t const *records, size_t len) noexcept;
+
+#endif
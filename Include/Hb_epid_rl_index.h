@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_index.h
+ * Description: A hash index over the states of a list, used to check a list for
+ *              duplicate entries and padding as it is loaded
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef HB_EPID_RL_INDEX_H
+#define HB_EPID_RL_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Hbgs_param.h"
+#include "Lowmc64.h"
+#include "Hb_epid_revocation_lists.h"
+
+// A hash index over one state of each entry of a list (for an SRL, state 0 is
+// sid_j and state 1 is sst_j). It finds repeated entries in a single pass as a
+// list is loaded, and lets the issuer of a list find out whether a sid is
+// already on it without a search.
+//
+// The index is an open addressing table with linear probing, kept at most
+// half full. Each slot holds an entry number (plus one, so that zero is an
+// empty slot) and the bottom 32 bits of the hash of its state, so states are
+// only compared when their hashes match. The states are not copied, they are
+// read from the list, so the index must be extended whenever the list grows.
+// The hash is seeded at random for each index so that a list cannot be made
+// to collide.
+constexpr size_t rl_check_max_reported = 10;
+
+struct Rl_duplicate
+{
+    size_t entry_;// The entry whose state is already indexed
+    size_t first_;// The entry that it repeats (its first occurrence)
+};
+
+using Rl_duplicates = std::vector<Rl_duplicate>;
+
+struct Rl_index_stats
+{
+    size_t n_indexed_{ 0 };
+    size_t n_slots_{ 0 };
+    double load_{ 0 };
+    // The slots looked at to find an indexed state
+    double mean_probes_{ 0 };
+    size_t max_probes_{ 0 };
+};
+
+class Rl_state_index
+{
+  public:
+    static constexpr size_t npos = SIZE_MAX;
+
+    Rl_state_index() noexcept;
+    Rl_state_index(Rl_state_index const &) = delete;
+    Rl_state_index &operator=(Rl_state_index const &) = delete;
+
+    // Index the state state_offset bytes into each of the n_entries records,
+    // stride bytes apart. An entry whose state is already indexed is not
+    // added, it is given in duplicates (if given) instead. Returns false if
+    // the list is too large to index (2^32 - 1 entries or more).
+    bool build(uint8_t const *records, size_t stride, size_t state_offset,
+      size_t n_entries, Rl_duplicates *duplicates = nullptr) noexcept;
+    // Index the entries from size() on, once the list has grown (the
+    // records may have moved)
+    bool extend(uint8_t const *records, size_t n_entries,
+      Rl_duplicates *duplicates = nullptr) noexcept;
+    // The first entry with this state, or npos
+    size_t find(uint8_t const *state) const noexcept;
+    size_t find(Lowmc_state_words64_const_ptr state) const noexcept
+    {
+        return find(reinterpret_cast<uint8_t const *>(state));
+    }
+    bool contains(Lowmc_state_words64_const_ptr state) const noexcept
+    {
+        return find(state) != npos;
+    }
+    // The number of entries covered, including any duplicates
+    size_t size() const noexcept { return n_entries_; }
+    Rl_index_stats stats() const noexcept;
+    void clear() noexcept;
+
+  private:
+    uint64_t hash(uint8_t const *state) const noexcept;
+    uint8_t const *state(size_t entry) const noexcept
+    {
+        return records_ + entry * stride_ + state_offset_;
+    }
+    void reserve(size_t n_entries) noexcept;
+    // Index the entry, whose state has hash h. Returns the entry already
+    // indexed with the same state, or npos.
+    size_t insert(size_t entry, uint64_t h) noexcept;
+    // With linear probing and nothing removed, finding a state later looks
+    // at the same slots as placing it did
+    void count_probes(size_t probes) noexcept
+    {
+        total_probes_ += probes;
+        max_probes_ = std::max(max_probes_, probes);
+    }
+
+    std::vector<uint64_t> slots_;
+    unsigned shift_{ 64 };// The top bits of a hash give its home slot
+    uint8_t const *records_{ nullptr };
+    size_t stride_{ 0 };
+    size_t state_offset_{ 0 };
+    size_t n_entries_{ 0 };
+    size_t n_indexed_{ 0 };
+    size_t total_probes_{ 0 };
+    size_t max_probes_{ 0 };
+    uint64_t seed_{ 0 };
+};
+
+// What check_rl found in a list
+struct Rl_check_report
+{
+    size_t n_entries_{ 0 };
+    // Entries with bits set beyond the n bits of one of their states
+    size_t bad_padding_{ 0 };
+    // Entries that are the same as an earlier entry
+    size_t repeated_entries_{ 0 };
+    // Entries that differ from an earlier entry but have the same first (or
+    // second) state
+    size_t repeated_firsts_{ 0 };
+    size_t repeated_seconds_{ 0 };
+    Rl_index_stats index_;// The index of the first states
+    float time_ms_{ 0 };
+
+    size_t n_repeated() const noexcept
+    {
+        return repeated_entries_ + repeated_firsts_ + repeated_seconds_;
+    }
+    bool clean() const noexcept
+    {
+        return bad_padding_ == 0 && n_repeated() == 0;
+    }
+};
+
+// The report as lines starting with #, for the test programs
+void print_rl_check_report(std::ostream &os, Rl_check_report const &report);
+
+// Check the n_entries records of a list, each holding n_states states: that
+// nothing is set beyond the n bits of any state and that no entry repeats the
+// first or second state of an earlier one. The problems found are written to
+// std::cerr, up to rl_check_max_reported of them, and counted in report.
+// Repeated entries only make the proofs larger and slower, so they are
+// reported but the list can still be used; the function returns false if a
+// state has its padding set (or the index can't be built). If an index is
+// given it is left holding the index of the first states, for find.
+bool check_rl_records(uint8_t const *records, size_t n_states,
+  size_t record_bytes, size_t n_entries, Rl_check_report &report,
+  Rl_state_index *index = nullptr) noexcept;
+
+template<typename T>
+uint8_t const *rl_view_records(Hb_epid_rl_view<T> rl) noexcept
+{
+    static_assert(sizeof(T) == T::n_states_ * lowmc_state_words64_bytes,
+      "The entries must be held as whole states with no other data");
+    return rl.empty() ? nullptr : reinterpret_cast<uint8_t const *>(&rl[0]);
+}
+
+template<typename T>
+bool check_rl(Hb_epid_rl_view<T> rl, Rl_check_report &report,
+  Rl_state_index *index = nullptr) noexcept
+{
+    return check_rl_records(rl_view_records(rl), T::n_states_, rl.stride(),
+      rl.size(), report, index);
+}
+
+// Index state i of each entry of a list, for example the sids of an SRL
+template<typename T>
+bool index_rl(Rl_state_index &index, Hb_epid_rl_view<T> rl, size_t i = 0,
+  Rl_duplicates *duplicates = nullptr) noexcept
+{
+    return index.build(rl_view_records(rl), rl.stride(),
+      i * lowmc_state_words64_bytes, rl.size(), duplicates);
+}
+
+// Bring the index up to date once entries have been added to the list
+template<typename T>
+bool extend_rl_index(Rl_state_index &index, Hb_epid_rl_view<T> rl,
+  Rl_duplicates *duplicates = nullptr) noexcept
+{
+    return index.extend(rl_view_records(rl), rl.size(), duplicates);
+}
+
+#endif
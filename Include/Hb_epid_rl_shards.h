@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_shards.h
+ * Description: A revocation list split into shard files listed in a manifest
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef HB_EPID_RL_SHARDS_H
+#define HB_EPID_RL_SHARDS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Hbgs_param.h"
+#include "Lowmc64.h"
+#include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_binary.h"
+#include "Hb_epid_rl_digest.h"
+
+// A very large list can be split into shards, each a run of consecutive
+// entries saved in the binary form as <name>.<i>.srlbin, with a manifest
+// (<name>.srlman) that lists the shards in order. The entries of shard i
+// follow on from those of shard i - 1, so the list read back is the same
+// list, in the same order, as the one that was saved, which is the order the
+// proofs commit to. The shards are read in parallel straight into the list.
+// The manifest is a short text file:
+//
+//   HBGS-RLM 1
+//   list sigRL
+//   n 129
+//   entries <number of entries>
+//   digest <content digest of the whole list, in hex>
+//   shards <number of shards>
+//   <first entry> <number of entries> <shard file name>
+//   ...
+//
+// The shard file names are relative to the directory of the manifest. The
+// manifest is written after the shards, so a reader never sees a manifest
+// for shards that are not there.
+const std::string sigrl_manifest_file_ext{ "srlman" };
+const std::string arl_manifest_file_ext{ "alman" };
+const std::string keyrl_manifest_file_ext{ "krlman" };
+
+constexpr uint16_t rl_manifest_version = 1;
+
+struct Rl_shard_info
+{
+    uint64_t first_entry_{ 0 };
+    uint64_t n_entries_{ 0 };
+    std::string filename_;
+};
+
+struct Rl_manifest
+{
+    std::string list_name_;
+    uint16_t state_bits_{ Mpc_parameters::lowmc_state_bits_ };
+    uint64_t n_entries_{ 0 };
+    Rl_digest digest_{};
+    std::vector<Rl_shard_info> shards_;
+};
+
+bool write_rl_manifest(
+  std::string const &filename, Rl_manifest const &manifest) noexcept;
+// Read a manifest and check that its shards cover the list, in order
+bool read_rl_manifest(
+  Rl_manifest &manifest, std::string const &filename) noexcept;
+
+// Writes a list a shard at a time, so the whole list need never be held in
+// memory. commit() writes the manifest once all of the shards are saved.
+class Rl_shard_writer
+{
+  public:
+    Rl_shard_writer() = default;
+    Rl_shard_writer(Rl_shard_writer const &) = delete;
+    Rl_shard_writer &operator=(Rl_shard_writer const &) = delete;
+
+    // The shards are saved as <filename>.<i>.<shard_ext> and the manifest
+    // as <filename>.<manifest_ext>
+    void open(std::string const &filename, std::string const &list_name,
+      Rl_binary_type type, size_t n_states, size_t record_bytes,
+      std::string const &shard_ext, std::string const &manifest_ext) noexcept;
+    // Save the next n_entries entries as a shard
+    bool add_shard(uint8_t const *records, size_t n_entries) noexcept;
+    bool commit() noexcept;
+
+  private:
+    std::string filename_;
+    std::string shard_ext_;
+    std::string manifest_ext_;
+    Rl_binary_type type_{ Rl_binary_type::sigrl };
+    size_t n_states_{ 0 };
+    size_t record_bytes_{ 0 };
+    Rl_manifest manifest_;
+    Rl_digest_tree digest_tree_;
+};
+
+// Read the shards of a manifest, one shard for each worker at a time. The
+// shards are all mapped and their headers checked against the manifest
+// first, then records_for is called for the records, which must have room
+// for all of the entries. So the list is only sized once the manifest's
+// count is known to be held in the shard files. If check_digest is set the
+// whole list is checked against the manifest's digest.
+bool read_rl_shards(Rl_manifest const &manifest,
+  std::string const &manifest_filename, Rl_binary_type type, size_t n_states,
+  size_t record_bytes, std::function<uint8_t *()> const &records_for,
+  bool check_digest) noexcept;
+
+template<typename T> std::string rl_manifest_file_ext();
+template<> inline std::string rl_manifest_file_ext<Epid_sigrl_entry>()
+{
+    return sigrl_manifest_file_ext;
+}
+template<> inline std::string rl_manifest_file_ext<Epid_arl_entry>()
+{
+    return arl_manifest_file_ext;
+}
+template<> inline std::string rl_manifest_file_ext<Epid_keyRL_entry>()
+{
+    return keyrl_manifest_file_ext;
+}
+
+// Save rl as n_shards shards of (nearly) equal size and a manifest, as
+// <filename>.<i>.<binary ext> and <filename>.<manifest ext>
+template<typename T>
+bool save_rl_shards(Hb_epid_rl<T> const &rl, std::string const &filename,
+  size_t n_shards) noexcept
+{
+    n_shards = std::max<size_t>(1, std::min(n_shards, rl.size()));
+    Rl_shard_writer writer;
+    writer.open(filename, T::list_name, rl_binary_type<T>(), T::n_states_,
+      sizeof(T), rl_binary_file_ext<T>(), rl_manifest_file_ext<T>());
+    size_t first = 0;
+    for (size_t s = 0; s < n_shards; ++s) {
+        size_t end = rl.size() * (s + 1) / n_shards;
+        if (!writer.add_shard(
+              reinterpret_cast<uint8_t const *>(rl.data() + first),
+              end - first)) {
+            return false;
+        }
+        first = end;
+    }
+    return writer.commit();
+}
+
+// Read the list described by the manifest <filename>.<manifest ext> into rl.
+// The list's content digest is returned in digest, if it is given.
+template<typename T>
+bool read_rl_shards(Hb_epid_rl<T> &rl, std::string const &filename,
+  bool check_digest = true, Rl_digest *digest = nullptr) noexcept
+{
+    std::string manifest_filename = filename + '.' + rl_manifest_file_ext<T>();
+    Rl_manifest manifest;
+    if (!read_rl_manifest(manifest, manifest_filename)) { return false; }
+    if (manifest.list_name_ != T::list_name) {
+        std::cerr << "The manifest " << manifest_filename << " is for a "
+                  << manifest.list_name_ << ", not a " << T::list_name << '\n';
+        return false;
+    }
+    rl.clear();
+    auto records_for = [&rl, &manifest]() {
+        rl.resize(static_cast<size_t>(manifest.n_entries_));
+        return reinterpret_cast<uint8_t *>(rl.data());
+    };
+    if (!read_rl_shards(manifest, manifest_filename, rl_binary_type<T>(),
+          T::n_states_, sizeof(T), records_for, check_digest)) {
+        rl.clear();
+        return false;
+    }
+    if (digest != nullptr) { *digest = manifest.digest_; }
+    return true;
+}
+
+#endif
@@ -0,0 +1,356 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_store.h
+ * Description: A versioned store for a revocation list, a snapshot and an
+ *              append-only log of the deltas made to it since
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef HB_EPID_RL_STORE_H
+#define HB_EPID_RL_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Hbgs_param.h"
+#include "Lowmc64.h"
+#include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_binary.h"
+
+// A list kept as a snapshot (the binary form, <name>.srlbin) and an
+// append-only log of the deltas made to it since (<name>.srllog). The lists
+// only grow, so a delta is just the entries added. The log starts with a
+// header that names the snapshot it follows on from and then holds one
+// segment for each delta, a segment header followed by the new records. All
+// of the values are little-endian:
+//
+//   log header                         segment header
+//    0  magic "HBGS-RLL"                0  magic "HBGS-RLD"
+//    8  version (u16)                   8  list version after the delta (u64)
+//   10  list type (u8)                 16  index of the first new entry (u64)
+//   11  states per entry (u8)          24  number of new entries (u64)
+//   12  state size n, in bits (u16)    32  content digest of the records
+//   14  record size, in bytes (u16)        (32 bytes)
+//   16  snapshot version (u64)
+//   24  snapshot entries (u64)
+//   32  snapshot content digest (32 bytes)
+//
+// Each segment takes the version on by one. A reader remembers how far
+// through the log it has got and only reads the segments added after that,
+// so applying a delta costs the size of the delta, not of the list. A
+// segment that is not yet complete, or does not match its digest, ends the
+// log for now. Only one process should append to a log at a time.
+const std::string sigrl_log_file_ext{ "srllog" };
+const std::string arl_log_file_ext{ "allog" };
+const std::string keyrl_log_file_ext{ "krllog" };
+
+constexpr size_t rl_log_header_bytes = 64;
+constexpr size_t rl_segment_header_bytes = 64;
+// Version 2 has the tree hash content digests
+constexpr uint16_t rl_log_version = 2;
+
+template<typename T> std::string rl_log_file_ext();
+template<> inline std::string rl_log_file_ext<Epid_sigrl_entry>()
+{
+    return sigrl_log_file_ext;
+}
+template<> inline std::string rl_log_file_ext<Epid_arl_entry>()
+{
+    return arl_log_file_ext;
+}
+template<> inline std::string rl_log_file_ext<Epid_keyRL_entry>()
+{
+    return keyrl_log_file_ext;
+}
+
+struct Rl_log_header
+{
+    Rl_binary_type type_{ Rl_binary_type::sigrl };
+    uint8_t n_states_{ 0 };
+    uint16_t state_bits_{ Mpc_parameters::lowmc_state_bits_ };
+    uint16_t record_bytes_{ 0 };
+    uint64_t base_version_{ 0 };
+    uint64_t base_entries_{ 0 };
+    uint8_t base_digest_[rl_digest_bytes]{};
+
+    bool operator==(Rl_log_header const &other) const noexcept;
+    bool operator!=(Rl_log_header const &other) const noexcept
+    {
+        return !(*this == other);
+    }
+};
+
+struct Rl_segment_header
+{
+    uint64_t version_{ 0 };
+    uint64_t first_entry_{ 0 };
+    uint64_t n_entries_{ 0 };
+    uint8_t digest_[rl_digest_bytes]{};
+};
+
+// Start a new (empty) log, replacing any old one in one step
+bool write_rl_log(
+  std::string const &filename, Rl_log_header const &header) noexcept;
+
+// Append a segment holding n_entries records to a log, checking that the
+// log holds the given kind of records. The version it gives the list is
+// returned in version.
+bool append_rl_log(std::string const &filename, Rl_binary_type type,
+  size_t n_states, size_t record_bytes, uint8_t const *records,
+  size_t n_entries, uint64_t &version) noexcept;
+
+// What Rl_log_reader::read_segment found at an offset
+enum class Rl_segment_read {
+    ok,// A complete segment, whose digest checks
+    end,// The end of the log
+    // The last segment is incomplete: an append that is still being written
+    // or did not finish
+    torn,
+    // A segment that can't be read with more of the log after it
+    damaged
+};
+
+// Reads the segments of a log, in order, from a given offset
+class Rl_log_reader
+{
+  public:
+    Rl_log_reader() = default;
+    Rl_log_reader(Rl_log_reader const &) = delete;
+    Rl_log_reader &operator=(Rl_log_reader const &) = delete;
+    ~Rl_log_reader() { close(); }
+
+    // Open a log and read its header
+    bool open(std::string const &filename) noexcept;
+    void close() noexcept;
+    Rl_log_header const &header() const noexcept { return header_; }
+    // The offset of the first segment
+    static constexpr uint64_t first_segment_ = rl_log_header_bytes;
+    // Read the segment at offset into segment and records, checking its
+    // digest, and move offset on to the next segment if it is complete. The
+    // log is taken to end where it did when it was opened, and a segment is
+    // only read if the records its header gives fit before that end.
+    Rl_segment_read read_segment(uint64_t &offset, Rl_segment_header &segment,
+      std::vector<uint8_t> &records) const noexcept;
+    // Read just the header of the segment at offset and move offset past
+    // its records, without reading them or checking its digest
+    Rl_segment_read skip_segment(
+      uint64_t &offset, Rl_segment_header &segment) const noexcept;
+
+  private:
+    // Read and check the header of the segment at offset, records_len is
+    // set to the length of its records once they are known to fit
+    Rl_segment_read read_segment_header(uint64_t offset,
+      Rl_segment_header &segment, size_t &records_len) const noexcept;
+
+    std::string filename_;
+    Rl_log_header header_;
+    int fd_{ -1 };
+    uint64_t size_{ 0 };// The length of the log when it was opened
+};
+
+// Save rl, at its current version, as the snapshot of a store and start an
+// empty log. This is also how a store whose log has grown large is
+// compacted. The snapshot is replaced first and then the log, a reader that
+// opens the store between the two sees that the log does not follow on from
+// the snapshot and reads it again (see rl_store_read_attempts).
+template<typename T>
+bool save_rl_snapshot(
+  Hb_epid_rl<T> const &rl, std::string const &filename) noexcept
+{
+    if (!rl.save_rl(filename + '.' + rl_binary_file_ext<T>(),
+          Rl_file_format::binary)) {
+        return false;
+    }
+    Rl_log_header header;
+    header.type_ = rl_binary_type<T>();
+    header.n_states_ = static_cast<uint8_t>(T::n_states_);
+    header.record_bytes_ = static_cast<uint16_t>(sizeof(T));
+    header.base_version_ = rl.version();
+    header.base_entries_ = rl.size();
+    rl_content_digest(header.base_digest_,
+      reinterpret_cast<uint8_t const *>(rl.data()), rl.size() * sizeof(T));
+    return write_rl_log(filename + '.' + rl_log_file_ext<T>(), header);
+}
+
+// Append n new entries to the store's log as one delta, the new version of
+// the list is returned in version
+template<typename T>
+bool append_rl_delta(std::string const &filename, T const *entries, size_t n,
+  uint64_t &version) noexcept
+{
+    return append_rl_log(filename + '.' + rl_log_file_ext<T>(),
+      rl_binary_type<T>(), T::n_states_, sizeof(T),
+      reinterpret_cast<uint8_t const *>(entries), n, version);
+}
+
+// A list read from a store and kept up to date with it. The entries of the
+// list don't move when it is updated, other than when the vector holding
+// them grows, so data derived from the entries need only be extended for
+// the new ones (see update()).
+// How many times a store is read before giving up, when it is compacted
+// each time between its log and its snapshot being opened
+constexpr size_t rl_store_read_attempts = 4;
+
+template<typename T> class Hb_epid_rl_store
+{
+  public:
+    Hb_epid_rl_store() = default;
+    Hb_epid_rl_store(Hb_epid_rl_store const &) = delete;
+    Hb_epid_rl_store &operator=(Hb_epid_rl_store const &) = delete;
+
+    // Read the snapshot and apply all of the deltas in the log
+    bool open(std::string const &filename) noexcept;
+    // Apply the deltas added to the log since it was last read. The entries
+    // from first_new on are new. If the store has a new snapshot the list is
+    // read again in full and first_new is 0.
+    bool update(size_t &first_new) noexcept;
+
+    Hb_epid_rl<T> const &list() const noexcept { return rl_; }
+    uint64_t version() const noexcept { return rl_.version(); }
+    // The content digest of the list as it is now. Only the blocks changed
+    // by a delta are hashed again.
+    Rl_digest digest() const noexcept { return digest_tree_.digest(); }
+
+  private:
+    enum class Rl_snapshot_read { ok, changed, failed };
+    // Read the snapshot that a log with this header follows on from. If the
+    // snapshot found is not that one the store was compacted after the log
+    // was opened, and is read again.
+    Rl_snapshot_read read_snapshot(Rl_log_header const &header) noexcept;
+    // Apply the deltas in log from log_offset_ on
+    bool apply_log(Rl_log_reader const &log) noexcept;
+
+    std::string filename_;
+    Hb_epid_rl<T> rl_;
+    Rl_digest_tree digest_tree_;
+    Rl_log_header header_;
+    uint64_t log_offset_{ Rl_log_reader::first_segment_ };
+    bool loaded_{ false };// The snapshot for header_ has been read
+};
+
+template<typename T>
+bool Hb_epid_rl_store<T>::open(std::string const &filename) noexcept
+{
+    filename_ = filename;
+    loaded_ = false;
+    size_t first_new = 0;
+    return update(first_new);
+}
+
+template<typename T>
+bool Hb_epid_rl_store<T>::update(size_t &first_new) noexcept
+{
+    first_new = rl_.size();
+    for (size_t attempt = 0; attempt < rl_store_read_attempts; ++attempt) {
+        Rl_log_reader log;
+        if (!log.open(filename_ + '.' + rl_log_file_ext<T>())) {
+            return false;
+        }
+        if (!loaded_ || log.header() != header_) {// A new snapshot
+            first_new = 0;
+            switch (read_snapshot(log.header())) {
+            case Rl_snapshot_read::ok:
+                break;
+            case Rl_snapshot_read::changed:
+                continue;
+            default:
+                return false;
+            }
+        }
+        return apply_log(log);
+    }
+    std::cerr << "The log " << filename_ << '.' << rl_log_file_ext<T>()
+              << " does not follow on from the snapshot\n";
+    return false;
+}
+
+template<typename T>
+typename Hb_epid_rl_store<T>::Rl_snapshot_read
+  Hb_epid_rl_store<T>::read_snapshot(Rl_log_header const &header) noexcept
+{
+    loaded_ = false;
+    rl_.clear();
+    rl_.set_version(0);
+    digest_tree_.clear();
+
+    Hb_epid_rl_mapped<T> snapshot;
+    if (!snapshot.open(filename_ + '.' + rl_binary_file_ext<T>())) {
+        return Rl_snapshot_read::failed;
+    }
+    if (header.type_ != rl_binary_type<T>()
+        || header.base_entries_ != snapshot.size()
+        || std::memcmp(header.base_digest_, snapshot.header().digest_,
+             rl_digest_bytes)
+             != 0) {
+        return Rl_snapshot_read::changed;
+    }
+    // Room for the deltas to come, so that applying one does not copy the
+    // whole list
+    rl_.reserve(snapshot.size() + snapshot.size() / 4 + 64);
+    rl_.assign_from_buffer(
+      reinterpret_cast<uint8_t const *>(snapshot.data()), snapshot.size());
+    rl_.set_version(header.base_version_);
+    header_ = header;
+    log_offset_ = Rl_log_reader::first_segment_;
+    loaded_ = true;
+    return Rl_snapshot_read::ok;
+}
+
+template<typename T>
+bool Hb_epid_rl_store<T>::apply_log(Rl_log_reader const &log) noexcept
+{
+    Rl_segment_header segment;
+    std::vector<uint8_t> records;
+    Rl_segment_read read;
+    while ((read = log.read_segment(log_offset_, segment, records))
+           == Rl_segment_read::ok) {
+        if (!rl_.apply_delta(segment.version_,
+              static_cast<size_t>(segment.first_entry_),
+              reinterpret_cast<T const *>(records.data()),
+              static_cast<size_t>(segment.n_entries_))) {
+            return false;
+        }
+    }
+    // A torn last segment is still being written, it is read next time
+    if (read == Rl_segment_read::damaged) { return false; }
+    digest_tree_.update(
+      reinterpret_cast<uint8_t const *>(rl_.data()), rl_.size() * sizeof(T));
+    return true;
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_text.h
+ * Description: Fast reading and writing of the text form of the revocation
+ *              lists
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef HB_EPID_RL_TEXT_H
+#define HB_EPID_RL_TEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Hbgs_param.h"
+#include "Lowmc64.h"
+#include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_binary.h"
+
+// The text form of a list (as written by print_rl) read without going
+// through iostreams. The file is mapped and the start of each entry line is
+// found, then the lines are split between the worker threads, which decode
+// the hex with decode_hex. Each malformed line is reported on std::cerr as
+// <file>:<line>:<column>: <problem>, up to rl_text_max_reported of them.
+constexpr size_t rl_text_max_reported = 10;
+
+class Rl_text_file
+{
+  public:
+    Rl_text_file() = default;
+    Rl_text_file(Rl_text_file const &) = delete;
+    Rl_text_file &operator=(Rl_text_file const &) = delete;
+
+    // Map the file, check its header line and find the entry lines
+    bool open(std::string const &filename, std::string const &list_name,
+      size_t n_states) noexcept;
+    size_t n_entries() const noexcept { return lines_.size(); }
+    // Decode the entries into records of record_bytes bytes, each holding
+    // the states of an entry as whole words, one after the other
+    bool decode(uint8_t *records, size_t record_bytes) noexcept;
+
+  private:
+    struct Error
+    {
+        size_t offset_;// Where in the file
+        char const *what_;
+    };
+
+    void report(Error const &error) const noexcept;
+    bool parse_line(uint8_t *record, size_t offset, Error &error) const noexcept;
+
+    Rl_file_mapping mapping_;
+    std::string filename_;
+    size_t n_states_{ 0 };
+    std::vector<size_t> lines_;// The offset of each entry line
+};
+
+// Write n_entries records of record_bytes bytes, each holding n_states
+// states as whole words, in the text form (the same as print_rl). The lines
+// are built in a large buffer with encode_hex and written with
+// Rl_file_writer, so the file is replaced in one step.
+bool write_rl_text(std::string const &filename, std::string const &list_name,
+  size_t n_states, size_t record_bytes, uint8_t const *records,
+  size_t n_entries) noexcept;
+
+// Read the text form of a list into rl. Returns false, with the problems
+// reported, if the file can't be read or any of its lines are malformed.
+template<typename T>
+bool read_rl_text(Hb_epid_rl<T> &rl, std::string const &filename) noexcept
+{
+    static_assert(sizeof(T) == T::n_states_ * lowmc_state_words64_bytes,
+      "The entries must be held as whole states with no other data");
+    Rl_text_file file;
+    if (!file.open(filename, T::list_name, T::n_states_)) { return false; }
+    rl.resize(file.n_entries());
+    if (!file.decode(reinterpret_cast<uint8_t *>(rl.data()), sizeof(T))) {
+        rl.clear();
+        return false;
+    }
+    return true;
+}
+
+#endif
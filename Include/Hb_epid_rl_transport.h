@@ -0,0 +1,250 @@
+/*******************************************************************************
+ * File:        Hb_epid_rl_transport.h
+ * Description: A compact transport encoding for revocation lists and their deltas,
+ *              with a streaming decoder
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef HB_EPID_RL_TRANSPORT_H
+#define HB_EPID_RL_TRANSPORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Hbgs_param.h"
+#include "Lowmc64.h"
+#include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_binary.h"
+#include "Hb_epid_rl_digest.h"
+
+// The form a list, or a delta to one, is sent in. The entries are random so
+// there is nothing for a general purpose compressor to find, the text form
+// is large only because of the hex and the binary form because of the
+// padding. Here each entry is bit packed: the whole bytes of each of its
+// states, then the bits left over in the last byte of each state packed
+// together (most significant first). For n = 129 an entry takes 33 bytes,
+// against 48 in the binary form and 70 in the text form. An 80 byte header,
+// with little-endian values, comes first:
+//
+//   0  magic "HBGS-RLT"               24  list version (u64)
+//   8  version (u16)                  32  index of the first entry (u64)
+//  10  list type (u8)                 40  number of entries (u64)
+//  11  states per entry (u8)          48  content digest of the entries, as
+//  12  state size n, in bits (u16)        held in memory (32 bytes)
+//  14  packed entry size, bytes (u16)
+//  16  kind (u8), 0 a list, 1 a delta
+//
+// A delta holds the entries from the first entry on and takes the list to
+// the given version. The decoder (Rl_transport_decoder) takes the stream a
+// piece at a time, as it arrives, and passes the entries on a batch at a
+// time already in the in memory form, so a list can be written straight to
+// its binary form (receive_rl_transport) or a delta added to a list in
+// place (apply_rl_transport_delta).
+const std::string sigrl_transport_file_ext{ "srlt" };
+
+constexpr size_t rl_transport_header_bytes = 80;
+constexpr uint16_t rl_transport_version = 1;
+
+enum class Rl_transport_kind : uint8_t { list = 0, delta = 1 };
+
+// The bits of a state beyond its whole bytes
+constexpr size_t rl_state_whole_bytes = Mpc_parameters::lowmc_state_bits_ / 8;
+constexpr size_t rl_state_extra_bits = Mpc_parameters::lowmc_state_bits_ % 8;
+
+constexpr size_t rl_transport_entry_bytes(size_t n_states) noexcept
+{
+    return n_states * rl_state_whole_bytes
+           + (n_states * rl_state_extra_bits + 7) / 8;
+}
+
+struct Rl_transport_header
+{
+    Rl_transport_kind kind_{ Rl_transport_kind::list };
+    Rl_binary_type type_{ Rl_binary_type::sigrl };
+    uint8_t n_states_{ 0 };
+    uint16_t state_bits_{ Mpc_parameters::lowmc_state_bits_ };
+    uint16_t entry_bytes_{ 0 };
+    uint64_t list_version_{ 0 };
+    uint64_t first_entry_{ 0 };
+    uint64_t n_entries_{ 0 };
+    Rl_digest digest_{};
+};
+
+void encode_rl_transport_header(
+  uint8_t *out, Rl_transport_header const &header) noexcept;
+bool decode_rl_transport_header(
+  Rl_transport_header &header, uint8_t const *in) noexcept;
+
+// Pack n_entries records (the in memory form) into out, and back. Packing
+// stops at an entry with any bits set beyond the n bits of its states (they
+// would be lost), the number of entries packed is returned.
+size_t pack_rl_transport_entries(uint8_t *out, uint8_t const *records,
+  size_t n_states, size_t record_bytes, size_t n_entries) noexcept;
+void unpack_rl_transport_entries(uint8_t *records, uint8_t const *in,
+  size_t n_states, size_t record_bytes, size_t n_entries) noexcept;
+
+// Send n_entries records, with the header filled in from them
+bool write_rl_transport(std::ostream &os, Rl_transport_kind kind,
+  Rl_binary_type type, size_t n_states, size_t record_bytes,
+  uint64_t list_version, uint64_t first_entry, uint8_t const *records,
+  size_t n_entries) noexcept;
+
+// What the decoder does with what it decodes. header_ is called once the
+// header has arrived and records_ with each batch of entries, either can
+// stop the decoding by returning false.
+struct Rl_transport_sink
+{
+    std::function<bool(Rl_transport_header const &header)> header_;
+    std::function<bool(uint8_t const *records, size_t n_entries)> records_;
+};
+
+class Rl_transport_decoder
+{
+  public:
+    // The entries that are decoded at a time
+    static constexpr size_t batch_entries_ = 4096;
+
+    Rl_transport_decoder(Rl_binary_type type, size_t n_states,
+      size_t record_bytes, Rl_transport_sink sink) noexcept;
+    Rl_transport_decoder(Rl_transport_decoder const &) = delete;
+    Rl_transport_decoder &operator=(Rl_transport_decoder const &) = delete;
+
+    // Decode the next len bytes of the stream
+    bool feed(uint8_t const *data, size_t len) noexcept;
+    // Check that all of the entries have arrived and match the digest
+    bool finish() noexcept;
+    Rl_transport_header const &header() const noexcept { return header_; }
+
+  private:
+    bool decode_entries(uint8_t const *in, size_t n_entries) noexcept;
+
+    Rl_binary_type type_;
+    size_t n_states_;
+    size_t record_bytes_;
+    size_t entry_bytes_;
+    Rl_transport_sink sink_;
+    Rl_transport_header header_;
+    bool have_header_{ false };
+    bool failed_{ false };
+    uint64_t n_decoded_{ 0 };
+    // A header or entry split between two pieces of the stream
+    std::vector<uint8_t> pending_;
+    std::vector<uint8_t> records_;
+    Rl_digest_tree digest_tree_;
+};
+
+// Decode a list from is, in pieces of read_bytes, straight into the binary
+// form (written with Rl_file_writer, so only put in place once the whole
+// list has arrived and matches its digest)
+bool receive_rl_transport(std::istream &is, std::string const &filename,
+  Rl_binary_type type, size_t n_states, size_t record_bytes,
+  size_t read_bytes = 64 * 1024) noexcept;
+
+// Feed everything from is to a decoder
+bool decode_rl_transport_stream(std::istream &is,
+  Rl_transport_decoder &decoder, size_t read_bytes = 64 * 1024) noexcept;
+
+template<typename T>
+bool send_rl(std::ostream &os, Hb_epid_rl<T> const &rl) noexcept
+{
+    return write_rl_transport(os, Rl_transport_kind::list, rl_binary_type<T>(),
+      T::n_states_, sizeof(T), rl.version(), 0,
+      reinterpret_cast<uint8_t const *>(rl.data()), rl.size());
+}
+
+// Send the entries from first_entry on as the delta that takes the list to
+// its current version
+template<typename T>
+bool send_rl_delta(
+  std::ostream &os, Hb_epid_rl<T> const &rl, size_t first_entry) noexcept
+{
+    return write_rl_transport(os, Rl_transport_kind::delta,
+      rl_binary_type<T>(), T::n_states_, sizeof(T), rl.version(), first_entry,
+      reinterpret_cast<uint8_t const *>(rl.data() + first_entry),
+      rl.size() - first_entry);
+}
+
+template<typename T>
+bool receive_rl_binary(std::istream &is, std::string const &filename) noexcept
+{
+    return receive_rl_transport(
+      is, filename, rl_binary_type<T>(), T::n_states_, sizeof(T));
+}
+
+// Add a delta read from is to rl, the entries are added as they are decoded
+// and taken off again if the delta turns out to be bad
+template<typename T>
+bool apply_rl_transport_delta(Hb_epid_rl<T> &rl, std::istream &is) noexcept
+{
+    size_t first_entry = rl.size();
+    Rl_transport_sink sink;
+    sink.header_ = [&rl](Rl_transport_header const &header) {
+        if (header.kind_ != Rl_transport_kind::delta
+            || header.first_entry_ != rl.size()
+            || header.list_version_ != rl.version() + 1) {
+            std::cerr << "The delta to version " << header.list_version_
+                      << " does not follow on from version " << rl.version()
+                      << " (" << rl.size() << " entries)\n";
+            return false;
+        }
+        // The count comes from the stream, so it is not trusted with more
+        // than a bounded reserve. The list grows as the batches arrive and
+        // the count is checked once the stream ends.
+        rl.reserve(rl.size()
+                   + static_cast<size_t>(std::min<uint64_t>(
+                     header.n_entries_, rl_read_max_reserve)));
+        return true;
+    };
+    sink.records_ = [&rl](uint8_t const *records, size_t n_entries) {
+        rl.append_range(reinterpret_cast<T const *>(records), n_entries);
+        return true;
+    };
+    Rl_transport_decoder decoder(
+      rl_binary_type<T>(), T::n_states_, sizeof(T), std::move(sink));
+    if (!decode_rl_transport_stream(is, decoder)) {
+        rl.resize(first_entry);
+        return false;
+    }
+    rl.set_version(decoder.header().list_version_);
+    return true;
+}
+
+#endif
@@ -39,17 +39,109 @@
 #ifndef HB_EPID_SIGNATURE_H
 #define HB_EPID_SIGNATURE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Hbgs_param.h"
 #include "Lowmc64.h"
 #include "Hb_epid_revocation_lists.h"
+#include "Hb_epid_rl_digest.h"
+
+// The checking data held elsewhere, for example in the buffer a signature
+// was received in (see Revocation_signature_view)
+struct Revocation_checking_view
+{
+    Lowmc_state_words64_const_ptr sst_{ nullptr };
+    Epid_arl_entry const *a_j_{ nullptr };
+    size_t n_a_j_{ 0 };
+};
 
 struct Revocation_checking_data
 {
     Lowmc_state_words64 sst_{ 0 };
     Epid_a_rl a_j_;
+
+    Revocation_checking_view view() const noexcept
+    {
+        return { sst_, a_j_.data(), a_j_.size() };
+    }
+};
+
+// The wire form of a signature. A 96 byte header gives the sizes of each of
+// the parts, which follow it one after the other, and the content digest of
+// the SRL the signature was made against (see Hb_epid_rl_digest.h), so a
+// verifier can check it has the same list before doing any of the MPC
+// work. The states are held as they are in memory (padded to whole 64-bit
+// words) and every part starts on an 8 byte boundary, so a signature read
+// into an aligned buffer is used in place (see Revocation_signature_view).
+// All of the header values are little-endian:
+//
+//   0  magic "HBGS-SIG"             header  (96 bytes)
+//   8  version (u16)                srl reference, padded to 8 bytes
+//  10  state size n, in bits (u16)  str (the nonce), padded to 8 bytes
+//  12  bytes per state (u16)        sid, r, sst
+//  14  nonce bytes (u16)            the A_j list
+//  16  total length, in bytes (u64) pi_E, the proof
+//  24  srl reference length (u32)
+//  32  number of A_j entries (u64)
+//  40  proof length, in bytes (u64)
+//  48  SRL content digest (32 bytes)
+const std::string rsig_file_ext{ "rsig" };
+
+constexpr size_t rs_header_bytes = 96;
+// Version 2 carries the SRL content digest
+constexpr uint16_t rs_version = 2;
+// The longest signature read_rs takes, and how much more of one it makes
+// room for at a time when the length of the stream can't be found
+constexpr size_t rs_max_wire_bytes = size_t(1) << 40;
+constexpr size_t rs_read_chunk_bytes = size_t(64) << 20;
+
+// The length of a signature in the wire form
+size_t rs_wire_bytes(
+  size_t srl_reference_len, size_t n_a_j, size_t proof_len) noexcept;
+// The total length given in a header, or 0 if the len bytes at header do
+// not start a signature this code can read
+size_t rs_wire_bytes(uint8_t const *header, size_t len) noexcept;
+
+class Revocation_signature;
+
+// A signature read in place, from a buffer holding its wire form or from a
+// Revocation_signature. Nothing is copied, so whatever the view refers to
+// must outlive it.
+class Revocation_signature_view
+{
+  public:
+    Revocation_signature_view() = default;
+    explicit Revocation_signature_view(
+      Revocation_signature const &rsig) noexcept;
+
+    // Check that buf holds the whole of a signature in the wire form and
+    // point into it. buf must be 8 byte aligned.
+    bool parse(uint8_t const *buf, size_t len) noexcept;
+
+    std::string_view srl_reference() const noexcept { return srl_reference_; }
+    uint8_t const *srl_digest() const noexcept { return srl_digest_; }
+    uint8_t const *str() const noexcept { return str_; }
+    Lowmc_state_words64_const_ptr sid() const noexcept { return sid_; }
+    Lowmc_state_words64_const_ptr rv() const noexcept { return r_value_; }
+    Lowmc_state_words64_const_ptr sst() const noexcept { return cd_.sst_; }
+    Revocation_checking_view const &rev_check() const noexcept { return cd_; }
+    uint8_t const *sig() const noexcept { return sig_; }
+    size_t siglen() const noexcept { return siglen_; }
+
+  private:
+    std::string_view srl_reference_;
+    uint8_t const *srl_digest_{ nullptr };
+    uint8_t const *str_{ nullptr };
+    Lowmc_state_words64_const_ptr sid_{ nullptr };
+    Lowmc_state_words64_const_ptr r_value_{ nullptr };
+    Revocation_checking_view cd_;
+    uint8_t const *sig_{ nullptr };
+    size_t siglen_{ 0 };
 };
 
 class Revocation_signature
@@ -57,7 +149,8 @@ class Revocation_signature
   public:
     using sig_buffer = std::vector<uint8_t>;
     Revocation_signature() = default;
-    Revocation_signature(std::string const &srl_file, uint8_t const *str,
+    Revocation_signature(std::string const &srl_file,
+      Rl_digest const &srl_digest, uint8_t const *str,
       Lowmc_state_words64_const_ptr sid, Lowmc_state_words64_const_ptr sst,
       Lowmc_state_words64_const_ptr r_value) noexcept;
     Revocation_signature(Revocation_signature const &gle) = delete;
@@ -73,12 +166,24 @@ class Revocation_signature
     sig_buffer const &sig_buf() const noexcept { return signature_; }
     uint8_t *sig() noexcept { return signature_.data(); }
     uint8_t const *sig() const noexcept { return signature_.data(); }
+    std::string const &srl_reference() const noexcept
+    {
+        return srl_reference_;
+    }
+    Rl_digest const &srl_digest() const noexcept { return srl_digest_; }
+    // The signature in the wire form, written part by part without
+    // gathering it into a buffer first
     bool print_rs(std::ostream &os) const noexcept;
+    // Read the next signature from a stream of them, the header and then the
+    // rest of the signature in one read
     bool read_rs(std::istream &is) noexcept;
+    // Copy a signature held elsewhere
+    void assign(Revocation_signature_view const &view);
 
   private:
     std::string srl_reference_{ "unset" };// For these tests this will be a
                                           // filename (relative to base_dir)
+    Rl_digest srl_digest_{};// The content digest of the SRL
     // Σ = (str, sid, r, sst, ∀j∈[1,J] Aj ,πE).
     uint8_t str_[Mpc_parameters::nonce_size_bytes_]{ 0 };
     Lowmc_state_words64 sid_{ 0 };
@@ -88,10 +193,21 @@ class Revocation_signature
     sig_buffer signature_{};
 };
 
+// Check that a signature was made against the SRL with the given content
+// digest, reporting a mismatch on std::cerr
+bool check_srl_digest(
+  Revocation_signature_view const &rsig, uint8_t const *srl_digest);
+
+// Save a signature in the wire form to <base_dir>/<sig_name>.rsig
 bool print_revocation_signature(Revocation_signature const &sig,
   std::string const &base_dir, std::string const &sig_name);
 
 bool read_revocation_signature(Revocation_signature &sig,
   std::string const &base_dir, std::string const &sig_name);
 
+// Read a saved signature into buffer with a single read, to be used in place
+// with a Revocation_signature_view
+bool read_revocation_signature_buffer(std::vector<uint8_t> &buffer,
+  std::string const &base_dir, std::string const &sig_name);
+
 #endif
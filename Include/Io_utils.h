@@ -39,6 +39,8 @@
 #ifndef IO_UTILS_H
 #define IO_UTILS_H
 
+#include <cstddef>
+#include <cstdint>
 #include <initializer_list>
 #include <iostream>
 #include <sstream>
@@ -96,6 +98,16 @@ bool read_hex_byte(std::istream &is, uint8_t *byte);
 
 bool read_hex_bytes(std::istream &is, uint8_t *buf, size_t number_to_read);
 
+// Write n_bytes as 2 * n_bytes lower case hex characters (no terminator),
+// using a table of the character pairs
+void encode_hex(char *out, uint8_t const *in, size_t n_bytes) noexcept;
+
+// Decode the 2 * n_bytes hex characters (upper or lower case) at hex into
+// out, 32 characters at a time with SSE2 where it is available. Returns the
+// number of characters read before the first one that is not a hex digit,
+// which is 2 * n_bytes if they are all good.
+size_t decode_hex(uint8_t *out, char const *hex, size_t n_bytes) noexcept;
+
 // Initialiser list version of vars_to_string
 // (A,B) - A is carried out first, then B. The result from B is returned
 // (os << t, 0) - writes t to the stream and returns 0 to the <int> initializer
@@ -43,6 +43,10 @@
 #include <iostream>
 #include <fstream>
 #include <cmath>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "Hbgs_param.h"
 #include "Mpc_parameters.h"
@@ -60,6 +64,61 @@ using Lowmc_state_words64 = Word[lowmc_state_words64];
 using Lowmc_state_words64_ptr = Word *;
 using Lowmc_state_words64_const_ptr = Word const *;
 
+// A state packed into lowmc_state_bytes_ (17 bytes for n = 129, 32 for
+// n = 255), rather than padded to whole words, for storing large lists
+constexpr size_t lowmc_state_packed_bytes = Mpc_parameters::lowmc_state_bytes_;
+
+inline void pack_lowmc_state_words64(
+  uint8_t *packed, Lowmc_state_words64_const_ptr state) noexcept
+{
+    std::memcpy(packed, state, lowmc_state_packed_bytes);
+}
+
+// Unpack a state into whole words, clearing the padding
+inline void unpack_lowmc_state_words64(
+  Lowmc_state_words64_ptr state, uint8_t const *packed) noexcept
+{
+#if defined(__SSE2__)
+    if constexpr (lowmc_state_packed_bytes == 32
+                  && lowmc_state_words64_bytes == 32) {
+        auto const *in = reinterpret_cast<__m128i const *>(packed);
+        auto *out = reinterpret_cast<__m128i *>(state);
+        _mm_storeu_si128(out, _mm_loadu_si128(in));
+        _mm_storeu_si128(out + 1, _mm_loadu_si128(in + 1));
+        return;
+    } else if constexpr (lowmc_state_packed_bytes > 16
+                         && lowmc_state_words64_bytes == 24) {
+        // Sixteen bytes in one go, then the last word with its padding
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state),
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(packed)));
+        Word last{ 0 };
+        std::memcpy(&last, packed + 16, lowmc_state_packed_bytes - 16);
+        state[2] = last;
+        return;
+    }
+#endif
+    std::memset(state, 0, lowmc_state_words64_bytes);
+    std::memcpy(state, packed, lowmc_state_packed_bytes);
+}
+
+// True if nothing is set beyond the n bits of a state: the spare bits at the
+// bottom of its last byte (7 of them for n = 129) and the padding to whole
+// words
+inline bool lowmc_state_padding_clear(uint8_t const *state) noexcept
+{
+    constexpr size_t whole = Mpc_parameters::lowmc_state_bits_ / 8;
+    constexpr size_t extra = Mpc_parameters::lowmc_state_bits_ % 8;
+    uint8_t padding = 0;
+    if constexpr (extra != 0) {
+        padding = state[whole] & static_cast<uint8_t>(0xff >> extra);
+    }
+    for (size_t b = Mpc_parameters::lowmc_state_bytes_;
+         b < lowmc_state_words64_bytes; ++b) {
+        padding |= state[b];
+    }
+    return padding == 0;
+}
+
 void print_lowmc_state_words64(
   std::ostream &os, Lowmc_state_words64_const_ptr state_ptr) noexcept;
 
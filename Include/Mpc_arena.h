@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * File:        Mpc_arena.h
+ * Description: A session arena, the per-signature data is bump allocated from
+ *              it and released in bulk
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_ARENA_H
+#define MPC_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+#include "tree.h"
+}
+
+// The smallest block the arena asks for. This is large enough to be mapped
+// (see Mpc_memory.h), so the system allocator is not involved.
+constexpr size_t mpc_arena_block_size = 256 * 1024;
+
+// A monotonic arena for the data of one signing or verification session.
+// Allocation is a bump of an offset in the current block; nothing is freed
+// until the whole arena is reset or released.
+//
+// reset() keeps the memory for the next session. If the session needed more
+// than one block they are replaced by a single block of the combined size, so
+// once the arena has seen the largest session for a list it does not go back
+// to the system again.
+//
+// The memory returned is zeroed, as with calloc. Allocation can be made from
+// the worker threads.
+class Mpc_arena
+{
+  public:
+    explicit Mpc_arena(size_t block_size = mpc_arena_block_size) noexcept;
+    Mpc_arena(Mpc_arena const &) = delete;
+    Mpc_arena &operator=(Mpc_arena const &) = delete;
+    ~Mpc_arena();
+
+    // Returns nullptr on failure. alignment must be a power of two, no more
+    // than 64.
+    void *allocate(size_t size, size_t alignment = 16) noexcept;
+    // Make sure the next size bytes allocated, including the padding that
+    // aligns them, come from one block. If the current block has not the room
+    // a block of that size (or the block size, if larger) is added, and a
+    // block that is too small and holds nothing is given back first. An arena
+    // sized up front like this for a session holds it in a single block, so
+    // the memory it takes is known (see Mpc_memory_estimate).
+    bool reserve(size_t size) noexcept;
+    template<typename T> T *allocate_array(size_t n) noexcept
+    {
+        return static_cast<T *>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Ready the arena for another session. Everything that was allocated from
+    // it must no longer be in use.
+    void reset() noexcept;
+    // Return all of the memory to the system
+    void release() noexcept;
+
+    size_t bytes_used() const noexcept;
+    size_t capacity() const noexcept;
+    size_t n_blocks() const noexcept;
+
+  private:
+    struct Block
+    {
+        uint8_t *base_{ nullptr };
+        size_t size_{ 0 };
+        size_t used_{ 0 };
+        size_t dirty_{ 0 };// Bytes that may be non-zero
+    };
+    bool add_block(size_t min_size) noexcept;
+
+    mutable std::mutex mutex_;
+    size_t first_block_size_;
+    size_t block_size_;
+    std::vector<Block> blocks_;
+    size_t current_{ 0 };
+};
+
+// Allocation that comes from an arena if one is given and otherwise from the
+// system, so that the signature data can be used either way. The free
+// functions do nothing for memory from an arena.
+void *arena_allocate(Mpc_arena *arena, size_t size) noexcept;
+void arena_free(Mpc_arena *arena, void *mem) noexcept;
+
+// The picnic tree, commitments and shares, laid out as by the picnic
+// functions of the same name (so they can be used with the rest of picnic),
+// each in a single allocation
+tree_t *arena_create_tree(
+  Mpc_arena *arena, size_t numLeaves, size_t dataSize) noexcept;
+// The size of the allocation made by arena_create_tree
+size_t arena_tree_bytes(size_t numLeaves, size_t dataSize) noexcept;
+// Lay out a tree, as arena_create_tree, in arena_tree_bytes(numLeaves,
+// dataSize) bytes of zeroed memory
+tree_t *place_tree(uint8_t *mem, size_t numLeaves, size_t dataSize) noexcept;
+tree_t *arena_generate_seeds(Mpc_arena *arena, size_t nSeeds,
+  uint8_t *rootSeed, uint8_t *salt, size_t repIndex,
+  paramset_t *params) noexcept;
+void arena_free_tree(Mpc_arena *arena, tree_t *tree) noexcept;
+
+commitments_t *arena_allocate_commitments(
+  Mpc_arena *arena, paramset_t *params, size_t numCommitments) noexcept;
+void arena_free_commitments(
+  Mpc_arena *arena, commitments_t *commitments) noexcept;
+void arena_allocate_commitments2(Mpc_arena *arena, commitments_t *commitments,
+  paramset_t *params, size_t numCommitments) noexcept;
+void arena_free_commitments2(
+  Mpc_arena *arena, commitments_t *commitments) noexcept;
+
+#endif
@@ -0,0 +1,167 @@
+/*******************************************************************************
+ * File:        Mpc_footprint.h
+ * Description: A model of the memory used to sign and verify, and the
+ *              measurement of the memory actually used in each phase
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_FOOTPRINT_H
+#define MPC_FOOTPRINT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <array>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+}
+#include "Mpc_parameters.h"
+
+// The phases of signing and verifying. The memory for a phase includes
+// everything that is still held from the phases before it.
+enum class Mpc_phase : uint8_t {
+    sign_prepare,// The working data, commitments and seeds are set up
+    sign_repetitions,// Every repetition has been simulated and committed to
+    sign_proofs,// The challenge is known and the signature written
+    verify_prepare,// The signature is read and the seeds recomputed
+    verify_repetitions,// Every repetition has been checked
+    verify_challenge// The Merkle tree and challenge hash have been checked
+};
+constexpr size_t mpc_n_phases = 6;
+
+char const *mpc_phase_name(Mpc_phase phase) noexcept;
+
+// A prediction of the memory needed for one signature, or verification,
+// broken down by what it is used for. As with signature_size_estimate this
+// only depends on the parameters, so it can be used to size a signer before
+// any signature is made.
+//
+// The signing and verification states are given arenas sized up front from
+// the estimate (see Mpc_arena::reserve), so each is a single block and the
+// phase figures are the sizes of the blocks rather than just what is used of
+// them. An arena block is never smaller than mpc_arena_block_size.
+struct Mpc_memory_estimate
+{
+    bool streaming_{ false };
+    size_t seeds_{ 0 };// The tree of initial seeds
+    size_t seed_pool_{ 0 };// The party seed trees, in a pool of their own
+    size_t working_data_{ 0 };// The aux bits and states (not streaming)
+    size_t msgs_{ 0 };// The broadcast messages (not streaming)
+    size_t commitments_{ 0 };// C, Ch, Cv and the Merkle tree of Cv
+    size_t proof_data_{ 0 };// The challenge, the seed and Cv info, and the
+                            // proofs of the opened rounds
+    size_t padding_{ 0 };// For the alignment of each arena allocation
+    size_t scratch_{ 0 };// The scratch data of every worker
+    size_t signature_{ 0 };// The signature (verify reads it in place)
+
+    // What the signing and verification states and their signature data
+    // take from an arena, leaving out the seeds, which may come from an arena
+    // of their own
+    size_t sign_arena_bytes() const noexcept;
+    size_t verify_arena_bytes() const noexcept;
+
+    // The memory in use by the end of the given phase
+    size_t phase_bytes(Mpc_phase phase) const noexcept;
+    size_t peak_bytes() const noexcept;
+};
+
+// The estimate for the given parameters, with n_workers worker threads.
+// max_step_bits and tape_window_bits are those of the MPC class. If
+// streaming is set the estimate is for the streaming sign and in place verify.
+Mpc_memory_estimate mpc_memory_estimate(Mpc_param const &param,
+  paramset_t const &paramset, size_t n_workers, size_t max_step_bits,
+  size_t tape_window_bits, bool streaming) noexcept;
+
+// The estimate of what is taken from the arenas, for sizing them up front.
+// The scratch data, which depends on the workers, is left out.
+Mpc_memory_estimate mpc_arena_estimate(
+  Mpc_param const &param, bool streaming) noexcept;
+
+void print_memory_estimate(std::ostream &os, Mpc_memory_estimate const &me);
+
+// Records the memory actually used in each phase of a run. Once a probe is
+// installed the sign and verify code calls mpc_memory_phase() at the end of
+// each phase, which records the slab high-water mark (see Mpc_memory.h) and
+// the peak resident set size (from getrusage) since the previous phase ended.
+// Where /proc/self/clear_refs can be written the peak RSS is reset for each
+// phase, otherwise it is the peak since the process started.
+//
+// If a phase is seen more than once the largest values are kept. Only one
+// probe can be installed at a time and the phases must be marked from one
+// thread, so a probe should not be used with the batch or pipeline code.
+class Mpc_memory_probe
+{
+  public:
+    struct Record
+    {
+        size_t count_{ 0 };// The number of times the phase was seen
+        size_t slab_peak_{ 0 };// Bytes
+        size_t rss_peak_{ 0 };// Bytes
+    };
+
+    Mpc_memory_probe() = default;
+    Mpc_memory_probe(Mpc_memory_probe const &) = delete;
+    Mpc_memory_probe &operator=(Mpc_memory_probe const &) = delete;
+    ~Mpc_memory_probe();
+
+    // Start recording to this probe, the first phase starts now
+    void install() noexcept;
+    void uninstall() noexcept;
+    void record(Mpc_phase phase) noexcept;
+    // Start the next phase afresh, leaving out what was used since the last
+    // phase ended (such as the signer's memory, before verifying)
+    void start_phase() noexcept;
+
+    Record const &phase_record(Mpc_phase phase) const noexcept
+    {
+        return records_[static_cast<size_t>(phase)];
+    }
+    // One line for each phase seen, with the estimate alongside if one is
+    // given
+    void print(std::ostream &os, Mpc_memory_estimate const *me) const;
+
+  private:
+    std::array<Record, mpc_n_phases> records_{};
+    bool rss_reset_{ false };// Set if the peak RSS can be reset
+};
+
+// Mark the end of a phase. This does nothing unless a probe is installed.
+void mpc_memory_phase(Mpc_phase phase) noexcept;
+
+#endif
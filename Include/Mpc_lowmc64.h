@@ -73,7 +73,7 @@ class Mpc_lowmc64
     void get_aux_bits(uint8_t *aux_bits, uint32_t &pos,
       randomTape_t *current_tape_ptr) const noexcept;
     void set_aux_bits(randomTape_t *current_tape_ptr, uint32_t &pos,
-      uint8_t *aux_bits) const noexcept;
+      uint8_t const *aux_bits) const noexcept;
     constexpr static Tape_offset offset_bits_ = { 0 };
     constexpr static Tape_offset aux_bits_ = Mpc_parameters::lowmc_ands_bits_;
     // Two sets of bits needed for each round
@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * File:        Mpc_memory.h
+ * Description: Allocation of the large per-repetition slabs (random tapes,
+ *              broadcast messages) with optional huge page backing
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_MEMORY_H
+#define MPC_MEMORY_H
+
+#include <cstddef>
+#include <iostream>
+
+// Huge pages are used for the large slabs if the environment variable
+// HBGS_HUGE_PAGES is set to anything other than 0. Transparent huge pages are
+// requested with madvise, so nothing needs to be reserved by the system.
+bool mpc_huge_pages_enabled() noexcept;
+
+// Slabs at least this size are mapped directly, so that the pages are not
+// touched until they are first written. The thread that first writes a page
+// decides which NUMA node it is placed on.
+constexpr size_t mpc_mapped_slab_minimum = 64 * 1024;
+
+// Returns zeroed memory aligned to 64 bytes, or nullptr on failure. The memory
+// must be released with free_slab.
+void *allocate_slab(size_t size) noexcept;
+
+void free_slab(void *slab) noexcept;
+
+// The bytes held in slabs now, and the most held at any one time since the
+// last call to reset_slab_high_water. Every slab allocation is counted, which
+// covers the arenas and the large per-signature buffers.
+size_t mpc_slab_bytes() noexcept;
+size_t mpc_slab_high_water() noexcept;
+void reset_slab_high_water() noexcept;
+
+// Report the thread placement and huge page setting
+void print_memory_placement(std::ostream &os);
+
+#endif
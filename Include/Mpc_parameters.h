@@ -92,6 +92,21 @@ struct Mpc_param
     size_t aux_size_bytes_{ 0 };// The size of the aux bits
 };
 
+constexpr static bool operator==(
+  Mpc_param const &mpc1, Mpc_param const &mpc2)
+{
+    return mpc1.aux_size_bits_ == mpc2.aux_size_bits_
+           && mpc1.n_inputs_ == mpc2.n_inputs_
+           && mpc1.n_mpc_inputs_ == mpc2.n_mpc_inputs_
+           && mpc1.n_outputs_ == mpc2.n_outputs_;
+}
+
+constexpr static bool operator!=(
+  Mpc_param const &mpc1, Mpc_param const &mpc2)
+{
+    return !(mpc1 == mpc2);
+}
+
 constexpr static Mpc_param operator+(
   Mpc_param const &mpc1, Mpc_param const &mpc2)
 {
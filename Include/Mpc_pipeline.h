@@ -0,0 +1,219 @@
+/*******************************************************************************
+ * File:        Mpc_pipeline.h
+ * Description: A staged pipeline (read, deserialise, verify, report) joined
+ *              by bounded queues, so that I/O overlaps the verification
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_PIPELINE_H
+#define MPC_PIPELINE_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "Io_utils.h"
+
+// A fixed capacity FIFO. push blocks while the queue is full, which is what
+// stops a fast stage from running ahead of a slow one. pop blocks until there
+// is an item, returning false once the queue has been closed and emptied.
+template<typename T> class Bounded_queue
+{
+  public:
+    Bounded_queue() = delete;
+    explicit Bounded_queue(size_t capacity) noexcept
+      : capacity_{ capacity == 0 ? 1 : capacity }
+    {}
+    Bounded_queue(Bounded_queue const &) = delete;
+    Bounded_queue &operator=(Bounded_queue const &) = delete;
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+        items_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) { return false; }
+        item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // No more items will be pushed
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+    }
+
+  private:
+    size_t capacity_;
+    std::deque<T> items_;
+    bool closed_{ false };
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+// The number of items allowed to wait between each pair of stages. Together
+// they bound the number of signatures (and lists) held in memory at once.
+struct Pipeline_config
+{
+    size_t read_depth_{ 2 };// Read, waiting to be deserialised
+    size_t verify_depth_{ 2 };// Deserialised, waiting to be verified
+    size_t report_depth_{ 4 };// Verified, waiting to be reported
+};
+
+// All three depths are set by the environment variable HBGS_QUEUE_DEPTH if it
+// is present, otherwise the defaults are used
+inline Pipeline_config pipeline_config() noexcept
+{
+    Pipeline_config config;
+    std::string depth = get_environment_variable("HBGS_QUEUE_DEPTH", "");
+    if (!depth.empty()) {
+        size_t n = std::strtoul(depth.c_str(), nullptr, 10);
+        if (n > 0) {
+            config.read_depth_ = n;
+            config.verify_depth_ = n;
+            config.report_depth_ = n;
+        }
+    }
+    return config;
+}
+
+// The work done for each job. read and deserialise run on their own threads
+// and should only do I/O and parsing. verify runs on the calling thread and
+// is free to use the MPC thread pool. report is called in job order, on its
+// own thread, with loaded_ok false if the job could not be read or
+// deserialised (in which case verify is not called for it).
+template<typename Job, typename Raw, typename Loaded, typename Result>
+struct Pipeline_stages
+{
+    std::function<bool(Job const &job, Raw &raw)> read_;
+    std::function<bool(Raw &raw, Loaded &loaded)> deserialise_;
+    std::function<Result(Job const &job, Loaded &loaded)> verify_;
+    std::function<void(
+      size_t index, Job const &job, bool loaded_ok, Result const &result)>
+      report_;
+};
+
+template<typename Raw, typename Loaded, typename Result> struct Pipeline_item
+{
+    size_t index_{ 0 };
+    bool ok_{ true };
+    Raw raw_{};
+    Loaded loaded_{};
+    Result result_{};
+};
+
+// Run every job through the stages. While job i is being verified, job i+1
+// (and up to the queue depths beyond it) is being read and deserialised, and
+// job i-1 is being reported. Returns once every job has been reported.
+template<typename Job, typename Raw, typename Loaded, typename Result>
+void run_verification_pipeline(std::vector<Job> const &jobs,
+  Pipeline_stages<Job, Raw, Loaded, Result> const &stages,
+  Pipeline_config const &config = pipeline_config())
+{
+    using Item = std::unique_ptr<Pipeline_item<Raw, Loaded, Result>>;
+    Bounded_queue<Item> read_queue(config.read_depth_);
+    Bounded_queue<Item> verify_queue(config.verify_depth_);
+    Bounded_queue<Item> report_queue(config.report_depth_);
+
+    std::thread reader([&]() {
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            auto item = std::make_unique<Pipeline_item<Raw, Loaded, Result>>();
+            item->index_ = i;
+            item->ok_ = stages.read_(jobs[i], item->raw_);
+            read_queue.push(std::move(item));
+        }
+        read_queue.close();
+    });
+
+    std::thread deserialiser([&]() {
+        Item item;
+        while (read_queue.pop(item)) {
+            if (item->ok_) {
+                item->ok_ = stages.deserialise_(item->raw_, item->loaded_);
+            }
+            item->raw_ = Raw{};// Not needed any more
+            verify_queue.push(std::move(item));
+        }
+        verify_queue.close();
+    });
+
+    std::thread reporter([&]() {
+        Item item;
+        while (report_queue.pop(item)) {
+            stages.report_(
+              item->index_, jobs[item->index_], item->ok_, item->result_);
+        }
+    });
+
+    Item item;
+    while (verify_queue.pop(item)) {
+        if (item->ok_) {
+            item->result_ = stages.verify_(jobs[item->index_], item->loaded_);
+        }
+        item->loaded_ = Loaded{};
+        report_queue.push(std::move(item));
+    }
+    report_queue.close();
+
+    reader.join();
+    deserialiser.join();
+    reporter.join();
+}
+
+#endif
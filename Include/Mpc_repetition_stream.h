@@ -0,0 +1,283 @@
+/*******************************************************************************
+ * File:        Mpc_repetition_stream.h
+ * Description: Streams for the values produced by one MPC repetition, so that
+ *              they can be committed to or written out a step at a time
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_REPETITION_STREAM_H
+#define MPC_REPETITION_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+#include "hash.h"
+#include "kdf_shake.h"
+}
+
+#include "Mpc_parameters.h"
+#include "Lowmc64.h"
+
+// The values produced by the MPC simulation of one repetition: the last
+// party's aux bits, the broadcast messages and the MPC inputs and outputs.
+// The circuit calls step_done after the sst LowMC and after each SRL entry.
+// The complete bytes of the aux bits and messages can then be taken (hashed
+// or written to a signature) and the buffers reused, so a stream only has to
+// hold one step, whatever the size of the SRL.
+//
+// When verifying an opened round only msgs_ and step_done are used, the aux
+// bits and the inputs come from the proof.
+class Mpc_repetition_stream
+{
+  public:
+    virtual ~Mpc_repetition_stream() = default;
+    // Where MPC input i and output i of the repetition are to be written.
+    // These only need to be valid until the next step_done.
+    virtual Word *mpc_input(size_t i) noexcept = 0;
+    virtual Word *output(size_t i) noexcept = 0;
+    virtual void step_done() noexcept = 0;
+
+    uint8_t *aux_bits_{ nullptr };
+    uint32_t aux_pos_{ 0 };
+    msgs_t *msgs_{ nullptr };
+};
+
+// A window on n bit streams that are written at a common bit position. The
+// complete bytes are passed on by flush and the partial byte is moved to the
+// start of the window.
+class Mpc_bit_window
+{
+  public:
+    Mpc_bit_window() = delete;
+    // max_step_bits is the most bits that are written between flushes
+    Mpc_bit_window(size_t n_streams, size_t max_step_bits) noexcept;
+    Mpc_bit_window(Mpc_bit_window const &) = delete;
+    Mpc_bit_window &operator=(Mpc_bit_window const &) = delete;
+    ~Mpc_bit_window();
+
+    uint8_t **buffers() noexcept { return ptrs_.data(); }
+    uint8_t *buffer(size_t i) const noexcept { return ptrs_[i]; }
+    size_t capacity() const noexcept { return capacity_; }
+    // The number of bytes of each stream passed on so far
+    size_t flushed_bytes() const noexcept { return flushed_; }
+    void reset() noexcept { flushed_ = 0; }
+
+    // Pass on the complete bytes before bit pos, as sink(buffers, n_bytes),
+    // and return the position in the window of bit pos
+    template<typename F> size_t flush(size_t pos, F &&sink) noexcept
+    {
+        size_t n_bytes = pos / 8U;
+        if (n_bytes != 0) {
+            sink(ptrs_.data(), n_bytes);
+            if (pos % 8U != 0) {
+                for (auto *p : ptrs_) { p[0] = p[n_bytes]; }
+            }
+            flushed_ += n_bytes;
+        }
+        return pos % 8U;
+    }
+
+    // Pass on everything up to bit pos, with the unused bits of the last
+    // byte cleared
+    template<typename F> void finish(size_t pos, F &&sink) noexcept
+    {
+        pos = flush(pos, sink);
+        if (pos != 0) {
+            auto keep = static_cast<uint8_t>(0xffU << (8U - pos));
+            for (auto *p : ptrs_) { p[0] &= keep; }
+            sink(ptrs_.data(), 1);
+            flushed_ += 1;
+        }
+    }
+
+    bool is_initialised_{ false };
+
+  private:
+    size_t capacity_{ 0 };// Bytes per stream
+    size_t flushed_{ 0 };
+    uint8_t *slab_{ nullptr };
+    std::vector<uint8_t *> ptrs_;
+};
+
+// Hash the broadcast messages of each party as they are produced. The view
+// commitment is then
+//     Cv[t] = H(mpc_inputs[0] || H(msgs[0]) || ... || H(msgs[N-1]))
+// so the messages of all of the parties can be absorbed together.
+class Mpc_view_hash
+{
+  public:
+    void start(paramset_t *params) noexcept;
+    void update(uint8_t *const *msgs, size_t n_bytes) noexcept;
+    void finish(uint8_t *cv, uint8_t const *mpc_input0,
+      paramset_t *params) noexcept;
+
+  private:
+    static constexpr size_t n_contexts_ = Mpc_parameters::mpc_parties_ / 4;
+
+    // hash_context_x4 is over-aligned, so can't be used directly in an array
+    struct alignas(32) X4_context
+    {
+        hash_context_x4 ctx_;
+    };
+    X4_context ctx_[n_contexts_];
+};
+
+// The view commitment for messages that are all held in memory
+void commit_v_views(uint8_t *cv, uint8_t const *mpc_input0,
+  msgs_t const *msgs, paramset_t *params) noexcept;
+
+// The commitment to the seed and aux bits of the last party, with the aux
+// bits added as they are produced. The other parties use commit_c.
+class Mpc_aux_commitment
+{
+  public:
+    void start(uint8_t const *seed, paramset_t *params) noexcept;
+    void update(uint8_t const *aux, size_t n_bytes) noexcept;
+    void finish(uint8_t *digest, uint8_t const *salt, uint16_t t, uint16_t j,
+      paramset_t *params) noexcept;
+
+  private:
+    HashInstance ctx_;
+};
+
+// The commitment for the last party when all of the aux bits are held
+void commit_c_aux(uint8_t *digest, uint8_t const *seed, uint8_t const *aux,
+  size_t aux_size_bytes, uint8_t const *salt, uint16_t t, uint16_t j,
+  paramset_t *params) noexcept;
+
+// Computes the commitments of one repetition as it is simulated: the aux bits
+// are added to the last party's commitment and the messages to the view
+// hash. Only the first MPC input is kept, for the view commitment.
+//
+// For an opened round being verified the unopened party's messages are read
+// from the proof a step at a time.
+class Mpc_commitment_stream : public Mpc_repetition_stream
+{
+  public:
+    Mpc_commitment_stream() = delete;
+    // msgs_bytes is the size of the messages of one party for the whole
+    // repetition
+    Mpc_commitment_stream(size_t max_step_bits, size_t msgs_bytes) noexcept;
+
+    // Start a repetition. If last_party_seed is not null the aux bits are
+    // committed to.
+    void start(uint8_t const *last_party_seed, paramset_t *params) noexcept;
+    // The messages of this party are taken from unopened_msgs
+    void set_unopened(size_t party, uint8_t const *unopened_msgs) noexcept;
+
+    Word *mpc_input(size_t i) noexcept override
+    {
+        return (i == 0) ? input0_ : inputs_[i % 2];
+    }
+    Word *output([[maybe_unused]] size_t i) noexcept override
+    {
+        return output_;
+    }
+    void step_done() noexcept override;
+
+    void finish_aux(uint8_t *digest, uint8_t const *salt, uint16_t t,
+      uint16_t j, paramset_t *params) noexcept;
+    void finish_view(uint8_t *cv, uint8_t const *mpc_input0,
+      paramset_t *params) noexcept;
+
+    bool is_initialised_{ false };
+
+  private:
+    void refill_unopened() noexcept;
+
+    size_t msgs_bytes_{ 0 };
+    Mpc_bit_window aux_window_;
+    Mpc_bit_window msgs_window_;
+    msgs_t msgs_window_state_{};
+    bool commit_aux_{ false };
+    uint8_t const *unopened_msgs_{ nullptr };
+    Mpc_aux_commitment aux_commitment_;
+    Mpc_view_hash view_hash_;
+    Lowmc_state_words64 input0_{ 0 };
+    Lowmc_state_words64 inputs_[2]{};
+    Lowmc_state_words64 output_{ 0 };
+};
+
+// Where the fields of the proof for one opened round are to be written
+struct Mpc_proof_destination
+{
+    uint8_t *aux_{ nullptr };// Not written if null (P[t] == N-1)
+    uint8_t *msgs_{ nullptr };
+    size_t party_{ 0 };// The unopened party, whose messages are written
+    uint8_t *mpc_inputs_{ nullptr };
+    uint8_t *outputs_{ nullptr };
+};
+
+// Writes the proof of an opened round as the repetition is simulated again,
+// straight into a (serialised) signature. The states are simulated in
+// aligned buffers and copied out at the end of each step.
+class Mpc_proof_stream : public Mpc_repetition_stream
+{
+  public:
+    Mpc_proof_stream() = delete;
+    explicit Mpc_proof_stream(size_t max_step_bits) noexcept;
+
+    void start(Mpc_proof_destination const &dest) noexcept;
+    Word *mpc_input(size_t i) noexcept override;
+    Word *output(size_t i) noexcept override;
+    void step_done() noexcept override;
+    void finish() noexcept;
+
+    bool is_initialised_{ false };
+
+  private:
+    static constexpr size_t max_step_states_ = 4;
+
+    void copy_states() noexcept;
+    auto aux_sink() noexcept;
+    auto msgs_sink() noexcept;
+
+    Mpc_proof_destination dest_{};
+    Mpc_bit_window aux_window_;
+    Mpc_bit_window msgs_window_;
+    msgs_t msgs_window_state_{};
+    Lowmc_state_words64 states_[max_step_states_]{};
+    uint8_t *state_dest_[max_step_states_]{};
+    size_t n_states_{ 0 };
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * File:        Mpc_seed_trees.h
+ * Description: Seed trees for all of the repetitions held together, and
+ *              the seed expansion using the x4 Keccak
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_SEED_TREES_H
+#define MPC_SEED_TREES_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+#include "tree.h"
+}
+
+// As picnic's expandSeeds, giving the same seeds, but the nodes on each level
+// of the tree do not depend on each other so up to four of them are hashed at
+// once with the x4 Keccak
+void expand_seeds_x4(tree_t *tree, uint8_t const *salt, size_t repIndex,
+  paramset_t *params) noexcept;
+
+// A number of picnic trees of the same shape, such as the party seed trees of
+// every repetition, in a single slab. Each tree is laid out as by
+// arena_create_tree, one after the other at a fixed stride, so the nodes (and
+// the leaves, which come last) of a tree are contiguous. The slab is kept when
+// the pool is used again, so once it has been sized the trees for another
+// signature only need their flags clearing.
+//
+// reserve() must not be called while the trees are in use, otherwise each
+// tree can be used by a different thread.
+class Mpc_tree_pool
+{
+  public:
+    Mpc_tree_pool() = default;
+    Mpc_tree_pool(Mpc_tree_pool const &) = delete;
+    Mpc_tree_pool &operator=(Mpc_tree_pool const &) = delete;
+    ~Mpc_tree_pool();
+
+    // Ready n_trees trees with numLeaves leaves of dataSize bytes. The slab is
+    // only reallocated if it is too small or the shape has changed.
+    bool reserve(size_t n_trees, size_t numLeaves, size_t dataSize) noexcept;
+
+    // The size of the slab that holds n_trees trees of this shape
+    static size_t slab_bytes(
+      size_t n_trees, size_t numLeaves, size_t dataSize) noexcept;
+
+    size_t size() const noexcept { return n_trees_; }
+    // All of the trees, as an array
+    tree_t **trees() const noexcept { return trees_; }
+    // Tree i with none of its nodes set, for reconstructSeeds
+    tree_t *empty_tree(size_t i) noexcept;
+    // Tree i expanded from rootSeed, as generateSeeds
+    tree_t *generate_seeds(size_t i, uint8_t const *rootSeed,
+      uint8_t const *salt, size_t repIndex, paramset_t *params) noexcept;
+
+  private:
+    void release() noexcept;
+
+    uint8_t *slab_{ nullptr };
+    tree_t **trees_{ nullptr };
+    size_t capacity_{ 0 };// The number of trees the slab holds
+    size_t n_trees_{ 0 };
+    size_t n_leaves_{ 0 };
+    size_t data_size_{ 0 };
+};
+
+#endif
@@ -42,6 +42,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <vector>
 
 #include "picnic.h"
 extern "C" {
@@ -49,39 +50,58 @@ extern "C" {
 #include "picnic3_impl.h"
 #include "tree.h"
 }
+#include "Mpc_signature_utils.h"
+#include "Mpc_arena.h"
+#include "Mpc_seed_trees.h"
 
+// The seeds for each repetition. The random tapes are squeezed from these
+// seeds a window at a time (see Mpc_streaming_tapes) as each repetition is
+// processed. If an arena is given the trees are allocated from it (and
+// iSeedsTree must have been).
 class Signing_seeds_and_tapes
 {
   public:
     Signing_seeds_and_tapes() = delete;
-    Signing_seeds_and_tapes(
-      size_t tape_size_bytes, uint8_t *salt, tree_t *iSeedsTree) noexcept;
+    // If seed_trees is given the party seed trees are taken from it and it
+    // must not be reused until this has been destroyed
+    Signing_seeds_and_tapes(uint8_t *salt, tree_t *iSeedsTree,
+      Mpc_arena *arena = nullptr, Mpc_tree_pool *seed_trees = nullptr) noexcept;
+    Signing_seeds_and_tapes(Signing_seeds_and_tapes const &) = delete;
+    Signing_seeds_and_tapes &operator=(
+      Signing_seeds_and_tapes const &) = delete;
     ~Signing_seeds_and_tapes();
 
     bool is_initialised{ false };
     tree_t *iSeedsTree_{ nullptr };
-    randomTape_t *tapes_{ nullptr };
     tree_t **seeds_{ nullptr };
 
   private:
     uint8_t **iSeeds_{ nullptr };
+    Mpc_arena *arena_{ nullptr };
+    Mpc_tree_pool *seed_trees_{ nullptr };
 };
 
 class Verification_seeds_and_tapes
 {
   public:
     Verification_seeds_and_tapes() = delete;
-    Verification_seeds_and_tapes(
-      size_t tape_size_bytes, Signature_data const &sig_data) noexcept;
+    // proofs is indexed by round, only the opened rounds are used
+    Verification_seeds_and_tapes(Mpc_proof_data const &pd,
+      std::vector<Mpc_proof_view> const &proofs, Mpc_arena *arena = nullptr,
+      Mpc_tree_pool *seed_trees = nullptr) noexcept;
+    Verification_seeds_and_tapes(Verification_seeds_and_tapes const &) = delete;
+    Verification_seeds_and_tapes &operator=(
+      Verification_seeds_and_tapes const &) = delete;
     ~Verification_seeds_and_tapes();
 
     bool is_initialised_{ false };
     tree_t *iSeedsTree_{ nullptr };
-    randomTape_t *tapes_{ nullptr };
     tree_t **seeds_{ nullptr };
 
   private:
     uint8_t **iSeeds_{ nullptr };
+    Mpc_arena *arena_{ nullptr };
+    Mpc_tree_pool *seed_trees_{ nullptr };
 };
 
 using Shares_ptr = std::unique_ptr<shares_t, decltype(&::freeShares)>;
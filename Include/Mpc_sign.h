@@ -43,6 +43,10 @@
 #include <cinttypes>
 #include <cstring>
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <string>
@@ -61,14 +65,114 @@ extern "C" {
 #include "Mpc_parameters.h"
 #include "Mpc_seeds_and_tapes.h"
 #include "Mpc_working_data.h"
+#include "Mpc_thread_pool.h"
+#include "Mpc_repetition_stream.h"
+#include "Mpc_footprint.h"
 
 //#define DEBUG_SIGNING
 
-template<typename T>
-int generate_mpc_signature(T &mpc_class,
-  uint8_t const *message_digest,
-  uint8_t const *nonce,
-  Signature_data &sig_data) noexcept
+// The data for one signature while it is being generated. The working data
+// and commitment data are sized by the SRL, so a state can be reused for
+// further signatures against the same list. If an arena is given everything
+// is allocated from it. With a separate signature_arena, the seeds (the only
+// data that is new for each signature) come from that instead.
+class Mpc_signing_state
+{
+  public:
+    Mpc_signing_state() = delete;
+    Mpc_signing_state(Mpc_param const &param, Mpc_arena *arena = nullptr) noexcept
+      : Mpc_signing_state(param, arena, arena)
+    {}
+    Mpc_signing_state(Mpc_param const &param, Mpc_arena *arena,
+      Mpc_arena *signature_arena) noexcept
+      : mpc_wd_{ param, arena }, commitment_data1_{ arena },
+        commitments2_{ arena }, arena_(signature_arena)
+    {}
+    Mpc_signing_state(Mpc_signing_state const &) = delete;
+    Mpc_signing_state &operator=(Mpc_signing_state const &) = delete;
+
+    bool is_initialised() const noexcept
+    {
+        return mpc_wd_.is_initialised_ && commitment_data1_.is_initialised
+               && commitments2_.is_initialised;
+    }
+    void reset() noexcept
+    {
+        s_and_t_.reset();
+        mpc_wd_.reset();
+        commitments2_.reset();
+        ok_ = true;
+    }
+
+    Mpc_working_data mpc_wd_;
+    Commitment_data1 commitment_data1_;
+    Commitment_data2 commitments2_;
+    std::optional<Signing_seeds_and_tapes> s_and_t_;
+    std::atomic<bool> ok_{ true };// Cleared if any step fails
+    Mpc_arena *arena_{ nullptr };// For the seeds
+};
+
+// The data for one signature generated in a single (constant memory) pass.
+// Only the commitments are kept for each repetition, the proofs for the
+// opened rounds are recomputed and written straight into the signature.
+class Mpc_streaming_signing_state
+{
+  public:
+    Mpc_streaming_signing_state() = delete;
+    Mpc_streaming_signing_state(
+      Mpc_param const &param, Mpc_arena *arena = nullptr) noexcept
+      : sig_data_{ param, arena }, commitment_data1_{ arena },
+        commitments2_{ arena }, arena_(arena)
+    {}
+    Mpc_streaming_signing_state(Mpc_streaming_signing_state const &) = delete;
+    Mpc_streaming_signing_state &operator=(
+      Mpc_streaming_signing_state const &) = delete;
+
+    bool is_initialised() const noexcept
+    {
+        return sig_data_.is_initialised_ && commitment_data1_.is_initialised
+               && commitments2_.is_initialised;
+    }
+
+    Signature_data sig_data_;// Only the proof data, the proofs are not used
+    Commitment_data1 commitment_data1_;
+    Commitment_data2 commitments2_;
+    std::optional<Signing_seeds_and_tapes> s_and_t_;
+    std::atomic<bool> ok_{ true };// Cleared if any step fails
+    Mpc_arena *arena_{ nullptr };// For the seeds
+};
+
+// Passes the values produced by one repetition straight to the working data
+class Mpc_working_data_stream : public Mpc_repetition_stream
+{
+  public:
+    Mpc_working_data_stream(Mpc_working_data &mpc_wd, size_t t) noexcept
+      : mpc_wd_(mpc_wd), t_(t)
+    {
+        aux_bits_ = mpc_wd_.aux_bits(t_);
+        msgs_ = &mpc_wd_.msgs_[t_];
+    }
+    Word *mpc_input(size_t i) noexcept override
+    {
+        return reinterpret_cast<Word *>(mpc_wd_.mpc_inputs_.state(i, t_));
+    }
+    Word *output(size_t i) noexcept override
+    {
+        return reinterpret_cast<Word *>(mpc_wd_.outputs_.state(i, t_));
+    }
+    void step_done() noexcept override {}
+
+  private:
+    Mpc_working_data &mpc_wd_;
+    size_t t_;
+};
+
+// Compute the salt and the seeds for the random tapes. S is either of the
+// signing states. If seed_trees is given the party seed trees are taken from
+// it, rather than from the state's arena.
+template<typename T, typename S>
+int prepare_mpc_signature(T &mpc_class, S &ss, uint8_t const *nonce,
+  Signature_data &sig_data, Mpc_tree_pool *seed_trees = nullptr) noexcept
 {
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
@@ -79,152 +183,113 @@ int generate_mpc_signature(T &mpc_class,
     print_hbgs_parameters(std::cout);
     std::cout << "\ncompute_salt_and_root_seed\n";
 #endif
-    auto saltAndRoot = std::make_unique<uint8_t[]>(
-      paramset.saltSizeBytes + paramset.seedSizeBytes);
-    if (saltAndRoot == nullptr) { return EXIT_FAILURE; }
-    uint8_t *salt_and_root = saltAndRoot.get();
+    uint8_t salt_and_root[2 * MAX_SEED_SIZE_BYTES];// The salt is 32 bytes
+    if (paramset.saltSizeBytes + paramset.seedSizeBytes
+        > sizeof(salt_and_root)) {
+        return EXIT_FAILURE;
+    }
     mpc_class.compute_salt_and_root_seed(
       salt_and_root, paramset.saltSizeBytes + paramset.seedSizeBytes, nonce);
     memcpy(sig_data.mpc_pd_.salt_, salt_and_root, paramset.saltSizeBytes);
 
-    tree_t *iSeedsTree = generateSeeds(paramset.numMPCRounds,
+    tree_t *iSeedsTree = arena_generate_seeds(ss.arena_,
+      paramset.numMPCRounds,
       salt_and_root + paramset.saltSizeBytes,
       sig_data.mpc_pd_.salt_,
       0,
       &paramset);
-    Tree_ptr iseeds_tree_ptr(iSeedsTree, freeTree);
-
-    //=========================================================================
-    // Set up the structures and offsets
-#ifdef DEBUG_SIGNING
-    std::cout << "set_offsets\n";
-#endif
-    Tape_offset next_offset = 0;
-
-    next_offset = mpc_class.set_offsets(next_offset);
-
-    size_t tape_size_bytes = (next_offset + 7U) / 8U;
-
-#ifdef DEBUG_SIGNING
-    std::cout << "Tape size bytes: " << tape_size_bytes << '\n';
-#endif
+    if (iSeedsTree == nullptr) {
+        std::cerr << "Unable to allocate memory for the iSeedsTree\n";
+        return EXIT_FAILURE;
+    }
 
     //=========================================================================
-    // Set up the tapes and seeds. Pass on ownership of iSeedsTree
+    // Set up the seeds. Pass on ownership of iSeedsTree
 #ifdef DEBUG_SIGNING
     std::cout << "setup salts and seeds\n";
 #endif
-    Signing_seeds_and_tapes s_and_t(
-      tape_size_bytes, sig_data.mpc_pd_.salt_, iseeds_tree_ptr.release());
-    if (!s_and_t.is_initialised) {
+    ss.s_and_t_.emplace(
+      sig_data.mpc_pd_.salt_, iSeedsTree, ss.arena_, seed_trees);
+    if (!ss.s_and_t_->is_initialised) {
         std::cerr << "Unable to initialise the seeds and tapes\n";
         return EXIT_FAILURE;
     }
 
-    randomTape_t *tapes = s_and_t.tapes_;
-    tree_t **seeds = s_and_t.seeds_;
-
-    // print_random_tapes(std::cout, tapes, tape_size_bytes);
-
-    Mpc_working_data mpc_wd(sig_data.proof_param_);
-    if (!mpc_wd.is_initialised_) {
-        std::cerr << "Mpc_working_data not correctly initialised\n";
+    if (!ss.is_initialised()) {
+        std::cerr << "Mpc_signing_state not correctly initialised\n";
         return EXIT_FAILURE;
     }
 
+    return EXIT_SUCCESS;
+}
+
+// Preprocess, commit and simulate the MPC for repetition t
+template<typename T>
+int sign_mpc_repetition(T &mpc_class, Mpc_signing_state &ss,
+  Signature_data &sig_data, Mpc_worker_scratch &scratch, size_t t) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    tree_t **seeds = ss.s_and_t_->seeds_;
+    Mpc_working_data &mpc_wd = ss.mpc_wd_;
+    commitments_t *C = ss.commitment_data1_.C_;
+    auto tr = static_cast<uint16_t>(t);
+
     //=========================================================================
-    // Preprocessing; compute aux tape for the N-th player, for each parallel
-    // rep
-#ifdef DEBUG_SIGNING
-    std::cout << "compute_aux_tape_sign\n";
-#endif
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        mpc_class.compute_aux_tape_sign(tapes, mpc_wd, t);
+    // Preprocessing (compute the aux bits for the N-th player) and simulation
+    // of the online phase of the MPC. Both are done as the tapes are streamed.
+    Mpc_streaming_tapes &tapes = *scratch.tapes_;
+    tapes.start(getLeaves(seeds[t]), sig_data.mpc_pd_.salt_, t, &paramset);
+    Mpc_working_data_stream stream{ mpc_wd, t };
+    int rv =
+      mpc_class.sign_repetition(tapes, stream, scratch.tmp_shares_.get());
+    if (rv != 0) {
+        std::cerr << "MPC simulation failed, aborting signature\n";
+        return EXIT_FAILURE;
     }
+
     //=========================================================================
     // Commit to seeds and aux bits
-#ifdef DEBUG_SIGNING
-    std::cout << "commit to seeds and aux bits\n";
-#endif
-    Commitment_data1 commitment_data1;
-    if (!commitment_data1.is_initialised) {
-        std::cerr << "Unable to setup the initial commitment data\n";
-        return EXIT_FAILURE;
-    }
-    commitments_t *C = commitment_data1.C_;
-    for (uint16_t t = 0; t < paramset.numMPCRounds; t++) {
-        for (uint16_t j = 0; j < paramset.numMPCParties - 1; j++) {
-            commit_c(C[t].hashes[j],
-              getLeaf(seeds[t], j),
-              NULL,
-              sig_data.mpc_pd_.salt_,
-              t,
-              j,
-              &paramset);
-        }
-        uint32_t last = paramset.numMPCParties - 1;
-        mpc_class.get_aux_bits(mpc_wd.aux_bits_, tapes, t);
-        commit_c(C[t].hashes[last],
-          getLeaf(seeds[t], last),
-          mpc_wd.aux_bits_,
+    for (uint16_t j = 0; j < paramset.numMPCParties - 1; j++) {
+        commit_c(C[t].hashes[j],
+          getLeaf(seeds[t], j),
+          NULL,
           sig_data.mpc_pd_.salt_,
-          t,
-          (uint16_t)last,
+          tr,
+          j,
           &paramset);
     }
+    uint32_t last = paramset.numMPCParties - 1;
+    commit_c_aux(C[t].hashes[last],
+      getLeaf(seeds[t], last),
+      mpc_wd.aux_bits(t),
+      mpc_wd.aux_size_bytes_,
+      sig_data.mpc_pd_.salt_,
+      tr,
+      (uint16_t)last,
+      &paramset);
 
     //=========================================================================
-    // Simulate the online phase of the MPC
-    // tmp_shares just used internally - picnic version can be used directly
-#ifdef DEBUG_SIGNING
-    std::cout << "simulate the online phase of the MPC\n";
-#endif
-    shares_t *tmp_shares = allocateShares(paramset.stateSizeBits);
-    Shares_ptr tmp_shares_ptr(tmp_shares, freeShares);
-
-    int rv{ 0 };
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        rv = mpc_class.mpc_simulate_sign(tapes, mpc_wd, tmp_shares, t);
-        if (rv != 0) {
-            std::cerr << "MPC simulation failed, aborting signature\n";
-            return EXIT_FAILURE;
-        }
-    }
+    // Commit to the commitments and views
+    commit_h(ss.commitments2_.Ch.hashes[t], &C[t], &paramset);
+    mpc_class.commit_v_sign(ss.commitments2_, mpc_wd, t);
 
-#ifdef DEBUG_SIGNING
-    std::cout << magenta;
-    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::aux_bits);
-    std::cout << normal;
-    std::cout << blue;
-    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::inputs);
-    std::cout << normal;
-    std::cout << cyan;
-    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::mpc_inputs);
-    std::cout << normal;
-    std::cout << red;
-    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::outputs);
-    std::cout << normal;
-    std::cout << green;
-    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::msgs);
-    std::cout << normal;
-#endif
+    return EXIT_SUCCESS;
+}
 
-    //=========================================================================
-    // Commit to the commitments and views
-#ifdef DEBUG_SIGNING
-    std::cout << "commit to the commitments and views\n";
-#endif
-    Commitment_data2 commitments2;
-    if (!commitments2.is_initialised) {
-        std::cerr
-          << "Failed to initialise the data for commitments and views\n";
-        return EXIT_FAILURE;
-    }
+// Compute the challenge from the commitments, once all of the repetitions
+// have been simulated, and reveal the seeds and the Merkle tree information
+// that the verifier needs. S is either of the signing states.
+template<typename T, typename S>
+int compute_mpc_challenge(T &mpc_class, S &ss, uint8_t const *message_digest,
+  uint8_t const *nonce, Signature_data &sig_data) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
 
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        commit_h(commitments2.Ch.hashes[t], &C[t], &paramset);
-        mpc_class.commit_v_sign(commitments2, mpc_wd, t);
-    }
+    tree_t *iSeedsTree = ss.s_and_t_->iSeedsTree_;
+    Commitment_data2 &commitments2 = ss.commitments2_;
 
     //=========================================================================
     // Create a Merkle tree with Cv as the leaves
@@ -241,16 +306,7 @@ int generate_mpc_signature(T &mpc_class,
 #ifdef DEBUG_SIGNING
     std::cout << "compute the challenge hash\n";
 #endif
-    auto challengeHash =
-      static_cast<uint8_t *>(malloc(Mpc_parameters::challenge_hash_bytes_));
-    if (challengeHash == nullptr) {
-        std::cerr << "Unable to allocate memory for the challenge hash\n";
-        return EXIT_FAILURE;
-    }
-    // Ensure that challengeHash is freed
-    std::unique_ptr<uint8_t, decltype(&::free)> challenge_hash_ptr(
-      challengeHash, ::free);
-
+    uint8_t challengeHash[Mpc_parameters::challenge_hash_bytes_];
     mpc_class.calculate_hcp(
       challengeHash, sig_data, commitments2, message_digest, nonce);
 
@@ -273,50 +329,101 @@ int generate_mpc_signature(T &mpc_class,
 #endif
     size_t missingLeavesSize = paramset.numMPCRounds - paramset.numOpenedRounds;
     uint16_t *missingLeaves = getMissingLeavesList(challengeC, &paramset);
+    Mpc_proof_data &pd = sig_data.mpc_pd_;
     size_t cvInfoLen = 0;
     uint8_t *cvInfo = openMerkleTree(
       commitments2.treeCv, missingLeaves, missingLeavesSize, &cvInfoLen);
-    sig_data.mpc_pd_.cvInfo_ = cvInfo;
-    sig_data.mpc_pd_.cvInfoLen_ = cvInfoLen;
     free(missingLeaves);
+    if (cvInfo == nullptr) { return EXIT_FAILURE; }
 
     // Reveal iSeeds for unopened rounds, those in {0..T-1} \ ChallengeC.
-    sig_data.mpc_pd_.iSeedInfo_ = static_cast<uint8_t *>(
-      malloc(paramset.numMPCRounds * paramset.seedSizeBytes));
-    sig_data.mpc_pd_.iSeedInfoLen_ = revealSeeds(iSeedsTree,
+    size_t iSeedInfoLen = revealSeedsSize(
+      paramset.numMPCRounds, challengeC, paramset.numOpenedRounds, &paramset);
+    // picnic allocates cvInfo itself, copy it so that the buffers in the
+    // proof data can be reused
+    bool reserved = pd.reserve_info(iSeedInfoLen, cvInfoLen);
+    if (reserved) { memcpy(pd.cvInfo_, cvInfo, cvInfoLen); }
+    free(cvInfo);
+    if (!reserved) { return EXIT_FAILURE; }
+    pd.cvInfoLen_ = cvInfoLen;
+    pd.iSeedInfoLen_ = revealSeeds(iSeedsTree,
       challengeC,
       paramset.numOpenedRounds,
-      sig_data.mpc_pd_.iSeedInfo_,
-      paramset.numMPCRounds * paramset.seedSizeBytes,
+      pd.iSeedInfo_,
+      iSeedInfoLen,
       &paramset);
-    sig_data.mpc_pd_.iSeedInfo_ = static_cast<uint8_t *>(
-      realloc(sig_data.mpc_pd_.iSeedInfo_, sig_data.mpc_pd_.iSeedInfoLen_));
     //=========================================================================
+
+    return EXIT_SUCCESS;
+}
+
+// Compute the challenge and assemble the proofs, once all of the repetitions
+// have been simulated
+template<typename T>
+int complete_mpc_signature(T &mpc_class, Mpc_signing_state &ss,
+  uint8_t const *message_digest, uint8_t const *nonce,
+  Signature_data &sig_data) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    tree_t **seeds = ss.s_and_t_->seeds_;
+    Mpc_working_data &mpc_wd = ss.mpc_wd_;
+    commitments_t *C = ss.commitment_data1_.C_;
+
+#ifdef DEBUG_SIGNING
+    std::cout << magenta;
+    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::aux_bits);
+    std::cout << normal;
+    std::cout << blue;
+    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::inputs);
+    std::cout << normal;
+    std::cout << cyan;
+    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::mpc_inputs);
+    std::cout << normal;
+    std::cout << red;
+    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::outputs);
+    std::cout << normal;
+    std::cout << green;
+    mpc_wd.print_working_data(std::cout, mpc_wd_print_mask::msgs);
+    std::cout << normal;
+#endif
+
+    int ret =
+      compute_mpc_challenge(mpc_class, ss, message_digest, nonce, sig_data);
+    if (ret != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+    uint16_t *challengeC = sig_data.mpc_pd_.challengeC_;
+    uint16_t *challengeP = sig_data.mpc_pd_.challengeP_;
+
 #ifdef DEBUG_SIGNING
     std::cout << "assembling the proof\n" << std::flush;
 #endif
-    // Assemble the proof
+    // Assemble the proof, straight into the signature
+    if (sig_data.set_layout() != EXIT_SUCCESS) {
+        std::cerr << "Unable to allocate memory for the signature\n";
+        return EXIT_FAILURE;
+    }
     Proof2 **proofs = sig_data.proofs_;
     for (size_t t = 0; t < paramset.numMPCRounds; t++) {
         if (contains(challengeC, paramset.numOpenedRounds, t)) {
             //=================================================================
-            // Save proof data for this opened round - first allocate memory
-            proofs[t] = new Proof2(sig_data.proof_param_);
+            // Save proof data for this opened round - first find its place
+            if (sig_data.new_proof(t) == nullptr) {
+                std::cerr << "Unable to allocate memory for a proof\n";
+                return EXIT_FAILURE;
+            }
             int P_index = indexOf(challengeC, paramset.numOpenedRounds, t);
             //=================================================================
             // Include seed information for this opened round
             uint16_t hideList[1];
             hideList[0] = challengeP[P_index];
-            proofs[t]->seedInfo_ = static_cast<uint8_t *>(
-              malloc(paramset.numMPCParties * paramset.seedSizeBytes));
             proofs[t]->seedInfoLen_ = revealSeeds(seeds[t],
               hideList,
               1,
               proofs[t]->seedInfo_,
-              paramset.numMPCParties * paramset.seedSizeBytes,
+              proofs[t]->seedInfoLen_,
               &paramset);
-            proofs[t]->seedInfo_ = static_cast<uint8_t *>(
-              realloc(proofs[t]->seedInfo_, proofs[t]->seedInfoLen_));
             //=================================================================
             // Save the C hash
             memcpy(proofs[t]->C_,
@@ -326,7 +433,8 @@ int generate_mpc_signature(T &mpc_class,
             // Save the aux bits
             size_t last = paramset.numMPCParties - 1;
             if (challengeP[P_index] != last) {// Needs update for other cases
-                mpc_class.get_aux_bits(proofs[t]->aux_, tapes, t);
+                memcpy(proofs[t]->aux_, mpc_wd.aux_bits(t),
+                  sig_data.proof_param_.aux_size_bytes_);
             }
             //=================================================================
             // Save the other data needed for the verifier to check this opened
@@ -342,4 +450,447 @@ int generate_mpc_signature(T &mpc_class,
     return EXIT_SUCCESS;
 }
 
+// Generate a signature with the given signing state, taking the worker
+// scratch data from session
+template<typename T>
+int generate_mpc_signature(T &mpc_class,
+  uint8_t const *message_digest,
+  uint8_t const *nonce,
+  Signature_data &sig_data,
+  Mpc_signing_state &ss,
+  Mpc_session &session) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    //=========================================================================
+    // Set up the structures and offsets
+#ifdef DEBUG_SIGNING
+    std::cout << "set_offsets\n";
+#endif
+    Tape_offset next_offset = 0;
+
+    next_offset = mpc_class.set_offsets(next_offset);
+
+#ifdef DEBUG_SIGNING
+    std::cout << "Tape size bytes: " << (next_offset + 7U) / 8U << '\n';
+#endif
+
+    int ret = prepare_mpc_signature(
+      mpc_class, ss, nonce, sig_data, &session.seed_trees());
+    if (ret != EXIT_SUCCESS) { return EXIT_FAILURE; }
+    mpc_memory_phase(Mpc_phase::sign_prepare);
+
+    //=========================================================================
+    // The repetitions, one block of repetitions for each worker
+#ifdef DEBUG_SIGNING
+    std::cout << "preprocess, commit and simulate the repetitions\n";
+#endif
+    Mpc_thread_pool &pool = Mpc_thread_pool::instance();
+    Mpc_scratch_set *scratch = session.worker_scratch(pool.size(),
+      sig_data.proof_param_.aux_size_bytes_, mpc_class.max_step_bits(),
+      mpc_class.tape_window_bits());
+    if (scratch == nullptr) { return EXIT_FAILURE; }
+
+    pool.parallel_for(
+      paramset.numMPCRounds, [&](size_t begin, size_t end, size_t worker) {
+          for (size_t t = begin; t < end && ss.ok_; t++) {
+              if (sign_mpc_repetition(
+                    mpc_class, ss, sig_data, *(*scratch)[worker], t)
+                  != EXIT_SUCCESS) {
+                  ss.ok_ = false;
+              }
+          }
+      });
+    if (!ss.ok_) { return EXIT_FAILURE; }
+    mpc_memory_phase(Mpc_phase::sign_repetitions);
+
+    ret = complete_mpc_signature(
+      mpc_class, ss, message_digest, nonce, sig_data);
+    mpc_memory_phase(Mpc_phase::sign_proofs);
+    return ret;
+}
+
+// Generate a signature. If a session is given its memory is used (and it must
+// be reset once sig_data is no longer needed), otherwise the memory is only
+// kept for this signature.
+template<typename T>
+int generate_mpc_signature(T &mpc_class,
+  uint8_t const *message_digest,
+  uint8_t const *nonce,
+  Signature_data &sig_data,
+  Mpc_session *session = nullptr) noexcept
+{
+    Mpc_session local_session;
+    if (session == nullptr) { session = &local_session; }
+
+    Mpc_memory_estimate me = mpc_arena_estimate(sig_data.proof_param_, false);
+    if (!session->arena().reserve(me.sign_arena_bytes() + me.seeds_)) {
+        std::cerr << "Unable to allocate the signing state\n";
+        return EXIT_FAILURE;
+    }
+    Mpc_signing_state ss{ sig_data.proof_param_, &session->arena() };
+    return generate_mpc_signature(
+      mpc_class, message_digest, nonce, sig_data, ss, *session);
+}
+
+// Everything needed to generate signatures, one after the other, against one
+// SRL. The working data, commitments, signature data and worker scratch data
+// are allocated once for the SRL's parameters and then reused, so apart from
+// some small temporaries inside picnic's tree code nothing is allocated for
+// each signature. The seeds come from the session's arena, which is reset
+// for each signature. The last signature generated is held in
+// signature_data() until the next one is started.
+class Mpc_signer_context
+{
+  public:
+    Mpc_signer_context() = default;
+    explicit Mpc_signer_context(Mpc_param const &param) noexcept
+    {
+        reset(param);
+    }
+    Mpc_signer_context(Mpc_signer_context const &) = delete;
+    Mpc_signer_context &operator=(Mpc_signer_context const &) = delete;
+
+    // Ready the context for a signature with the given parameters. The
+    // buffers are only reallocated if the parameters (the SRL size) have
+    // changed. Returns false if they can't be allocated.
+    bool reset(Mpc_param const &param) noexcept
+    {
+        if (ss_ && sig_data_ && param == param_) {
+            ss_->reset();
+            sig_data_->reset();
+            session_.reset();
+            return is_initialised();
+        }
+        sig_data_.reset();
+        ss_.reset();
+        session_.reset();
+        arena_.release();
+        param_ = param;
+        if (!arena_.reserve(
+              mpc_arena_estimate(param_, false).sign_arena_bytes())) {
+            return false;
+        }
+        ss_.emplace(param_, &arena_, &session_.arena());
+        sig_data_.emplace(param_, &arena_);
+        return is_initialised();
+    }
+    bool is_initialised() const noexcept
+    {
+        return ss_ && sig_data_ && ss_->is_initialised()
+               && sig_data_->is_initialised_;
+    }
+
+    Mpc_param const &param() const noexcept { return param_; }
+    Signature_data &signature_data() noexcept { return *sig_data_; }
+    Mpc_signing_state &signing_state() noexcept { return *ss_; }
+    Mpc_session &session() noexcept { return session_; }
+
+  private:
+    Mpc_param param_{};
+    Mpc_arena arena_;// The data kept from one signature to the next
+    Mpc_session session_;// The seeds and the worker scratch data
+    std::optional<Mpc_signing_state> ss_;
+    std::optional<Signature_data> sig_data_;
+};
+
+// Generate a signature using a context, the signature is left in
+// ctx.signature_data()
+template<typename T>
+int generate_mpc_signature(T &mpc_class,
+  uint8_t const *message_digest,
+  uint8_t const *nonce,
+  Mpc_signer_context &ctx) noexcept
+{
+    if (!ctx.reset(T::mpc_param_)) {
+        std::cerr << "Unable to set up the signer context\n";
+        return EXIT_FAILURE;
+    }
+
+    return generate_mpc_signature(mpc_class, message_digest, nonce,
+      ctx.signature_data(), ctx.signing_state(), ctx.session());
+}
+
+// Simulate repetition t, committing to the aux bits and messages as they are
+// produced, so that nothing the size of the SRL is kept
+template<typename T>
+int commit_mpc_repetition(T &mpc_class, Mpc_streaming_signing_state &ss,
+  Mpc_worker_scratch &scratch, size_t t) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    tree_t **seeds = ss.s_and_t_->seeds_;
+    uint8_t *salt = ss.sig_data_.mpc_pd_.salt_;
+    commitments_t *C = ss.commitment_data1_.C_;
+    auto tr = static_cast<uint16_t>(t);
+    auto last = static_cast<uint16_t>(paramset.numMPCParties - 1);
+
+    Mpc_streaming_tapes &tapes = *scratch.tapes_;
+    tapes.start(getLeaves(seeds[t]), salt, t, &paramset);
+    Mpc_commitment_stream &stream = *scratch.commitment_stream_;
+    stream.start(getLeaf(seeds[t], last), &paramset);
+    int rv =
+      mpc_class.sign_repetition(tapes, stream, scratch.tmp_shares_.get());
+    if (rv != 0) {
+        std::cerr << "MPC simulation failed, aborting signature\n";
+        return EXIT_FAILURE;
+    }
+
+    //=========================================================================
+    // Commit to seeds and aux bits
+    for (uint16_t j = 0; j < last; j++) {
+        commit_c(
+          C[t].hashes[j], getLeaf(seeds[t], j), NULL, salt, tr, j, &paramset);
+    }
+    stream.finish_aux(C[t].hashes[last], salt, tr, last, &paramset);
+
+    //=========================================================================
+    // Commit to the commitments and views
+    commit_h(ss.commitments2_.Ch.hashes[t], &C[t], &paramset);
+    stream.finish_view(ss.commitments2_.Cv.hashes[t],
+      reinterpret_cast<uint8_t const *>(stream.mpc_input(0)), &paramset);
+
+    return EXIT_SUCCESS;
+}
+
+// Simulate the opened repetition t again, writing its proof straight into the
+// signature at the offsets given by the layout
+template<typename T>
+int write_mpc_proof(T &mpc_class, Mpc_streaming_signing_state &ss,
+  Signature_layout const &layout, uint8_t *signature,
+  Mpc_worker_scratch &scratch, size_t t) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    tree_t **seeds = ss.s_and_t_->seeds_;
+    commitments_t *C = ss.commitment_data1_.C_;
+    Mpc_proof_data const &pd = ss.sig_data_.mpc_pd_;
+    Mpc_param const &param = ss.sig_data_.proof_param_;
+    Proof_offsets const &po = layout.proofs_[t];
+
+    uint16_t hideList[1];
+    hideList[0] =
+      pd.challengeP_[indexOf(pd.challengeC_, paramset.numOpenedRounds, t)];
+    size_t seed_info_len = revealSeeds(seeds[t], hideList, 1,
+      signature + po.seed_info_, layout.seed_info_len_, &paramset);
+    if (seed_info_len != layout.seed_info_len_) {
+        std::cerr << "Unable to reveal the seeds for round " << t << '\n';
+        return EXIT_FAILURE;
+    }
+    memcpy(signature + po.C_, C[t].hashes[hideList[0]],
+      paramset.digestSizeBytes);
+    // The inputs are not set by the circuit (as for save_proof_data)
+    memset(signature + po.inputs_, 0, param.n_inputs_ * paramset.stateSizeBytes);
+
+    Mpc_streaming_tapes &tapes = *scratch.tapes_;
+    tapes.start(getLeaves(seeds[t]), pd.salt_, t, &paramset);
+    Mpc_proof_stream &stream = *scratch.proof_stream_;
+    stream.start(
+      Mpc_proof_destination{ po.has_aux_ ? signature + po.aux_ : nullptr,
+        signature + po.msgs_, hideList[0], signature + po.mpc_inputs_,
+        signature + po.outputs_ });
+    int rv =
+      mpc_class.sign_repetition(tapes, stream, scratch.tmp_shares_.get());
+    if (rv != 0) {
+        std::cerr << "MPC simulation failed, aborting signature\n";
+        return EXIT_FAILURE;
+    }
+    stream.finish();
+
+    return EXIT_SUCCESS;
+}
+
+// Generate a signature using memory that does not grow with the size of the
+// SRL (beyond the signature itself). The repetitions are simulated once to
+// compute the commitments and then, once the challenge is known, the opened
+// rounds are simulated again to write their proofs straight into signature.
+// Returns the length of the signature, or 0 on failure. A session is used as
+// for generate_mpc_signature.
+template<typename T>
+size_t generate_mpc_signature_streaming(T &mpc_class,
+  uint8_t const *message_digest, uint8_t const *nonce, uint8_t *signature,
+  size_t signature_len, Mpc_session *session = nullptr) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    mpc_class.set_offsets(0);
+
+    Mpc_session local_session;
+    if (session == nullptr) { session = &local_session; }
+
+    Mpc_memory_estimate me = mpc_arena_estimate(T::mpc_param_, true);
+    if (!session->arena().reserve(me.sign_arena_bytes() + me.seeds_)) {
+        std::cerr << "Unable to allocate the signing state\n";
+        return 0;
+    }
+    Mpc_streaming_signing_state ss{ T::mpc_param_, &session->arena() };
+    Signature_data &sig_data = ss.sig_data_;
+    int ret = prepare_mpc_signature(
+      mpc_class, ss, nonce, sig_data, &session->seed_trees());
+    if (ret != EXIT_SUCCESS) { return 0; }
+    mpc_memory_phase(Mpc_phase::sign_prepare);
+
+    Mpc_thread_pool &pool = Mpc_thread_pool::instance();
+    Mpc_scratch_set *scratch = session->worker_scratch(pool.size(),
+      sig_data.proof_param_.aux_size_bytes_, mpc_class.max_step_bits(),
+      mpc_class.tape_window_bits());
+    if (scratch == nullptr) { return 0; }
+
+    //=========================================================================
+    // The commitments for all of the repetitions
+    pool.parallel_for(
+      paramset.numMPCRounds, [&](size_t begin, size_t end, size_t worker) {
+          for (size_t t = begin; t < end && ss.ok_; t++) {
+              if (commit_mpc_repetition(
+                    mpc_class, ss, *(*scratch)[worker], t)
+                  != EXIT_SUCCESS) {
+                  ss.ok_ = false;
+              }
+          }
+      });
+    if (!ss.ok_) { return 0; }
+    mpc_memory_phase(Mpc_phase::sign_repetitions);
+
+    ret = compute_mpc_challenge(mpc_class, ss, message_digest, nonce, sig_data);
+    if (ret != EXIT_SUCCESS) { return 0; }
+
+    //=========================================================================
+    // Write the signature, the proofs of the opened rounds are independent
+    Mpc_proof_data const &pd = sig_data.mpc_pd_;
+    Signature_layout layout;
+    layout.set(pd, sig_data.proof_param_);
+    if (signature_len < layout.size_) {
+        std::cerr << "generate_mpc_signature_streaming: buffer provided is too "
+                     "small\n";
+        return 0;
+    }
+    memcpy(signature, pd.challengeHash_, Mpc_parameters::challenge_hash_bytes_);
+    memcpy(signature + Mpc_parameters::challenge_hash_bytes_, pd.salt_,
+      paramset.saltSizeBytes);
+    memcpy(signature + layout.iSeedInfo_, pd.iSeedInfo_, pd.iSeedInfoLen_);
+    memcpy(signature + layout.cvInfo_, pd.cvInfo_, pd.cvInfoLen_);
+
+    pool.parallel_for(
+      paramset.numOpenedRounds, [&](size_t begin, size_t end, size_t worker) {
+          for (size_t i = begin; i < end && ss.ok_; i++) {
+              if (write_mpc_proof(mpc_class, ss, layout, signature,
+                    *(*scratch)[worker], pd.challengeC_[i])
+                  != EXIT_SUCCESS) {
+                  ss.ok_ = false;
+              }
+          }
+      });
+    if (!ss.ok_) { return 0; }
+    mpc_memory_phase(Mpc_phase::sign_proofs);
+
+    return layout.size_;
+}
+
+// One message in a batch to be signed against a shared SRL. Each item has its
+// own mpc class object (holding the per-signature values) and signature data,
+// but they must all be for the same list.
+template<typename T> struct Mpc_sign_item
+{
+    T *mpc_class_{ nullptr };
+    uint8_t const *message_digest_{ nullptr };
+    uint8_t const *nonce_{ nullptr };
+    Signature_data *sig_data_{ nullptr };
+};
+
+// Sign a batch of messages. The offsets are computed once, the working data,
+// commitment data and per-worker scratch data are allocated once and reused,
+// and the repetitions of all of the signatures in flight are run on the one
+// pool. At most max_in_flight signatures (each needing a full set of working
+// data) are processed together, 0 selects the default of 2.
+// Returns EXIT_SUCCESS or EXIT_FAILURE for each item.
+template<typename T>
+std::vector<int> generate_mpc_signature_batch(
+  std::vector<Mpc_sign_item<T>> const &items, size_t max_in_flight = 0) noexcept
+{
+    size_t n_sigs = items.size();
+    std::vector<int> results(n_sigs, EXIT_FAILURE);
+    if (n_sigs == 0) { return results; }
+
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    //=========================================================================
+    // The offsets only depend on the SRL
+    Tape_offset next_offset = items[0].mpc_class_->set_offsets(0);
+    for (size_t k = 1; k < n_sigs; ++k) {
+        if (items[k].mpc_class_->set_offsets(0) != next_offset) {
+            std::cerr << "generate_mpc_signature_batch: item " << k
+                      << " is not for the same SRL\n";
+            return results;
+        }
+    }
+
+    size_t n_states = std::min(
+      n_sigs, (max_in_flight == 0) ? static_cast<size_t>(2) : max_in_flight);
+    std::vector<std::unique_ptr<Mpc_signing_state>> states(n_states);
+    for (auto &ss : states) {
+        ss = std::make_unique<Mpc_signing_state>(
+          items[0].sig_data_->proof_param_);
+    }
+
+    Mpc_thread_pool &pool = Mpc_thread_pool::instance();
+    Mpc_scratch_set scratch;
+    if (!allocate_worker_scratch(scratch, pool.size(),
+          items[0].sig_data_->proof_param_.aux_size_bytes_,
+          items[0].mpc_class_->max_step_bits(),
+          items[0].mpc_class_->tape_window_bits())) {
+        return results;
+    }
+
+    size_t n_rounds = paramset.numMPCRounds;
+    for (size_t first = 0; first < n_sigs; first += n_states) {
+        size_t n_wave = std::min(n_states, n_sigs - first);
+        for (size_t j = 0; j < n_wave; ++j) { states[j]->reset(); }
+
+        pool.parallel_for(n_wave,
+          [&](size_t begin, size_t end, [[maybe_unused]] size_t worker) {
+              for (size_t j = begin; j < end; ++j) {
+                  Mpc_sign_item<T> const &item = items[first + j];
+                  if (prepare_mpc_signature(*item.mpc_class_, *states[j],
+                        item.nonce_, *item.sig_data_)
+                      != EXIT_SUCCESS) {
+                      states[j]->ok_ = false;
+                  }
+              }
+          });
+
+        pool.parallel_for(
+          n_wave * n_rounds, [&](size_t begin, size_t end, size_t worker) {
+              for (size_t i = begin; i < end; ++i) {
+                  size_t j = i / n_rounds;
+                  Mpc_signing_state &ss = *states[j];
+                  if (!ss.ok_) { continue; }
+                  Mpc_sign_item<T> const &item = items[first + j];
+                  if (sign_mpc_repetition(*item.mpc_class_, ss,
+                        *item.sig_data_, *scratch[worker], i % n_rounds)
+                      != EXIT_SUCCESS) {
+                      ss.ok_ = false;
+                  }
+              }
+          });
+
+        pool.parallel_for(n_wave,
+          [&](size_t begin, size_t end, [[maybe_unused]] size_t worker) {
+              for (size_t j = begin; j < end; ++j) {
+                  if (!states[j]->ok_) { continue; }
+                  Mpc_sign_item<T> const &item = items[first + j];
+                  results[first + j] = complete_mpc_signature(
+                    *item.mpc_class_, *states[j], item.message_digest_,
+                    item.nonce_, *item.sig_data_);
+              }
+          });
+    }
+
+    return results;
+}
+
 #endif
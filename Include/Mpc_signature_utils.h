@@ -51,13 +51,22 @@ extern "C" {
 #include "lowmc_constants.h"
 }
 #include "Mpc_parameters.h"
+#include "Mpc_arena.h"
 
+// If an arena is given, the proof data, the proofs and the signature data
+// are allocated from it and are not freed individually
 class Mpc_proof_data
 {
   public:
-    Mpc_proof_data() noexcept;
+    explicit Mpc_proof_data(Mpc_arena *arena = nullptr) noexcept;
+    Mpc_proof_data(Mpc_proof_data const &) = delete;
+    Mpc_proof_data &operator=(Mpc_proof_data const &) = delete;
     ~Mpc_proof_data();
 
+    // Make sure iSeedInfo_ and cvInfo_ can hold the given number of bytes.
+    // The buffers are kept, and only grow, when the proof data is reused.
+    bool reserve_info(size_t iSeedInfoLen, size_t cvInfoLen) noexcept;
+
     bool is_initialised_{ false };
     uint8_t *salt_;
     uint8_t *iSeedInfo_{
@@ -70,14 +79,71 @@ class Mpc_proof_data
     uint8_t *challengeHash_{ nullptr };
     uint16_t *challengeC_{ nullptr };
     uint16_t *challengeP_{ nullptr };
+    Mpc_arena *arena_{ nullptr };// For iSeedInfo_ and cvInfo_
+
+  private:
+    size_t iSeedInfoCapacity_{ 0 };
+    size_t cvInfoCapacity_{ 0 };
+};
+
+// A read-only view of the proof for one opened round in a serialised
+// signature, either one received or the one being built by Signature_data.
+// The inputs, MPC inputs and outputs are each consecutive states (which need
+// not be aligned).
+struct Mpc_proof_view
+{
+    uint8_t const *input(size_t i) const noexcept
+    {
+        return inputs_ + i * Mpc_parameters::lowmc_state_bytes_;
+    }
+    uint8_t const *mpc_input(size_t i) const noexcept
+    {
+        return mpc_inputs_ + i * Mpc_parameters::lowmc_state_bytes_;
+    }
+    uint8_t const *output(size_t i) const noexcept
+    {
+        return outputs_ + i * Mpc_parameters::lowmc_state_bytes_;
+    }
+
+    uint8_t const *seed_info_{ nullptr };
+    size_t seed_info_len_{ 0 };
+    uint8_t const *aux_{ nullptr };// nullptr if P[t] == N-1
+    uint8_t const *msgs_{ nullptr };
+    uint8_t const *inputs_{ nullptr };
+    uint8_t const *mpc_inputs_{ nullptr };
+    uint8_t const *outputs_{ nullptr };
+    uint8_t const *C_{ nullptr };
+};
+
+// Where the fields of the proof for one opened round are in a serialised
+// signature, as offsets from its start
+struct Proof_offsets
+{
+    size_t seed_info_{ 0 };
+    bool has_aux_{ false };// The aux bits are omitted if P[t] == N-1
+    size_t aux_{ 0 };
+    size_t msgs_{ 0 };
+    size_t inputs_{ 0 };
+    size_t mpc_inputs_{ 0 };
+    size_t outputs_{ 0 };
+    size_t C_{ 0 };
 };
 
+// The proof for one opened round. The proof does not hold any data itself,
+// its fields point to where they go in the signature being built (or read)
+// by Signature_data.
 class Proof2// Derived from picnic proof2_t
 {
   public:
     Proof2() = delete;
-    Proof2(Mpc_param const &param);
-    ~Proof2();
+    explicit Proof2(Mpc_param const &param);
+    Proof2(Proof2 const &) = delete;
+    Proof2 &operator=(Proof2 const &) = delete;
+
+    // Point the fields at the proof's place in a serialised signature
+    void bind(uint8_t *signature, Proof_offsets const &po,
+      size_t seed_info_len) noexcept;
+    Mpc_proof_view view(bool with_aux) const noexcept;
 
     bool is_initialised_{ false };
     uint8_t *seedInfo_{ nullptr };// Information required to compute the tree
@@ -94,6 +160,8 @@ class Proof2// Derived from picnic proof2_t
       mpc_inputs_;// MPC inputs for LowMC used in online execution
     std::vector<uint8_t *> outputs_;// Outputs from the online
                                     // execution needed for checking
+  private:
+    uint8_t *states_{ nullptr };// The inputs, mpc_inputs and outputs
 };
 
 enum signature_data_print_mask : uint8_t {
@@ -106,28 +174,82 @@ enum signature_data_print_mask : uint8_t {
     proofs_outputs = 64,
 };
 
+// The layout of a serialised signature. This is fixed by the challenge,
+// which sets the sizes of the seed and Merkle tree information and which of
+// the proofs have aux bits.
+class Signature_layout
+{
+  public:
+    // The challenge lists and the iSeedInfo and cvInfo lengths must be set
+    void set(Mpc_proof_data const &pd, Mpc_param const &param) noexcept;
+    Mpc_proof_view proof_view(
+      uint8_t const *signature, size_t t) const noexcept;
+
+    size_t size_{ 0 };// The size of the whole signature
+    size_t iSeedInfo_{ 0 };
+    size_t cvInfo_{ 0 };
+    size_t seed_info_len_{ 0 };// The same for each proof
+    std::vector<Proof_offsets> proofs_;// Indexed by round, only the opened
+                                       // rounds are set
+};
+
 class Signature_data
 {
   public:
     Signature_data() = delete;
-    Signature_data(Mpc_param const &param) noexcept;
-    size_t signature_size() const noexcept;
+    Signature_data(Mpc_param const &param, Mpc_arena *arena = nullptr) noexcept;
+    Signature_data(Signature_data const &) = delete;
+    Signature_data &operator=(Signature_data const &) = delete;
+    // The signature is built in place, in a single slab laid out as it is
+    // serialised, so once it is complete signature() can be handed on as it
+    // is. serialise_signature just copies the slab.
+    size_t signature_size() const noexcept { return layout_.size_; }
+    uint8_t const *signature() const noexcept { return wire_; }
+    Signature_layout const &layout() const noexcept { return layout_; }
     size_t serialise_signature(
       uint8_t *signature, size_t signature_len) const noexcept;
+    // Copy a signature into the slab, after checking it as for
+    // deserialise_signature_header
     int deserialise_signature(
       const uint8_t *signature, size_t signature_len) noexcept;
+    // Read and check everything but the proofs, which are left in place in
+    // the signature at the offsets given by layout
+    int deserialise_signature_header(const uint8_t *signature,
+      size_t signature_len, Signature_layout &layout) noexcept;
     ~Signature_data();
 
     void print_signature_data(
       std::ostream &os, signature_data_print_mask) const;
+    // Fix the layout once the challenge and the seed and Merkle tree
+    // information are known, make room for the signature in the slab and
+    // write the challenge, salt and tree information to it
+    int set_layout() noexcept;
+    // The proof for round t, bound to its place in the slab (so set_layout
+    // must have been called). Returns nullptr on failure.
+    Proof2 *new_proof(size_t t) noexcept;
+    // Ready the signature data for another signature. The proofs are kept
+    // and handed out again by new_proof.
+    void reset() noexcept;
 
     bool is_initialised_{ false };
     Mpc_proof_data mpc_pd_;
     Mpc_param proof_param_{};
     Proof2 **proofs_{ nullptr };
+
+  private:
+    void delete_proof(Proof2 *proof) noexcept;
+
+    std::vector<Proof2 *> spare_proofs_;
+    Signature_layout layout_;
+    uint8_t *wire_{ nullptr };// The slab holding the serialised signature
+    size_t wire_capacity_{ 0 };
+    Mpc_arena *arena_{ nullptr };
 };
 
 size_t signature_size_estimate(
   Mpc_param const &proof_param, paramset_t const &paramset);
+// The most seeds (for iSeedInfo) or digests (for cvInfo) that a signature
+// can reveal, as allowed for by signature_size_estimate
+size_t max_tree_values(paramset_t const &paramset) noexcept;
 
 #endif
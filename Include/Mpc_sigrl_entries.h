@@ -61,6 +61,16 @@ extern "C" {
 Epid_arl_entry calculate_epid_arl_entry(Lowmc_state_words64_const_ptr r,
   Lowmc_state_words64_const_ptr sku, Epid_sigrl_entry const &srl,
   paramset_t *params) noexcept;
+// The same, writing the entry in place (for example into a list that has
+// already been sized)
+void calculate_epid_arl_entry(Epid_arl_entry &arl_entry,
+  Lowmc_state_words64_const_ptr r, Lowmc_state_words64_const_ptr sku,
+  Epid_sigrl_entry const &srl, paramset_t *params) noexcept;
+// Calculate the entries for the SRL entries arl does not yet cover, so once a
+// delta has been applied to the SRL only its new entries are calculated
+void extend_epid_arl(Epid_a_rl &arl, Lowmc_state_words64_const_ptr r,
+  Lowmc_state_words64_const_ptr sku, Sigrl_view srl,
+  paramset_t *params) noexcept;
 
 class Mpc_sigrl_entry
 {
@@ -81,7 +91,7 @@ class Mpc_sigrl_entry
     void get_aux_bits(
       uint8_t *output, uint32_t &pos, randomTape_t *tapes) const noexcept;
     void set_aux_bits(
-      randomTape_t *tapes, uint32_t &pos, uint8_t *input) const noexcept;
+      randomTape_t *tapes, uint32_t &pos, uint8_t const *input) const noexcept;
 
     constexpr static Tape_offset local_offset_bits_ =
       Mpc_parameters::lowmc_state_bits_;// For the intermediate mask
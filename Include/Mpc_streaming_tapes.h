@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * File:        Mpc_streaming_tapes.h
+ * Description: Random tapes for one repetition that are squeezed a window
+ *              at a time, as the circuit works through the tape
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_STREAMING_TAPES_H
+#define MPC_STREAMING_TAPES_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "picnic.h"
+extern "C" {
+#include "picnic_types.h"
+#include "picnic3_impl.h"
+#include "kdf_shake.h"
+}
+
+#include "Mpc_parameters.h"
+
+// The random tapes for the parties of one repetition. Rather than squeezing
+// the whole tape up front, the SHAKE x4 states are kept and a window of the
+// tape is squeezed when it is needed. The tapes are only ever moved forward,
+// so the memory needed is set by the largest window (one SRL entry) rather
+// than by the size of the SRL.
+//
+// Within a window the tapes can be read in any order and written to (the aux
+// bits), the changes are kept until the window moves past them. The positions
+// on the returned tapes are relative to window_offset().
+class Mpc_streaming_tapes
+{
+  public:
+    Mpc_streaming_tapes() = delete;
+    // max_window_bits is the largest window that will be asked for
+    explicit Mpc_streaming_tapes(Tape_offset max_window_bits) noexcept;
+    Mpc_streaming_tapes(Mpc_streaming_tapes const &) = delete;
+    Mpc_streaming_tapes &operator=(Mpc_streaming_tapes const &) = delete;
+    ~Mpc_streaming_tapes();
+
+    // Set up the tapes for repetition t, nothing is squeezed until the first
+    // window is asked for
+    void start(uint8_t **seeds, uint8_t const *salt, size_t t,
+      paramset_t *params) noexcept;
+
+    // The tape of this party reads as zeros (the unopened party when
+    // verifying). Cleared by start.
+    void hide_party(size_t party) noexcept { hidden_party_ = party; }
+
+    // Make bits [begin, end) of the tapes available. begin must not be before
+    // the start of the previous window.
+    randomTape_t *window(Tape_offset begin, Tape_offset end) noexcept;
+
+    // The tape offset of bit 0 of the current window
+    Tape_offset window_offset() const noexcept
+    {
+        return static_cast<Tape_offset>(window_start_ * 8U);
+    }
+
+    bool is_initialised_{ false };
+
+  private:
+    void squeeze(size_t to, size_t n_bytes) noexcept;
+
+    static constexpr size_t n_contexts_ = Mpc_parameters::mpc_parties_ / 4;
+    static constexpr size_t no_party_ = SIZE_MAX;
+
+    // hash_context_x4 is over-aligned, so can't be used directly in an array
+    struct alignas(32) X4_context
+    {
+        hash_context_x4 ctx_;
+    };
+    X4_context ctx_[n_contexts_];
+    size_t capacity_{ 0 };// Bytes per party
+    uint8_t *slab_{ nullptr };
+    uint8_t *tape_ptrs_[Mpc_parameters::mpc_parties_]{};
+    randomTape_t tape_{};
+    size_t window_start_{ 0 };// Tape byte at the start of the window
+    size_t squeezed_{ 0 };// Tape bytes squeezed so far
+    size_t hidden_party_{ no_party_ };
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * File:        Mpc_thread_pool.h
+ * Description: A small pool of worker threads used to split the per-repetition
+ *              work of the MPC proofs into blocks
+ *
+ * Author:      agent
+ *
+ * Created:     Monday 19 October 2026
+ *
+ *
+*******************************************************************************/
+
+/*******************************************************************************
+*                                                                              *
+* (C) Copyright 2026 University of Surrey                                      *
+*                                                                              *
+* Redistribution and use in source and binary forms, with or without           *
+* modification, are permitted provided that the following conditions are met:  *
+*                                                                              *
+* 1. Redistributions of source code must retain the above copyright notice,    *
+* this list of conditions and the following disclaimer.                        *
+*                                                                              *
+* 2. Redistributions in binary form must reproduce the above copyright notice, *
+* this list of conditions and the following disclaimer in the documentation    *
+* and/or other materials provided with the distribution.                       *
+*                                                                              *
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"  *
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE    *
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE   *
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE    *
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR          *
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF         *
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS     *
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN      *
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)      *
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE   *
+* POSSIBILITY OF SUCH DAMAGE.                                                  *
+*                                                                              *
+*******************************************************************************/
+
+#ifndef MPC_THREAD_POOL_H
+#define MPC_THREAD_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <iostream>
+
+// The number of threads to use for the MPC work. Set by the environment
+// variable HBGS_THREADS if present, otherwise the hardware concurrency.
+size_t mpc_thread_count() noexcept;
+
+// The CPUs the workers are pinned to, from the environment variable HBGS_CPUS
+// (a list such as "0-3,8-11"). Empty if not set, in which case the threads are
+// not pinned and the scheduler is free to move them.
+std::vector<int> mpc_cpu_list() noexcept;
+
+// The NUMA node of the given CPU, or -1 if it is not known
+int mpc_cpu_node(int cpu) noexcept;
+
+class Mpc_thread_pool
+{
+  public:
+    // Called with a half-open range of items [begin, end) and the index of the
+    // worker running it, the index is in [0, size()) and can be used to select
+    // per-worker scratch data. It only refers to the callable (which must
+    // outlive the parallel_for), so passing a lambda does not allocate.
+    class Block_function
+    {
+      public:
+        template<typename F>
+        Block_function(F const &fn) noexcept// Implicit, to take a lambda
+          : fn_(&fn), call_([](void const *fn, size_t begin, size_t end,
+                              size_t worker) {
+                (*static_cast<F const *>(fn))(begin, end, worker);
+            })
+        {}
+        void operator()(size_t begin, size_t end, size_t worker) const
+        {
+            call_(fn_, begin, end, worker);
+        }
+
+      private:
+        void const *fn_;
+        void (*call_)(void const *, size_t, size_t, size_t);
+    };
+
+    Mpc_thread_pool() = delete;
+    explicit Mpc_thread_pool(size_t n_threads) noexcept;
+    // Worker w is pinned to cpus[w % cpus.size()], the caller only while it
+    // runs block 0
+    Mpc_thread_pool(size_t n_threads, std::vector<int> cpus) noexcept;
+    Mpc_thread_pool(Mpc_thread_pool const &) = delete;
+    Mpc_thread_pool &operator=(Mpc_thread_pool const &) = delete;
+    ~Mpc_thread_pool();
+
+    // The number of workers, including the calling thread
+    size_t size() const noexcept { return workers_.size() + 1; }
+
+    // Split n_items into one contiguous block per worker and wait for them all
+    // to complete. Calls made from inside a block run serially on that worker.
+    void parallel_for(size_t n_items, Block_function const &fn) noexcept;
+
+    // The CPU worker w is pinned to, or -1 if the workers are not pinned
+    int worker_cpu(size_t worker) const noexcept;
+
+    // One line per worker giving its CPU and NUMA node
+    void print_placement(std::ostream &os) const;
+
+    // The pool shared by the sign and verify code, sized by mpc_thread_count()
+    // and pinned to mpc_cpu_list()
+    static Mpc_thread_pool &instance() noexcept;
+
+  private:
+    void worker_loop(size_t worker) noexcept;
+    void run_block(size_t worker) noexcept;
+    void pin_current_thread(size_t worker) const noexcept;
+
+    std::vector<std::thread> workers_;
+    std::vector<int> cpus_;
+
+    std::mutex run_mutex_;// Only one parallel_for at a time
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    Block_function const *job_{ nullptr };
+    size_t n_items_{ 0 };
+    uint64_t generation_{ 0 };
+    size_t n_running_{ 0 };
+    bool stopping_{ false };
+};
+
+#endif
@@ -53,6 +53,7 @@ extern "C" {
 
 #include "Mpc_parameters.h"
 #include "Lowmc64.h"
+#include "Mpc_arena.h"
 
 picnic_params_t get_picnic_parameter_set_id();
 
@@ -76,6 +77,10 @@ void print_random_tapes(
 
 void allocate_random_tapes(randomTape_t *tape, size_t tape_size_bytes);
 
+// Use this rather than picnic's freeRandomTape, the tapes are allocated with
+// allocate_slab
+void free_random_tapes(randomTape_t *tape);
+
 void create_random_tapes(randomTape_t *tapes,
   uint8_t **seeds,
   uint8_t *salt,
@@ -97,11 +102,10 @@ void get_mask_from_tapes(
 void get_mask_from_tapes(
   Word *mask, randomTape_t *tapes, uint32_t offset, paramset_t *params);
 
-msgs_t *allocate_msgs(size_t msgs_size);
-
-void free_msgs(msgs_t *msgs);
+// The messages for every round, from the arena if one is given
+msgs_t *allocate_msgs(size_t msgs_size, Mpc_arena *arena = nullptr);
 
-using Msgs_ptr = std::unique_ptr<msgs_t, decltype(&::free_msgs)>;
+void free_msgs(msgs_t *msgs, Mpc_arena *arena = nullptr);
 
 void calculate_challenge_lists(uint8_t *challengeHash, uint16_t *challengeC,
   uint16_t *challengeP, paramset_t *params);
@@ -44,6 +44,9 @@
 #include <cinttypes>
 #include <cstring>
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <optional>
 #include <exception>
 #include <iostream>
 #include <string>
@@ -59,196 +62,245 @@ extern "C" {
 #include "Mpc_working_data.h"
 #include "Mpc_signature_utils.h"
 #include "Mpc_seeds_and_tapes.h"
+#include "Mpc_thread_pool.h"
+#include "Mpc_repetition_stream.h"
+#include "Mpc_footprint.h"
 
 //#define DEBUG_VERIFY
 
-template<typename MC, typename STATE_PTR>
-int verify_mpc_signature(MC &mpc_class,
-  const uint8_t *signature,
-  size_t signature_len,
-  uint8_t const *message_digest,
-  uint8_t const *nonce,
-  STATE_PTR expected_output_ptr) noexcept
+// The data for one signature while it is being verified. Each repetition only
+// touches its own entries, so repetitions can be checked concurrently.
+//
+// If in_place is set the proofs are read where they are in the signature,
+// rather than being copied, and the signature must be kept until the
+// verification is complete. If an arena is given everything is allocated
+// from it. With a separate signature_arena the seeds come from that instead,
+// and after reset() the rest can be reused for another signature.
+class Mpc_verification_state
 {
-    Signature_data sig_data{ MC::mpc_param_ };
+  public:
+    Mpc_verification_state() = delete;
+    Mpc_verification_state(Mpc_param const &param, bool in_place = false,
+      Mpc_arena *arena = nullptr) noexcept
+      : Mpc_verification_state(param, in_place, arena, arena)
+    {}
+    Mpc_verification_state(Mpc_param const &param, bool in_place,
+      Mpc_arena *arena, Mpc_arena *signature_arena) noexcept
+      : sig_data_{ param, arena }, commitment_data1_{ arena },
+        commitments2_{ arena }, in_place_(in_place), arena_(signature_arena)
+    {}
+    Mpc_verification_state(Mpc_verification_state const &) = delete;
+    Mpc_verification_state &operator=(Mpc_verification_state const &) = delete;
+
+    // Ready the state for another signature. The seeds must be reallocated,
+    // so the signature arena should be reset after this.
+    void reset() noexcept
+    {
+        s_and_t_.reset();
+        sig_data_.reset();
+        commitments2_.reset();
+        ok_ = true;
+    }
+
+    Signature_data sig_data_;
+    std::optional<Verification_seeds_and_tapes> s_and_t_;
+    Commitment_data1 commitment_data1_;
+    Commitment_data2 commitments2_;
+    bool in_place_{ false };
+    Signature_layout layout_;
+    std::vector<Mpc_proof_view> proofs_;// Indexed by round, opened rounds only
+    std::atomic<bool> ok_{ true };// Cleared as soon as any check fails
+    Mpc_arena *arena_{ nullptr };// For the seeds
+};
+
+// Deserialise the signature and set up the seeds and commitment data. If
+// seed_trees is given the party seed trees are taken from it.
+inline int prepare_mpc_verification(Mpc_verification_state &vs,
+  const uint8_t *signature, size_t signature_len,
+  Mpc_tree_pool *seed_trees = nullptr) noexcept
+{
+    Signature_data &sig_data = vs.sig_data_;
     if (!sig_data.is_initialised_) {
         std::cerr << "Failed to initialise the signature data\n";
+        return EXIT_FAILURE;
     }
 
-    int ret = sig_data.deserialise_signature(signature, signature_len);
+    int ret = vs.in_place_ ? sig_data.deserialise_signature_header(
+                signature, signature_len, vs.layout_)
+                           : sig_data.deserialise_signature(
+                             signature, signature_len);
     if (ret != EXIT_SUCCESS) {
         std::cerr << "Failed to deserialize signature\n";
         return EXIT_FAILURE;
     }
+
     paramset_t paramset;
     get_param_set(get_picnic_parameter_set_id(), &paramset);
+    vs.proofs_.assign(paramset.numMPCRounds, Mpc_proof_view{});
+    for (size_t i = 0; i < paramset.numOpenedRounds; ++i) {
+        size_t t = sig_data.mpc_pd_.challengeC_[i];
+        vs.proofs_[t] = vs.in_place_ ? vs.layout_.proof_view(signature, t)
+                                     : sig_data.layout().proof_view(
+                                       sig_data.signature(), t);
+    }
 
 #ifdef DEBUG_VERIFY
-    sig_data.print_signature_data(
-      std::cout, signature_data_print_mask::proofs_inputs);
-    sig_data.print_signature_data(
-      std::cout, signature_data_print_mask::proofs_mpc_inputs);
-    sig_data.print_signature_data(
-      std::cout, signature_data_print_mask::proofs_outputs);
-    sig_data.print_signature_data(
-      std::cout, signature_data_print_mask::proofs_aux);
-    sig_data.print_signature_data(
-      std::cout, signature_data_print_mask::proofs_msgs);
-    std::cout << '\n';
+    if (!vs.in_place_) {
+        sig_data.print_signature_data(
+          std::cout, signature_data_print_mask::proofs_inputs);
+        sig_data.print_signature_data(
+          std::cout, signature_data_print_mask::proofs_mpc_inputs);
+        sig_data.print_signature_data(
+          std::cout, signature_data_print_mask::proofs_outputs);
+        sig_data.print_signature_data(
+          std::cout, signature_data_print_mask::proofs_aux);
+        sig_data.print_signature_data(
+          std::cout, signature_data_print_mask::proofs_msgs);
+        std::cout << '\n';
+    }
 #endif
 
-
     //=========================================================================
-    // Set up the structures and offsets
-    Tape_offset next_offset = 0;
-
-    next_offset = mpc_class.set_offsets(next_offset);
-
-    size_t tape_size_bytes = (next_offset + 7U) / 8U;
+    // Set up the seeds
+    vs.s_and_t_.emplace(sig_data.mpc_pd_, vs.proofs_, vs.arena_, seed_trees);
+    if (!vs.s_and_t_->is_initialised_) {
+        std::cerr << "Unable to intialise the seeds\n";
+        return EXIT_FAILURE;
+    }
 
-    //=========================================================================
-    // Set up the tapes and seeds
+    if (!vs.commitment_data1_.is_initialised) {
+        std::cerr << "Unable to setup the initial commitment data\n";
+        return EXIT_FAILURE;
+    }
 
-    Verification_seeds_and_tapes s_and_t(tape_size_bytes, sig_data);
-    if (!s_and_t.is_initialised_) {
-        std::cerr << "Unable to intialise the tapes and seeds\n";
+    if (!vs.commitments2_.is_initialised) {
+        std::cerr
+          << "Failed to initialise the data for commitments and views\n ";
         return EXIT_FAILURE;
     }
 
-    randomTape_t *tapes = s_and_t.tapes_;
-    tree_t **seeds = s_and_t.seeds_;
+    return EXIT_SUCCESS;
+}
+
+// Recompute the commitments for repetition t and, for the opened repetitions,
+// simulate the MPC and check the outputs
+template<typename MC, typename STATE>
+int verify_mpc_repetition(MC &mpc_class, Mpc_verification_state &vs,
+  STATE const &expected_output, Mpc_worker_scratch &scratch,
+  size_t t) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    Signature_data const &sig_data = vs.sig_data_;
+    Mpc_streaming_tapes &tapes = *scratch.tapes_;
+    Mpc_commitment_stream &stream = *scratch.commitment_stream_;
+    tree_t **seeds = vs.s_and_t_->seeds_;
+    commitments_t *C = vs.commitment_data1_.C_;
+    Commitment_data2 &commitments2 = vs.commitments2_;
+    uint8_t *salt = sig_data.mpc_pd_.salt_;
+    auto tr = static_cast<uint16_t>(t);
+
+    auto last = static_cast<uint16_t>(paramset.numMPCParties - 1U);
+    bool opened = contains(
+      sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t);
+
+    // Compute random tapes for all parties. One party for each repetition in
+    // challengeC will have a bogus seed; but that party's tape is hidden.
+    tapes.start(getLeaves(seeds[t]), salt, t, &paramset);
 
     //=========================================================================
     // Calculate committed values for comparison
-    Commitment_data1 commitment_data1;
-    if (!commitment_data1.is_initialised) {
-        std::cerr << "Unable to setup the initial commitment data\n";
-        return EXIT_FAILURE;
-    }
-    commitments_t *C = commitment_data1.C_;
+    if (!opened) {
+        //=====================================================================
+        // We're given iSeed, have expanded the seeds, compute aux
+        // from scratch so we can compute Com[t]
+        for (uint16_t j = 0; j < last; j++) {
+            commit_c(
+              C[t].hashes[j], getLeaf(seeds[t], j), nullptr, salt, tr, j,
+              &paramset);
+        }
+        stream.start(getLeaf(seeds[t], last), &paramset);
+        mpc_class.compute_aux_bits_verify(tapes, stream);
+        stream.finish_aux(C[t].hashes[last], salt, tr, last, &paramset);
 
-    uint32_t last = paramset.numMPCParties - 1U;
-    auto auxBits =
-      static_cast<uint8_t *>(calloc(sig_data.proof_param_.aux_size_bytes_, 1));
-    if (auxBits == nullptr) {
-        std::cerr << "Unable to allocate memory for the aux bits\n";
-        return EXIT_FAILURE;
+        //=====================================================================
+        // Commit to the commitments, there is no view to commit to
+        commit_h(commitments2.Ch.hashes[t], &C[t], &paramset);
+        commitments2.Cv.hashes[t] = NULL;
+        return EXIT_SUCCESS;
     }
-    // Ensure that auxBits is freed
-    std::unique_ptr<uint8_t, decltype(&::free)> aux_bits_ptr(auxBits, ::free);
-    for (uint16_t t = 0; t < paramset.numMPCRounds; t++) {
-
-        if (!contains(
-              sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
-            //=================================================================
-            // We're given iSeed, have expanded the seeds, compute aux
-            // from scratch so we can compute Com[t]
-            for (uint16_t j = 0; j < last; j++) {
-                commit_c(C[t].hashes[j],
-                  getLeaf(seeds[t], j),
-                  nullptr,
-                  sig_data.mpc_pd_.salt_,
-                  t,
-                  j,
-                  &paramset);
-            }
-            mpc_class.compute_aux_tape_verify(tapes, sig_data, t);
-            mpc_class.get_aux_bits(auxBits, tapes, t);
-            commit_c(C[t].hashes[last],
-              getLeaf(seeds[t], last),
-              auxBits,
-              sig_data.mpc_pd_.salt_,
-              t,
-              (uint16_t)last,
+
+    //=========================================================================
+    // We're given all seeds and aux bits, except for the unopened
+    // party, we get their commitment
+    Mpc_proof_view const &proof = vs.proofs_[t];
+    size_t unopened = sig_data.mpc_pd_.challengeP_[indexOf(
+      sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t)];
+    for (uint16_t j = 0; j < last; j++) {
+        if (j != unopened) {
+            commit_c(C[t].hashes[j], getLeaf(seeds[t], j), NULL, salt, tr, j,
               &paramset);
-        } else {
-            //=================================================================
-            // We're given all seeds and aux bits, except for the unopened
-            // party, we get their commitment
-            size_t unopened = sig_data.mpc_pd_.challengeP_[indexOf(
-              sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t)];
-            for (uint16_t j = 0; j < last; j++) {
-                if (j != unopened) {
-                    commit_c(C[t].hashes[j],
-                      getLeaf(seeds[t], j),
-                      NULL,
-                      sig_data.mpc_pd_.salt_,
-                      t,
-                      j,
-                      &paramset);
-                }
-            }
-            //=================================================================
-            // For the unopened party we get the aux bits from the signature,
-            // provided the unopened party is not the last one.
-            if (last != unopened) {
-                commit_c(C[t].hashes[last], getLeaf(seeds[t], last),
-                  sig_data.proofs_[t]->aux_, sig_data.mpc_pd_.salt_, t,
-                  (uint16_t)last, &paramset);
-            }
-            memcpy(C[t].hashes[unopened], sig_data.proofs_[t]->C_,
-              paramset.digestSizeBytes);
         }
     }
+    //=========================================================================
+    // For the unopened party we get the aux bits from the signature,
+    // provided the unopened party is not the last one.
+    if (last != unopened) {
+        commit_c_aux(C[t].hashes[last], getLeaf(seeds[t], last), proof.aux_,
+          sig_data.proof_param_.aux_size_bytes_, salt, tr, last, &paramset);
+    }
+    memcpy(C[t].hashes[unopened], proof.C_, paramset.digestSizeBytes);
 
     //=========================================================================
-    // Commit to the commitments and views
-    Commitment_data2 commitments2;
-    if (!commitments2.is_initialised) {
-        std::cerr
-          << "Failed to initialise the data for commitments and views\n ";
+    // Commit to the commitments
+    commit_h(commitments2.Ch.hashes[t], &C[t], &paramset);
+
+    // When t is in C, we have everything we need to re-compute
+    // the view, as an honest signer would. We simulate the MPC with
+    // one fewer party; the unopned party's values are all set to
+    // zero. The masks are not used in verification, information
+    // passed in the signature is used instead (aux, msgs, masked
+    // plaintext, ...)
+    // The aux bits from the signature are set on the tapes as they are
+    // streamed, provided the unopened party is not the last one
+    tapes.hide_party(unopened);
+    stream.start(nullptr, &paramset);
+    stream.set_unopened(unopened, proof.msgs_);
+
+    int rv = mpc_class.simulate_and_verify_repetition(tapes, proof, stream,
+      expected_output, scratch.tmp_shares_.get(), t);
+    if (rv != 0) {
+        std::cerr << "Verification failed for round " << t
+                  << ", signature invalid\n";
         return EXIT_FAILURE;
     }
 
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        commit_h(commitments2.Ch.hashes[t], &C[t], &paramset);
-    }
+    //=========================================================================
+    // Commit to the view
+    stream.finish_view(
+      commitments2.Cv.hashes[t], proof.mpc_input(0), &paramset);
 
-    msgs_t *msgs = allocate_msgs(sig_data.proof_param_.aux_size_bytes_);
-    Msgs_ptr msgs_ptr(msgs, free_msgs);
-
-    shares_t *tmp_shares = allocateShares(paramset.stateSizeBits);
-    Shares_ptr tmp_shares_ptr(tmp_shares, freeShares);
-
-    for (size_t t = 0; t < paramset.numMPCRounds; t++) {
-        if (contains(
-              sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t)) {
-            // When t is in C, we have everything we need to re-compute
-            // the view, as an honest signer would. We simulate the MPC with
-            // one fewer party; the unopned party's values are all set to
-            // zero. The masks are not used in verification, information
-            // passed in the signature is used instead (aux, msgs, masked
-            // plaintext, ...)
-            size_t unopened = sig_data.mpc_pd_.challengeP_[indexOf(
-              sig_data.mpc_pd_.challengeC_, paramset.numOpenedRounds, t)];
-            if (unopened
-                != last) {// sig_data.proofs[t].aux is only set when P_t != N
-                mpc_class.set_aux_bits(tapes, sig_data, t);
-            }
-            memset(tapes[t].tape[unopened], 0, tape_size_bytes);
-            memcpy(msgs[t].msgs[unopened], sig_data.proofs_[t]->msgs_,
-              sig_data.proof_param_.aux_size_bytes_);
-            msgs[t].unopened = (int)unopened;
-
-            int rv = mpc_class.mpc_simulate_and_verify(
-              tapes, sig_data, &msgs[t], expected_output_ptr, tmp_shares, t);
-            if (rv != 0) {
-                std::cerr << "Verification failed for round " << t
-                          << ", signature invalid\n";
-                return EXIT_FAILURE;
-            }
-
-            mpc_class.commit_v_verify(commitments2, sig_data, &msgs[t], t);
-        } else {
-            commitments2.Cv.hashes[t] = NULL;
-        }
-    }
+    return EXIT_SUCCESS;
+}
+
+// Check the Merkle tree of the view commitments and the challenge hash, once
+// all of the repetitions have been checked
+template<typename MC>
+int verify_mpc_challenge(MC &mpc_class, Mpc_verification_state &vs,
+  uint8_t const *message_digest, uint8_t const *nonce) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    Signature_data const &sig_data = vs.sig_data_;
+    Commitment_data2 &commitments2 = vs.commitments2_;
 
     tree_t *treeCv = commitments2.treeCv;
     size_t missingLeavesSize = paramset.numMPCRounds - paramset.numOpenedRounds;
     uint16_t *missingLeaves =
       getMissingLeavesList(sig_data.mpc_pd_.challengeC_, &paramset);
-    ret = addMerkleNodes(treeCv, missingLeaves, missingLeavesSize,
+    int ret = addMerkleNodes(treeCv, missingLeaves, missingLeavesSize,
       sig_data.mpc_pd_.cvInfo_, sig_data.mpc_pd_.cvInfoLen_);
     free(missingLeaves);
     if (ret != 0) { return EXIT_FAILURE; }
@@ -258,16 +310,7 @@ int verify_mpc_signature(MC &mpc_class,
     if (ret != 0) { return EXIT_FAILURE; }
 
     // Compute the challenge hash
-    uint8_t *challengeHash =
-      static_cast<uint8_t *>(malloc(Mpc_parameters::challenge_hash_bytes_));
-    if (challengeHash == nullptr) {
-        std::cerr << "Unable to allocate memory for the challenge hash\n";
-        return EXIT_FAILURE;
-    }
-    // Ensure that challengeHash is freed
-    std::unique_ptr<uint8_t, decltype(&::free)> challenge_hash_ptr(
-      challengeHash, ::free);
-
+    uint8_t challengeHash[Mpc_parameters::challenge_hash_bytes_];
     mpc_class.calculate_hcp(
       challengeHash, sig_data, commitments2, message_digest, nonce);
 
@@ -282,4 +325,274 @@ int verify_mpc_signature(MC &mpc_class,
     return EXIT_SUCCESS;
 }
 
+// Verify a signature with the given verification state, taking the worker
+// scratch data from session
+template<typename MC, typename STATE>
+int verify_mpc_signature(MC &mpc_class,
+  const uint8_t *signature,
+  size_t signature_len,
+  uint8_t const *message_digest,
+  uint8_t const *nonce,
+  STATE const &expected_output,
+  Mpc_verification_state &vs,
+  Mpc_session &session) noexcept
+{
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    //=========================================================================
+    // Set up the structures and offsets
+    Tape_offset next_offset = 0;
+
+    next_offset = mpc_class.set_offsets(next_offset);
+
+    int ret = prepare_mpc_verification(
+      vs, signature, signature_len, &session.seed_trees());
+    if (ret != EXIT_SUCCESS) { return EXIT_FAILURE; }
+    mpc_memory_phase(Mpc_phase::verify_prepare);
+
+    //=========================================================================
+    // Check the repetitions, one block of repetitions for each worker
+    Mpc_thread_pool &pool = Mpc_thread_pool::instance();
+    Mpc_scratch_set *scratch = session.worker_scratch(pool.size(),
+      vs.sig_data_.proof_param_.aux_size_bytes_, mpc_class.max_step_bits(),
+      mpc_class.tape_window_bits());
+    if (scratch == nullptr) { return EXIT_FAILURE; }
+
+    pool.parallel_for(
+      paramset.numMPCRounds, [&](size_t begin, size_t end, size_t worker) {
+          for (size_t t = begin; t < end && vs.ok_; t++) {
+              if (verify_mpc_repetition(
+                    mpc_class, vs, expected_output, *(*scratch)[worker], t)
+                  != EXIT_SUCCESS) {
+                  vs.ok_ = false;
+              }
+          }
+      });
+    if (!vs.ok_) { return EXIT_FAILURE; }
+    mpc_memory_phase(Mpc_phase::verify_repetitions);
+
+    ret = verify_mpc_challenge(mpc_class, vs, message_digest, nonce);
+    mpc_memory_phase(Mpc_phase::verify_challenge);
+    return ret;
+}
+
+// Verify a signature. If in_place is set the proofs are not copied out of the
+// signature, see Mpc_verification_state. If a session is given its memory is
+// used, and it should be reset afterwards.
+template<typename MC, typename STATE>
+int verify_mpc_signature(MC &mpc_class,
+  const uint8_t *signature,
+  size_t signature_len,
+  uint8_t const *message_digest,
+  uint8_t const *nonce,
+  STATE const &expected_output,
+  bool in_place = false,
+  Mpc_session *session = nullptr) noexcept
+{
+    Mpc_session local_session;
+    if (session == nullptr) { session = &local_session; }
+
+    Mpc_memory_estimate me = mpc_arena_estimate(MC::mpc_param_, in_place);
+    if (!session->arena().reserve(me.verify_arena_bytes() + me.seeds_)) {
+        std::cerr << "Unable to allocate the verification state\n";
+        return EXIT_FAILURE;
+    }
+    Mpc_verification_state vs{ MC::mpc_param_, in_place, &session->arena() };
+    return verify_mpc_signature(mpc_class, signature, signature_len,
+      message_digest, nonce, expected_output, vs, *session);
+}
+
+// The verifier's counterpart of Mpc_signer_context: the signature data,
+// commitments and worker scratch data are allocated once for the SRL's
+// parameters and reused for each signature verified against it.
+class Mpc_verifier_context
+{
+  public:
+    Mpc_verifier_context() = default;
+    explicit Mpc_verifier_context(Mpc_param const &param) noexcept
+    {
+        reset(param);
+    }
+    Mpc_verifier_context(Mpc_verifier_context const &) = delete;
+    Mpc_verifier_context &operator=(Mpc_verifier_context const &) = delete;
+
+    // Ready the context for a signature with the given parameters, the
+    // buffers are only reallocated if the parameters have changed. Returns
+    // false if they can't be allocated.
+    bool reset(Mpc_param const &param) noexcept
+    {
+        if (vs_ && param == param_) {
+            vs_->reset();
+            session_.reset();
+            return is_initialised();
+        }
+        vs_.reset();
+        session_.reset();
+        arena_.release();
+        param_ = param;
+        if (!arena_.reserve(
+              mpc_arena_estimate(param_, false).verify_arena_bytes())) {
+            return false;
+        }
+        vs_.emplace(param_, false, &arena_, &session_.arena());
+        return is_initialised();
+    }
+    bool is_initialised() const noexcept
+    {
+        return vs_ && vs_->sig_data_.is_initialised_
+               && vs_->commitment_data1_.is_initialised
+               && vs_->commitments2_.is_initialised;
+    }
+
+    Mpc_param const &param() const noexcept { return param_; }
+    Mpc_verification_state &verification_state() noexcept { return *vs_; }
+    Mpc_session &session() noexcept { return session_; }
+
+  private:
+    Mpc_param param_{};
+    Mpc_arena arena_;// The data kept from one signature to the next
+    Mpc_session session_;// The seeds and the worker scratch data
+    std::optional<Mpc_verification_state> vs_;
+};
+
+// Verify a signature using a context. If in_place is set the signature must
+// be kept until this returns.
+template<typename MC, typename STATE>
+int verify_mpc_signature(MC &mpc_class,
+  const uint8_t *signature,
+  size_t signature_len,
+  uint8_t const *message_digest,
+  uint8_t const *nonce,
+  STATE const &expected_output,
+  Mpc_verifier_context &ctx,
+  bool in_place = false) noexcept
+{
+    if (!ctx.reset(MC::mpc_param_)) {
+        std::cerr << "Unable to set up the verifier context\n";
+        return EXIT_FAILURE;
+    }
+    ctx.verification_state().in_place_ = in_place;
+
+    return verify_mpc_signature(mpc_class, signature, signature_len,
+      message_digest, nonce, expected_output, ctx.verification_state(),
+      ctx.session());
+}
+
+// The streaming counterpart of generate_mpc_signature_streaming. The proofs
+// are read in place and the views are hashed as they are simulated, so the
+// working memory does not depend on the size of the SRL.
+template<typename MC, typename STATE>
+int verify_mpc_signature_streaming(MC &mpc_class,
+  const uint8_t *signature,
+  size_t signature_len,
+  uint8_t const *message_digest,
+  uint8_t const *nonce,
+  STATE const &expected_output,
+  Mpc_session *session = nullptr) noexcept
+{
+    return verify_mpc_signature(mpc_class, signature, signature_len,
+      message_digest, nonce, expected_output, true, session);
+}
+
+// One signature in a batch to be verified against a shared SRL. Each item has
+// its own mpc class object (holding the per-signature values) but they must
+// all be for the same list, and so have the same offsets.
+template<typename MC, typename STATE> struct Mpc_verify_item
+{
+    MC *mpc_class_{ nullptr };
+    uint8_t const *signature_{ nullptr };
+    size_t signature_len_{ 0 };
+    uint8_t const *message_digest_{ nullptr };
+    uint8_t const *nonce_{ nullptr };
+    STATE const *expected_output_{ nullptr };
+};
+
+// Verify a batch of signatures. The per-SRL setup and the per-worker scratch
+// data are shared and all of the repetition checks for all of the signatures
+// are scheduled on the one pool. A signature is dropped as soon as one of its
+// checks fails. Returns EXIT_SUCCESS or EXIT_FAILURE for each item.
+template<typename MC, typename STATE>
+std::vector<int> verify_mpc_signature_batch(
+  std::vector<Mpc_verify_item<MC, STATE>> const &items) noexcept
+{
+    size_t n_sigs = items.size();
+    std::vector<int> results(n_sigs, EXIT_FAILURE);
+    if (n_sigs == 0) { return results; }
+
+    paramset_t paramset;
+    get_param_set(get_picnic_parameter_set_id(), &paramset);
+
+    //=========================================================================
+    // The offsets only depend on the SRL
+    Tape_offset next_offset = items[0].mpc_class_->set_offsets(0);
+    for (size_t k = 1; k < n_sigs; ++k) {
+        if (items[k].mpc_class_->set_offsets(0) != next_offset) {
+            std::cerr << "verify_mpc_signature_batch: item " << k
+                      << " is not for the same SRL\n";
+            return results;
+        }
+    }
+
+    std::vector<std::unique_ptr<Mpc_verification_state>> states(n_sigs);
+    for (auto &vs : states) {
+        vs = std::make_unique<Mpc_verification_state>(MC::mpc_param_);
+    }
+
+    //=========================================================================
+    // Deserialise and set up the seeds, one signature per task. Signatures
+    // that fail here are rejected before any MPC work is done.
+    Mpc_thread_pool &pool = Mpc_thread_pool::instance();
+    pool.parallel_for(
+      n_sigs, [&](size_t begin, size_t end, [[maybe_unused]] size_t worker) {
+          for (size_t k = begin; k < end; ++k) {
+              if (prepare_mpc_verification(*states[k], items[k].signature_,
+                    items[k].signature_len_)
+                  != EXIT_SUCCESS) {
+                  states[k]->ok_ = false;
+              }
+          }
+      });
+
+    Mpc_scratch_set scratch;
+    if (!allocate_worker_scratch(scratch, pool.size(),
+          MC::mpc_param_.aux_size_bytes_,
+          items[0].mpc_class_->max_step_bits(),
+          items[0].mpc_class_->tape_window_bits())) {
+        return results;
+    }
+
+    //=========================================================================
+    // All of the K x T repetition checks
+    size_t n_rounds = paramset.numMPCRounds;
+    pool.parallel_for(
+      n_sigs * n_rounds, [&](size_t begin, size_t end, size_t worker) {
+          for (size_t i = begin; i < end; ++i) {
+              size_t k = i / n_rounds;
+              Mpc_verification_state &vs = *states[k];
+              if (!vs.ok_) { continue; }
+              if (verify_mpc_repetition(*items[k].mpc_class_, vs,
+                    *items[k].expected_output_, *scratch[worker],
+                    i % n_rounds)
+                  != EXIT_SUCCESS) {
+                  vs.ok_ = false;
+              }
+          }
+      });
+
+    //=========================================================================
+    // The challenge for each of the remaining signatures
+    pool.parallel_for(
+      n_sigs, [&](size_t begin, size_t end, [[maybe_unused]] size_t worker) {
+          for (size_t k = begin; k < end; ++k) {
+              if (!states[k]->ok_) { continue; }
+              results[k] = verify_mpc_challenge(*items[k].mpc_class_,
+                *states[k], items[k].message_digest_, items[k].nonce_);
+              states[k].reset();// Release the memory as soon as possible
+          }
+      });
+
+    return results;
+}
+
 #endif
@@ -43,6 +43,8 @@
 
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <array>
 #include <vector>
 
 #include "picnic.h"
@@ -55,6 +57,11 @@ extern "C" {
 #include "Hbgs_param.h"
 #include "Mpc_parameters.h"
 #include "Mpc_utils.h"
+#include "Mpc_streaming_tapes.h"
+#include "Mpc_repetition_stream.h"
+#include "Mpc_arena.h"
+#include "Mpc_seed_trees.h"
+#include "Lowmc64.h"
 
 enum mpc_wd_print_mask : uint8_t {
     aux_bits = 1,
@@ -64,44 +71,155 @@ enum mpc_wd_print_mask : uint8_t {
     outputs = 16
 };
 
+// One kind of state (the inputs, MPC inputs or outputs) for every repetition,
+// held as [t][entry][state] so that the states a repetition works on are
+// together and are read and written in order
+class Mpc_state_slab
+{
+  public:
+    static constexpr size_t state_bytes_ = lowmc_state_words64_bytes;
+
+    Mpc_state_slab() = default;
+    Mpc_state_slab(Mpc_state_slab const &) = delete;
+    Mpc_state_slab &operator=(Mpc_state_slab const &) = delete;
+
+    bool allocate(size_t n_entries, Mpc_arena *arena) noexcept;
+    void release(Mpc_arena *arena) noexcept;
+
+    size_t size() const noexcept { return n_entries_; }
+    // The states for repetition t, one after the other
+    uint8_t *repetition(size_t t) const noexcept
+    {
+        return states_ + t * n_entries_ * state_bytes_;
+    }
+    uint8_t *state(size_t entry, size_t t) const noexcept
+    {
+        return repetition(t) + entry * state_bytes_;
+    }
+
+  private:
+    uint8_t *states_{ nullptr };
+    size_t n_entries_{ 0 };
+};
+
 class Mpc_working_data
 {
   public:
     Mpc_working_data() = delete;
-    Mpc_working_data(Mpc_param const &param) noexcept;
+    // If an arena is given everything is allocated from it
+    Mpc_working_data(Mpc_param const &param, Mpc_arena *arena = nullptr) noexcept;
+    Mpc_working_data(Mpc_working_data const &) = delete;
+    Mpc_working_data &operator=(Mpc_working_data const &) = delete;
     ~Mpc_working_data();
 
     void print_working_data(std::ostream &os, mpc_wd_print_mask pm);
+    // Ready the working data for another signature
+    void reset() noexcept;
+    uint8_t *aux_bits(size_t t) const noexcept
+    {
+        return aux_bits_ + t * aux_size_bytes_;
+    }
 
     bool is_initialised_{ false };
     size_t aux_size_bytes_{ 0 };
     uint8_t *aux_bits_{ nullptr };// saved aux bits for each round
     msgs_t *msgs_{ nullptr };// One set of each party's messages for each round
-    std::vector<inputs_t> mpc_inputs_;// One of each input per MPC round
-    std::vector<inputs_t> inputs_;// One of each input per MPC round
-    std::vector<inputs_t> outputs_;// One of each output per MPC round
+    Mpc_state_slab mpc_inputs_;// One of each input per MPC round
+    Mpc_state_slab inputs_;// One of each input per MPC round
+    Mpc_state_slab outputs_;// One of each output per MPC round
+
+  private:
+    Mpc_arena *arena_{ nullptr };
 };
 
 class Commitment_data1
 {
   public:
-    Commitment_data1() noexcept;
+    explicit Commitment_data1(Mpc_arena *arena = nullptr) noexcept;
+    Commitment_data1(Commitment_data1 const &) = delete;
+    Commitment_data1 &operator=(Commitment_data1 const &) = delete;
     ~Commitment_data1();
 
     bool is_initialised{ false };
     commitments_t *C_{ nullptr };
+
+  private:
+    Mpc_arena *arena_{ nullptr };
 };
 
 class Commitment_data2
 {
   public:
-    Commitment_data2() noexcept;
+    explicit Commitment_data2(Mpc_arena *arena = nullptr) noexcept;
+    Commitment_data2(Commitment_data2 const &) = delete;
+    Commitment_data2 &operator=(Commitment_data2 const &) = delete;
     ~Commitment_data2();
+    // Ready the commitments and Merkle tree for another signature
+    void reset() noexcept;
 
     bool is_initialised{ false };
     commitments_t Ch = { nullptr, 0 };
     commitments_t Cv = { nullptr, 0 };
     tree_t *treeCv = nullptr;
+
+  private:
+    Mpc_arena *arena_{ nullptr };
+};
+
+// Scratch space for one worker, shared by all of the repetitions (and
+// signatures) that the worker processes. The random tapes are streamed, so
+// only a window of the tapes (tape_window_bits) is held at a time. In the same
+// way the aux bits and messages are committed to, or written to a proof, one
+// step (at most max_step_bits) at a time.
+class Mpc_worker_scratch
+{
+  public:
+    Mpc_worker_scratch() = delete;
+    Mpc_worker_scratch(size_t aux_size_bytes, size_t max_step_bits,
+      Tape_offset tape_window_bits) noexcept;
+
+    bool is_initialised_{ false };
+    std::unique_ptr<shares_t, decltype(&::freeShares)> tmp_shares_{ nullptr,
+        freeShares };
+    std::unique_ptr<Mpc_streaming_tapes> tapes_{ nullptr };
+    std::unique_ptr<Mpc_commitment_stream> commitment_stream_{ nullptr };
+    std::unique_ptr<Mpc_proof_stream> proof_stream_{ nullptr };
+};
+
+using Mpc_scratch_set = std::vector<std::unique_ptr<Mpc_worker_scratch>>;
+
+// Allocate one set of scratch data for each worker in the pool
+bool allocate_worker_scratch(Mpc_scratch_set &scratch, size_t n_workers,
+  size_t aux_size_bytes, size_t max_step_bits,
+  Tape_offset tape_window_bits) noexcept;
+
+// The memory for a series of signatures (or verifications) made one after the
+// other on the same thread, as in a long-running signer. The data for each
+// signature comes from the arena and the worker scratch data is kept for as
+// long as the sizes (set by the SRL) stay the same. reset() must be called
+// once the data for a signature is no longer needed, the memory is then
+// reused without going back to the system. The party seed trees are kept in
+// a pool of their own, which is reused as it is.
+class Mpc_session
+{
+  public:
+    Mpc_session() = default;
+    Mpc_session(Mpc_session const &) = delete;
+    Mpc_session &operator=(Mpc_session const &) = delete;
+
+    Mpc_arena &arena() noexcept { return arena_; }
+    // The party seed trees, kept from one signature to the next
+    Mpc_tree_pool &seed_trees() noexcept { return seed_trees_; }
+    // Returns nullptr if the scratch data can't be allocated
+    Mpc_scratch_set *worker_scratch(size_t n_workers, size_t aux_size_bytes,
+      size_t max_step_bits, Tape_offset tape_window_bits) noexcept;
+    void reset() noexcept { arena_.reset(); }
+
+  private:
+    Mpc_arena arena_;
+    Mpc_tree_pool seed_trees_;
+    Mpc_scratch_set scratch_;
+    std::array<size_t, 4> scratch_sizes_{};
 };
 
 #endif